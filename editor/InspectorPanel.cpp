@@ -48,6 +48,11 @@ void InspectorPanel::DrawEntityInspector(std::shared_ptr<Scene> scene, entt::ent
     DrawComponent<RigidBodyComponent>("Rigid Body", scene, entity);
     DrawComponent<BoxColliderComponent>("Box Collider", scene, entity);
     DrawComponent<SphereColliderComponent>("Sphere Collider", scene, entity);
+    DrawComponent<CapsuleColliderComponent>("Capsule Collider", scene, entity);
+    DrawComponent<CylinderColliderComponent>("Cylinder Collider", scene, entity);
+    DrawComponent<MeshColliderComponent>("Mesh Collider", scene, entity);
+    DrawComponent<ConvexColliderComponent>("Convex Collider", scene, entity);
+    DrawComponent<CompoundColliderComponent>("Compound Collider", scene, entity);
     DrawComponent<DistanceJointComponent>("Distance Joint", scene, entity);
 
     ImGui::Separator();
@@ -113,6 +118,9 @@ void InspectorPanel::DrawComponent(const char* name,
             ImGui::DragFloat("Restitution", &component.Restitution, 0.01f);
             ImGui::DragFloat("Friction", &component.Friction, 0.01f);
             ImGui::Checkbox("Is static", &component.IsStatic);
+            ImGui::Checkbox("Is bullet", &component.IsBullet);
+            ImGui::InputScalar("Collision category", ImGuiDataType_U32, &component.CollisionCategory, nullptr, nullptr, "%08X", ImGuiInputTextFlags_CharsHexadecimal);
+            ImGui::InputScalar("Collision mask", ImGuiDataType_U32, &component.CollisionMask, nullptr, nullptr, "%08X", ImGuiInputTextFlags_CharsHexadecimal);
         }
 
         if constexpr (std::is_same_v<T, BoxColliderComponent>)
@@ -125,6 +133,62 @@ void InspectorPanel::DrawComponent(const char* name,
             ImGui::DragFloat("Radius", &component.Radius, 0.1f);
         }
 
+        if constexpr (std::is_same_v<T, CapsuleColliderComponent> || std::is_same_v<T, CylinderColliderComponent>)
+        {
+            ImGui::DragFloat("Radius", &component.Radius, 0.1f);
+            ImGui::DragFloat("Half Height", &component.HalfHeight, 0.1f);
+        }
+
+        if constexpr (std::is_same_v<T, MeshColliderComponent> || std::is_same_v<T, ConvexColliderComponent>)
+        {
+            if (component.Mesh == 0)
+                ImGui::Text("Mesh: from Mesh Render");
+            else
+                ImGui::Text("Mesh: %s", component.Mesh.string().c_str());
+        }
+
+        if constexpr (std::is_same_v<T, CompoundColliderComponent>)
+        {
+            static const char* types[] = { "Sphere", "Box", "Capsule", "Cylinder" };
+
+            int removeChild = -1;
+            for (int i = 0; i < (int)component.Children.size(); i++)
+            {
+                auto& child = component.Children[i];
+                ImGui::PushID(i);
+                ImGui::Separator();
+
+                int type = (int)child.Type;
+                if (ImGui::Combo("Type", &type, types, IM_ARRAYSIZE(types)))
+                    child.Type = (ColliderType)type;
+
+                ImGui::DragFloat3("Translation", &child.Translation.x, 0.1f);
+
+                glm::vec3 euler = glm::degrees(glm::eulerAngles(child.Rotation));
+                if (ImGui::DragFloat3("Rotation", &euler.x, 0.1f))
+                    child.Rotation = glm::quat(glm::radians(euler));
+
+                if (child.Type == ColliderType::Box)
+                    ImGui::DragFloat3("Half Extents", &child.HalfExtents.x, 0.1f);
+                else
+                    ImGui::DragFloat("Radius", &child.Radius, 0.1f);
+
+                if (child.Type == ColliderType::Capsule || child.Type == ColliderType::Cylinder)
+                    ImGui::DragFloat("Half Height", &child.HalfHeight, 0.1f);
+
+                if (ImGui::Button("Remove"))
+                    removeChild = i;
+
+                ImGui::PopID();
+            }
+
+            if (removeChild >= 0)
+                component.Children.erase(component.Children.begin() + removeChild);
+
+            if (ImGui::Button("Add Child"))
+                component.Children.emplace_back();
+        }
+
         if constexpr (std::is_same_v<T, DistanceJointComponent>)
         {
             auto& comp = component;
@@ -134,6 +198,7 @@ void InspectorPanel::DrawComponent(const char* name,
             ImGui::DragFloat3("Local Anchor A", &comp.LocalAnchorA.x, 0.1f);
             ImGui::DragFloat3("Local Anchor B", &comp.LocalAnchorB.x, 0.1f);
             ImGui::Text("Target Length: %f", comp.TargetLength);
+            ImGui::Checkbox("Collide connected", &comp.CollideConnected);
 
             if (registry.valid(comp.ConnectedEntity))
             {
@@ -178,6 +243,36 @@ void InspectorPanel::DrawAddComponentPopup(std::shared_ptr<Scene> scene, entt::e
                 registry.emplace<SphereColliderComponent>(entity);
         }
 
+        if (!registry.any_of<CapsuleColliderComponent>(entity))
+        {
+            if (ImGui::MenuItem("Capsule Collider"))
+                registry.emplace<CapsuleColliderComponent>(entity);
+        }
+
+        if (!registry.any_of<CylinderColliderComponent>(entity))
+        {
+            if (ImGui::MenuItem("Cylinder Collider"))
+                registry.emplace<CylinderColliderComponent>(entity);
+        }
+
+        if (!registry.any_of<MeshColliderComponent>(entity))
+        {
+            if (ImGui::MenuItem("Mesh Collider"))
+                registry.emplace<MeshColliderComponent>(entity);
+        }
+
+        if (!registry.any_of<ConvexColliderComponent>(entity))
+        {
+            if (ImGui::MenuItem("Convex Collider"))
+                registry.emplace<ConvexColliderComponent>(entity);
+        }
+
+        if (!registry.any_of<CompoundColliderComponent>(entity))
+        {
+            if (ImGui::MenuItem("Compound Collider"))
+                registry.emplace<CompoundColliderComponent>(entity);
+        }
+
         if (!registry.any_of<DistanceJointComponent>(entity))
         {
             if (ImGui::MenuItem("Distance Joint"))
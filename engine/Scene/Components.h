@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -10,6 +11,7 @@
 #include "render/Camera.h"
 #include "render/LightType.h"
 #include "physics/AABB.h"
+#include "physics/BodyHandle.h"
 
 // Core
 struct IDComponent
@@ -78,8 +80,13 @@ struct RigidBodyComponent
     float Restitution = 0.2f;
     float Friction = 0.6f;
     bool IsStatic = false;
+    bool IsBullet = false;
+    // Collides with another body only if each one's category shares a bit
+    // with the other's mask.
+    uint32_t CollisionCategory = 1;
+    uint32_t CollisionMask = 0xFFFFFFFF;
 
-    void* RuntimeBody = nullptr;
+    BodyHandle RuntimeBody;
     // glm::vec3 Velocity{ 0 };
     // glm::vec3 AngularVelocity{ 0 };
 };
@@ -89,6 +96,8 @@ enum class ColliderType
 {
     Sphere,
     Box,
+    Capsule,
+    Cylinder,
     Convex
 };
 
@@ -102,6 +111,51 @@ struct BoxColliderComponent
     glm::vec3 HalfExtents{ 0.5f };
 };
 
+// Capsules and cylinders run along the entity's local Y axis.
+struct CapsuleColliderComponent
+{
+    float Radius = 0.5f;
+    float HalfHeight = 0.5f; // of the straight part, without the caps
+};
+
+struct CylinderColliderComponent
+{
+    float Radius = 0.5f;
+    float HalfHeight = 0.5f;
+};
+
+// Static collider made of a mesh asset's triangles.
+struct MeshColliderComponent
+{
+    AssetHandle Mesh = 0; // 0 uses the MeshRenderComponent's mesh
+};
+
+// Collider made of the convex hull of a mesh asset's vertices.
+struct ConvexColliderComponent
+{
+    AssetHandle Mesh = 0; // 0 uses the MeshRenderComponent's mesh
+};
+
+// One primitive of a compound collider, placed in the entity's local frame.
+struct CompoundColliderChild
+{
+    ColliderType Type = ColliderType::Box; // Sphere, Box, Capsule or Cylinder
+
+    glm::vec3 Translation{ 0.0f };
+    glm::quat Rotation = glm::identity<glm::quat>();
+
+    glm::vec3 HalfExtents{ 0.5f }; // box
+    float Radius = 0.5f;           // sphere, capsule, cylinder
+    float HalfHeight = 0.5f;       // capsule, cylinder
+};
+
+// Several primitives moving as one rigid body, e.g. the seat, back and
+// legs of a chair. The entity's origin is the body's center of mass.
+struct CompoundColliderComponent
+{
+    std::vector<CompoundColliderChild> Children;
+};
+
 struct DistanceJointComponent
 {
     entt::entity ConnectedEntity;
@@ -110,6 +164,7 @@ struct DistanceJointComponent
     glm::vec3 LocalAnchorB{ 0.0f };
 
     float TargetLength = 0.0f;
+    bool CollideConnected = true;
 };
 
 // struct HingeJointComponent
@@ -113,6 +113,11 @@ std::shared_ptr<Scene> Scene::Copy() const
         RigidBodyComponent,
         BoxColliderComponent,
         SphereColliderComponent,
+        CapsuleColliderComponent,
+        CylinderColliderComponent,
+        MeshColliderComponent,
+        ConvexColliderComponent,
+        CompoundColliderComponent,
         LightComponent,
         DistanceJointComponent
     >(newScene->m_Registry, m_Registry, entityMap);
@@ -2,6 +2,8 @@
 
 #include "Components.h"
 #include "project/Project.h"
+#include "asset/AssetManager.h"
+#include "render/Model.h"
 
 #include <iostream>
 
@@ -106,25 +108,80 @@ void SceneController::InitializePhysicsFromScene()
             auto& sphere = m_RuntimeScene->GetComponent<SphereColliderComponent>(entity);
             shape = new SphereShape(sphere.Radius);
         }
+        else if (m_RuntimeScene->HasComponent<CapsuleColliderComponent>(entity))
+        {
+            auto& capsule = m_RuntimeScene->GetComponent<CapsuleColliderComponent>(entity);
+            shape = new CapsuleShape(capsule.Radius, capsule.HalfHeight);
+        }
+        else if (m_RuntimeScene->HasComponent<CylinderColliderComponent>(entity))
+        {
+            auto& cylinder = m_RuntimeScene->GetComponent<CylinderColliderComponent>(entity);
+            shape = new CylinderShape(cylinder.Radius, cylinder.HalfHeight);
+        }
+        else if (m_RuntimeScene->HasComponent<MeshColliderComponent>(entity))
+        {
+            auto& collider = m_RuntimeScene->GetComponent<MeshColliderComponent>(entity);
+            AssetHandle handle = collider.Mesh;
+            if (handle == 0 && m_RuntimeScene->HasComponent<MeshRenderComponent>(entity))
+                handle = m_RuntimeScene->GetComponent<MeshRenderComponent>(entity).Mesh;
+
+            if (Project::GetActive()->GetAssetManager()->IsAssetHandleValid(handle))
+            {
+                auto mesh = AssetManager::GetAsset<MeshAsset>(handle)->MeshData;
+                shape = new TriangleMeshShape(mesh->ReadPositions(), mesh->ReadIndices(), tr.Scale);
+            }
+        }
+        else if (m_RuntimeScene->HasComponent<ConvexColliderComponent>(entity))
+        {
+            auto& collider = m_RuntimeScene->GetComponent<ConvexColliderComponent>(entity);
+            AssetHandle handle = collider.Mesh;
+            if (handle == 0 && m_RuntimeScene->HasComponent<MeshRenderComponent>(entity))
+                handle = m_RuntimeScene->GetComponent<MeshRenderComponent>(entity).Mesh;
+
+            if (Project::GetActive()->GetAssetManager()->IsAssetHandleValid(handle))
+                shape = new ConvexHullShape(AssetManager::GetAsset<MeshAsset>(handle)->GetHullVertices(), tr.Scale);
+        }
+        else if (m_RuntimeScene->HasComponent<CompoundColliderComponent>(entity))
+        {
+            auto& compound = m_RuntimeScene->GetComponent<CompoundColliderComponent>(entity);
+            std::vector<CompoundShape::Child> children;
+            for (auto& child : compound.Children)
+            {
+                Shape* childShape = nullptr;
+                switch (child.Type)
+                {
+                case ColliderType::Sphere: childShape = new SphereShape(child.Radius); break;
+                case ColliderType::Box: childShape = new BoxShape(child.HalfExtents); break;
+                case ColliderType::Capsule: childShape = new CapsuleShape(child.Radius, child.HalfHeight); break;
+                case ColliderType::Cylinder: childShape = new CylinderShape(child.Radius, child.HalfHeight); break;
+                default: break;
+                }
+
+                if (childShape)
+                    children.push_back({ childShape, child.Translation, child.Rotation });
+            }
+
+            if (!children.empty())
+                shape = new CompoundShape(children);
+        }
 
         if (!shape)
             continue;
 
-        float mass = rb.IsStatic ? 0.0f : rb.Mass;
-
-        RigidBody* body = m_PhysicsWorld->CreateBody(
-            tr.Translation,
-            shape,
-            rb.IsStatic ? BodyType::Static : BodyType::Dynamic,
-            mass
-        );
-
-        body->Orientation = tr.Rotation;
-        body->Material.Restitution = rb.Restitution;
-        body->Material.Friction = rb.Friction;
-        body->ID = static_cast<uint32_t>(entity);
-
-        rb.RuntimeBody = body;
+        BodyDesc desc;
+        desc.Position = tr.Translation;
+        desc.Orientation = tr.Rotation;
+        desc.CollisionShape = shape;
+        desc.Type = rb.IsStatic ? BodyType::Static : BodyType::Dynamic;
+        desc.Mass = rb.IsStatic ? 0.0f : rb.Mass;
+        desc.Material.Restitution = rb.Restitution;
+        desc.Material.Friction = rb.Friction;
+        desc.IsBullet = rb.IsBullet;
+        desc.CollisionCategory = rb.CollisionCategory;
+        desc.CollisionMask = rb.CollisionMask;
+        desc.ID = static_cast<uint32_t>(entity);
+
+        rb.RuntimeBody = m_PhysicsWorld->CreateBody(desc);
     }
 
     // ----------- Create Runtime Constraints -----------
@@ -141,35 +198,23 @@ void SceneController::InitializePhysicsFromScene()
         if (!rbB)
             continue;
 
-        if (!rbA.RuntimeBody || !rbB->RuntimeBody)
+        if (!m_PhysicsWorld->IsValid(rbA.RuntimeBody) || !m_PhysicsWorld->IsValid(rbB->RuntimeBody))
             continue;
 
-        DistanceJoint* j = m_PhysicsWorld->AddDistanceJoint(
-            (RigidBody*)rbA.RuntimeBody,
-            (RigidBody*)rbB->RuntimeBody,
+        m_PhysicsWorld->AddDistanceJoint(
+            rbA.RuntimeBody,
+            rbB->RuntimeBody,
             joint.LocalAnchorA,
-            joint.LocalAnchorB
+            joint.LocalAnchorB,
+            joint.TargetLength,
+            joint.CollideConnected
         );
-
-        j->TargetLength = joint.TargetLength;
     }
 }
 
 void SceneController::RecordFrame()
 {
-    PhysicsSnapshot snapshot;
-
-    for (auto* body : m_PhysicsWorld->Bodies)
-    {
-        snapshot[body->ID] = {
-            body->Position,
-            body->Orientation,
-            body->LinearVelocity,
-            body->AngularVelocity
-        };
-    }
-
-    m_History.push_back(std::move(snapshot));
+    m_History.push_back(m_PhysicsWorld->GetState());
     m_CurrentFrameIndex = (int)m_History.size() - 1;
 
     if (m_History.size() > s_MaxHistoryFrames)
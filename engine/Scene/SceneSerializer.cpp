@@ -81,6 +81,31 @@ inline LightType LightTypeFromString(const std::string& type)
     return LightType::None;
 }
 
+inline std::string ColliderTypeToString(ColliderType type)
+{
+    switch (type)
+    {
+    case ColliderType::Sphere: return "Sphere";
+    case ColliderType::Box: return "Box";
+    case ColliderType::Capsule: return "Capsule";
+    case ColliderType::Cylinder: return "Cylinder";
+    case ColliderType::Convex: return "Convex";
+    default:
+        return "<Invalid>";
+    }
+}
+
+inline ColliderType ColliderTypeFromString(const std::string& type)
+{
+    if (type == "Sphere") return ColliderType::Sphere;
+    if (type == "Box") return ColliderType::Box;
+    if (type == "Capsule") return ColliderType::Capsule;
+    if (type == "Cylinder") return ColliderType::Cylinder;
+    if (type == "Convex") return ColliderType::Convex;
+
+    return ColliderType::Box;
+}
+
 SceneSerializer::SceneSerializer(const std::shared_ptr<Scene>& scene)
     : m_Scene(scene)
 {
@@ -134,6 +159,9 @@ bool SceneSerializer::Serialize(const std::filesystem::path& filepath)
             e["RigidBodyComponent"] = {
                 { "Mass", rb.Mass },
                 { "IsStatic", rb.IsStatic },
+                { "IsBullet", rb.IsBullet },
+                { "CollisionCategory", rb.CollisionCategory },
+                { "CollisionMask", rb.CollisionMask },
                 // { "Velocity", rb.Velocity },
                 // { "AngularVelocity", rb.AngularVelocity },
                 { "Restitution", rb.Restitution },
@@ -153,6 +181,54 @@ bool SceneSerializer::Serialize(const std::filesystem::path& filepath)
             e["SphereColliderComponent"]["Radius"] = sc.Radius;
         }
 
+        if (entity.HasComponent<CapsuleColliderComponent>())
+        {
+            auto& cc = entity.GetComponent<CapsuleColliderComponent>();
+            e["CapsuleColliderComponent"] = {
+                { "Radius", cc.Radius },
+                { "HalfHeight", cc.HalfHeight }
+            };
+        }
+
+        if (entity.HasComponent<CylinderColliderComponent>())
+        {
+            auto& cc = entity.GetComponent<CylinderColliderComponent>();
+            e["CylinderColliderComponent"] = {
+                { "Radius", cc.Radius },
+                { "HalfHeight", cc.HalfHeight }
+            };
+        }
+
+        if (entity.HasComponent<MeshColliderComponent>())
+        {
+            auto& mcc = entity.GetComponent<MeshColliderComponent>();
+            e["MeshColliderComponent"]["Mesh"] = mcc.Mesh;
+        }
+
+        if (entity.HasComponent<ConvexColliderComponent>())
+        {
+            auto& ccc = entity.GetComponent<ConvexColliderComponent>();
+            e["ConvexColliderComponent"]["Mesh"] = ccc.Mesh;
+        }
+
+        if (entity.HasComponent<CompoundColliderComponent>())
+        {
+            auto& cc = entity.GetComponent<CompoundColliderComponent>();
+            json children = json::array();
+            for (auto& child : cc.Children)
+            {
+                children.push_back({
+                    { "Type", ColliderTypeToString(child.Type) },
+                    { "Translation", child.Translation },
+                    { "Rotation", child.Rotation },
+                    { "HalfExtents", child.HalfExtents },
+                    { "Radius", child.Radius },
+                    { "HalfHeight", child.HalfHeight }
+                });
+            }
+            e["CompoundColliderComponent"]["Children"] = children;
+        }
+
         if (entity.HasComponent<LightComponent>())
         {
             auto& lc = entity.GetComponent<LightComponent>();
@@ -216,6 +292,9 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
             auto& rb = entity.AddComponent<RigidBodyComponent>();
             rb.Mass = e["RigidBodyComponent"]["Mass"];
             rb.IsStatic = e["RigidBodyComponent"]["IsStatic"];
+            rb.IsBullet = e["RigidBodyComponent"].value("IsBullet", false);
+            rb.CollisionCategory = e["RigidBodyComponent"].value("CollisionCategory", 1u);
+            rb.CollisionMask = e["RigidBodyComponent"].value("CollisionMask", 0xFFFFFFFFu);
             // rb.Velocity = e["RigidBodyComponent"]["Velocity"];
             // rb.AngularVelocity = e["RigidBodyComponent"]["AngularVelocity"];
             rb.Restitution = e["RigidBodyComponent"]["Restitution"];
@@ -234,6 +313,48 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
             sc.Radius = e["SphereColliderComponent"]["Radius"];
         }
 
+        if (e.contains("CapsuleColliderComponent"))
+        {
+            auto& cc = entity.AddComponent<CapsuleColliderComponent>();
+            cc.Radius = e["CapsuleColliderComponent"]["Radius"];
+            cc.HalfHeight = e["CapsuleColliderComponent"]["HalfHeight"];
+        }
+
+        if (e.contains("CylinderColliderComponent"))
+        {
+            auto& cc = entity.AddComponent<CylinderColliderComponent>();
+            cc.Radius = e["CylinderColliderComponent"]["Radius"];
+            cc.HalfHeight = e["CylinderColliderComponent"]["HalfHeight"];
+        }
+
+        if (e.contains("MeshColliderComponent"))
+        {
+            auto& mcc = entity.AddComponent<MeshColliderComponent>();
+            mcc.Mesh = e["MeshColliderComponent"]["Mesh"];
+        }
+
+        if (e.contains("ConvexColliderComponent"))
+        {
+            auto& ccc = entity.AddComponent<ConvexColliderComponent>();
+            ccc.Mesh = e["ConvexColliderComponent"]["Mesh"];
+        }
+
+        if (e.contains("CompoundColliderComponent"))
+        {
+            auto& cc = entity.AddComponent<CompoundColliderComponent>();
+            for (auto& c : e["CompoundColliderComponent"]["Children"])
+            {
+                CompoundColliderChild child;
+                child.Type = ColliderTypeFromString(c["Type"]);
+                child.Translation = c["Translation"];
+                child.Rotation = c["Rotation"];
+                child.HalfExtents = c["HalfExtents"];
+                child.Radius = c["Radius"];
+                child.HalfHeight = c["HalfHeight"];
+                cc.Children.push_back(child);
+            }
+        }
+
         if (e.contains("LightComponent"))
         {
             std::cout << "contains light\n";
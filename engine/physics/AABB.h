@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cfloat>
 #include <glm/glm.hpp>
 
 // struct AABB
@@ -29,4 +30,21 @@ struct AABB {
     }
     glm::vec3 Center()  const { return (Min + Max) * 0.5f; }
     glm::vec3 Extents() const { return (Max - Min) * 0.5f; }
+
+    bool Contains(const AABB& o) const {
+        return Min.x <= o.Min.x && Min.y <= o.Min.y && Min.z <= o.Min.z &&
+            o.Max.x <= Max.x && o.Max.y <= Max.y && o.Max.z <= Max.z;
+    }
+    float SurfaceArea() const {
+        glm::vec3 d = Max - Min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    // Bounds of this box rotated by R, then moved by t.
+    AABB Transformed(const glm::mat3& R, const glm::vec3& t) const {
+        glm::vec3 c = R * Center() + t, e = Extents();
+        glm::vec3 we = glm::abs(R[0]) * e.x + glm::abs(R[1]) * e.y + glm::abs(R[2]) * e.z;
+        return { c - we, c + we };
+    }
+    AABB Expanded(float r) const { return { Min - glm::vec3(r), Max + glm::vec3(r) }; }
+    static AABB Union(const AABB& a, const AABB& b) { return { glm::min(a.Min, b.Min), glm::max(a.Max, b.Max) }; }
 };
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Counts global operator new calls so profiling builds can check that
+// stepping a settled world does not touch the heap. Building with
+// PHYSIM_COUNT_ALLOCATIONS replaces the global operator new (in
+// PhysicsWorld.cpp) with one that increments Count; otherwise it stays 0.
+struct AllocationCounter {
+#if defined(PHYSIM_COUNT_ALLOCATIONS)
+    static constexpr bool Enabled = true;
+#else
+    static constexpr bool Enabled = false;
+#endif
+    static inline std::atomic<uint64_t> Count{ 0 };
+};
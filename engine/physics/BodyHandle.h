@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// Stable reference to a body owned by a PhysicsWorld. Index selects a slot in
+// the body store; Generation is bumped every time the slot is freed, so a
+// handle to a removed body never aliases whatever reuses the slot.
+struct BodyHandle {
+    static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+    uint32_t Index = InvalidIndex;
+    uint32_t Generation = 0;
+
+    bool IsValid() const { return Index != InvalidIndex; }
+    bool operator==(const BodyHandle&) const = default;
+};
+
+// Pairs are stored as handles so they survive body removal and the awake/asleep
+// reordering of dense indices; stale pairs are dropped when they are next visited.
+struct BodyPair { BodyHandle A, B; };
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "BodyStore.h"
+#include "SimdFloat.h"
+
+// Per-body stages of a substep, run on FloatW::Width dynamic bodies at a
+// time: each batch is gathered into lanes, updated lane-parallel and
+// scattered back. A stage visits the bodies idx(0) .. idx(count - 1), so it
+// runs as well over a chunk of the dense range as over an island's body
+// list, and skips the bodies that are not dynamic. Stages never allocate and
+// only write the bodies they visit, so disjoint chunks may run on any thread.
+
+// Calls kernel(lanes, n) for every batch of up to FloatW::Width dynamic
+// bodies. Unused lanes of the last batch repeat its first body, so kernels
+// may load all lanes but must store only the first n.
+template<typename Index, typename Kernel>
+inline void ForEachBodyBatch(const BodyStore& S, uint32_t count, Index idx, Kernel&& kernel) {
+    constexpr int W = FloatW::Width;
+    uint32_t lanes[W]; int n = 0;
+    for (uint32_t k = 0; k < count; ++k) {
+        const uint32_t i = idx(k);
+        if (!S.Info[i].IsDynamic()) continue;
+        lanes[n++] = i;
+        if (n == W) { kernel(lanes, n); n = 0; }
+    }
+    if (n == 0) return;
+    for (int l = n; l < W; ++l) lanes[l] = lanes[0];
+    kernel(lanes, n);
+}
+
+struct Mat3W {
+    Vec3W C[3];   // columns, as in glm
+
+    void Set(int lane, const glm::mat3& m) { C[0].Set(lane, m[0]); C[1].Set(lane, m[1]); C[2].Set(lane, m[2]); }
+    glm::mat3 Get(int lane) const { return { C[0].Get(lane), C[1].Get(lane), C[2].Get(lane) }; }
+
+    friend Vec3W operator*(const Mat3W& m, const Vec3W& v) {
+        return { m.C[0].X * v.X + m.C[1].X * v.Y + m.C[2].X * v.Z,
+                 m.C[0].Y * v.X + m.C[1].Y * v.Y + m.C[2].Y * v.Z,
+                 m.C[0].Z * v.X + m.C[1].Z * v.Y + m.C[2].Z * v.Z };
+    }
+    friend Mat3W operator*(const Mat3W& a, const Mat3W& b) { return { { a * b.C[0], a * b.C[1], a * b.C[2] } }; }
+    Mat3W Transposed() const {
+        return { { { C[0].X, C[1].X, C[2].X }, { C[0].Y, C[1].Y, C[2].Y }, { C[0].Z, C[1].Z, C[2].Z } } };
+    }
+};
+
+struct QuatW {
+    FloatW X, Y, Z, W;
+
+    void Set(int lane, const glm::quat& q) { X[lane] = q.x; Y[lane] = q.y; Z[lane] = q.z; W[lane] = q.w; }
+    glm::quat Get(int lane) const { return { W[lane], X[lane], Y[lane], Z[lane] }; }
+
+    // The rotation matrix of a unit quaternion, as glm::mat3_cast.
+    Mat3W ToMatrix() const {
+        const FloatW one = FloatW::Splat(1.0f), two = FloatW::Splat(2.0f);
+        const FloatW xx = X * X, yy = Y * Y, zz = Z * Z;
+        const FloatW xy = X * Y, xz = X * Z, yz = Y * Z;
+        const FloatW wx = W * X, wy = W * Y, wz = W * Z;
+        return { { { one - two * (yy + zz), two * (xy + wz), two * (xz - wy) },
+                   { two * (xy - wz), one - two * (xx + zz), two * (yz + wx) },
+                   { two * (xz + wy), two * (yz - wx), one - two * (xx + yy) } } };
+    }
+};
+
+// Applies the accumulated forces and gravity, clears the accumulators and
+// damps. Damping uses 1 / (1 + c dt), which matches exp(-c dt) to second
+// order in c dt and needs no exponential per lane.
+template<typename Index>
+inline void IntegrateVelocities(BodyStore& S, uint32_t count, Index idx, const glm::vec3& gravity, float dt) {
+    const FloatW h = FloatW::Splat(dt), one = FloatW::Splat(1.0f);
+    const Vec3W g = Vec3W::Splat(gravity);
+    ForEachBodyBatch(S, count, idx, [&](const uint32_t* lanes, int n) {
+        Vec3W v, w, f, t; Mat3W I; FloatW invM, gs, ld, ad;
+        for (int l = 0; l < FloatW::Width; ++l) {
+            const uint32_t i = lanes[l];
+            v.Set(l, S.LinearVelocity[i]); w.Set(l, S.AngularVelocity[i]);
+            f.Set(l, S.Force[i]); t.Set(l, S.Torque[i]);
+            I.Set(l, S.InverseInertiaWorld[i]);
+            invM[l] = S.InverseMass[i]; gs[l] = S.GravityScale[i];
+            ld[l] = S.LinearDamping[i]; ad[l] = S.AngularDamping[i];
+        }
+        v += (f * invM + g * gs) * h;
+        w += (I * t) * h;
+        v = v * (one / (one + ld * h));
+        w = w * (one / (one + ad * h));
+        for (int l = 0; l < n; ++l) {
+            const uint32_t i = lanes[l];
+            S.LinearVelocity[i] = v.Get(l); S.AngularVelocity[i] = w.Get(l);
+            S.Force[i] = glm::vec3(0.0f); S.Torque[i] = glm::vec3(0.0f);
+        }
+    });
+}
+
+// Moves the bodies along their velocities. The rotation by the half angle
+// a = |w| dt / 2 uses cos a and sin(a) / |w| as series in a^2, so no lane
+// needs a square root or a trigonometric call; the few lanes turning more
+// than a radian a substep, where the series drift, are redone exactly.
+template<typename Index>
+inline void IntegratePoses(BodyStore& S, uint32_t count, Index idx, float dt) {
+    const FloatW h = FloatW::Splat(dt), halfH = FloatW::Splat(0.5f * dt), one = FloatW::Splat(1.0f);
+    const FloatW c2 = FloatW::Splat(-1.0f / 2.0f), c4 = FloatW::Splat(1.0f / 24.0f), c6 = FloatW::Splat(-1.0f / 720.0f);
+    const FloatW s2 = FloatW::Splat(-1.0f / 6.0f), s4 = FloatW::Splat(1.0f / 120.0f), s6 = FloatW::Splat(-1.0f / 5040.0f);
+    ForEachBodyBatch(S, count, idx, [&](const uint32_t* lanes, int n) {
+        Vec3W p, v, w; QuatW q;
+        for (int l = 0; l < FloatW::Width; ++l) {
+            const uint32_t i = lanes[l];
+            p.Set(l, S.Position[i]); v.Set(l, S.LinearVelocity[i]); w.Set(l, S.AngularVelocity[i]);
+            q.Set(l, S.Orientation[i]);
+        }
+        p += v * h;
+
+        const FloatW a2 = Dot(w, w) * halfH * halfH;
+        const FloatW c = one + a2 * (c2 + a2 * (c4 + a2 * c6));
+        const FloatW s = halfH * (one + a2 * (s2 + a2 * (s4 + a2 * s6)));
+        const Vec3W d = w * s;
+        // (c, d) * q, then normalized.
+        QuatW r{ c * q.X + q.W * d.X + d.Y * q.Z - d.Z * q.Y,
+                 c * q.Y + q.W * d.Y + d.Z * q.X - d.X * q.Z,
+                 c * q.Z + q.W * d.Z + d.X * q.Y - d.Y * q.X,
+                 c * q.W - (d.X * q.X + d.Y * q.Y + d.Z * q.Z) };
+        const FloatW inv = one / Sqrt(r.X * r.X + r.Y * r.Y + r.Z * r.Z + r.W * r.W);
+        r = { r.X * inv, r.Y * inv, r.Z * inv, r.W * inv };
+
+        for (int l = 0; l < n; ++l) {
+            const uint32_t i = lanes[l];
+            S.Position[i] = p.Get(l);
+            if (a2[l] <= 1.0f) { S.Orientation[i] = r.Get(l); continue; }
+            const glm::vec3 wl = w.Get(l);
+            const float wLen = glm::length(wl);
+            S.Orientation[i] = glm::normalize(glm::angleAxis(wLen * dt, wl / wLen) * S.Orientation[i]);
+        }
+    });
+}
+
+// Refreshes Rotation, InverseInertiaWorld and WorldAABB from the poses, as
+// BodyStore::UpdateAABB and UpdateWorldInertia do one body at a time.
+template<typename Index>
+inline void RefitBodies(BodyStore& S, uint32_t count, Index idx, float margin = 0.01f) {
+    const FloatW half = FloatW::Splat(0.5f), m = FloatW::Splat(margin);
+    auto abs = [](FloatW x) { return Max(x, -x); };
+    ForEachBodyBatch(S, count, idx, [&](const uint32_t* lanes, int n) {
+        Vec3W p, lo, hi; QuatW q; Mat3W I;
+        for (int l = 0; l < FloatW::Width; ++l) {
+            const uint32_t i = lanes[l];
+            p.Set(l, S.Position[i]); q.Set(l, S.Orientation[i]);
+            lo.Set(l, S.LocalAABB[i].Min); hi.Set(l, S.LocalAABB[i].Max);
+            I.Set(l, S.InverseInertiaLocal[i]);
+        }
+        const Mat3W R = q.ToMatrix();
+        const Mat3W Iw = R * I * R.Transposed();
+
+        const Vec3W lc = (lo + hi) * half, le = (hi - lo) * half;
+        const Vec3W wc = p + R * lc;
+        const Vec3W we{ abs(R.C[0].X) * le.X + abs(R.C[1].X) * le.Y + abs(R.C[2].X) * le.Z + m,
+                        abs(R.C[0].Y) * le.X + abs(R.C[1].Y) * le.Y + abs(R.C[2].Y) * le.Z + m,
+                        abs(R.C[0].Z) * le.X + abs(R.C[1].Z) * le.Y + abs(R.C[2].Z) * le.Z + m };
+        const Vec3W mn = wc - we, mx = wc + we;
+
+        for (int l = 0; l < n; ++l) {
+            const uint32_t i = lanes[l];
+            S.Rotation[i] = R.Get(l);
+            S.InverseInertiaWorld[i] = Iw.Get(l);
+            S.WorldAABB[i].Min = mn.Get(l); S.WorldAABB[i].Max = mx.Get(l);
+        }
+    });
+}
+
+// Advances each body's sleep timer by dt while both its speeds are below
+// the thresholds (given squared) and resets it otherwise.
+template<typename Index>
+inline void TickSleepTimers(BodyStore& S, uint32_t count, Index idx, float linSq, float angSq, float dt) {
+    ForEachBodyBatch(S, count, idx, [&](const uint32_t* lanes, int n) {
+        Vec3W v, w;
+        for (int l = 0; l < FloatW::Width; ++l) { v.Set(l, S.LinearVelocity[lanes[l]]); w.Set(l, S.AngularVelocity[lanes[l]]); }
+        const FloatW v2 = Dot(v, v), w2 = Dot(w, w);
+        for (int l = 0; l < n; ++l) {
+            BodyInfo& b = S.Info[lanes[l]];
+            b.SleepTimer = (v2[l] < linSq && w2[l] < angSq) ? b.SleepTimer + dt : 0.0f;
+        }
+    });
+}
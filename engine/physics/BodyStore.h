@@ -0,0 +1,226 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "AABB.h"
+#include "BodyHandle.h"
+#include "DynamicAABBTree.h"
+#include "Shape.h"
+
+struct PhysicsMaterial {
+    float Restitution = 0.2f;
+    float Friction = 0.5f;
+};
+inline float CombineRestitution(const PhysicsMaterial& a, const PhysicsMaterial& b) { return std::max(a.Restitution, b.Restitution); }
+inline float CombineFriction(const PhysicsMaterial& a, const PhysicsMaterial& b) { return std::sqrt(a.Friction * b.Friction); }
+
+enum class BodyType { Static, Kinematic, Dynamic };
+
+// Per-body data the step loops rarely touch.
+struct BodyInfo {
+    uint32_t  ID = 0;
+    BodyType  Type = BodyType::Dynamic;
+    void* UserData = nullptr;
+
+    PhysicsMaterial Material;
+    Shape* CollisionShape = nullptr;
+    float  Mass = 1.0f;
+    bool   IsBullet = false;   // swept against other bodies each substep
+    uint32_t CollisionCategory = 1;     // see CollisionFilter
+    uint32_t CollisionMask = ~0u;
+    bool   IsAwake = true;
+    float  SleepTimer = 0.0f;
+    glm::vec3 StepPosition{ 0.0f };                      // kinematic pose at the last step, to tell whether it moved
+    glm::quat StepOrientation{ 1.0f, 0.0f, 0.0f, 0.0f };
+
+    int32_t ProxyID = DynamicAABBTree::Null;
+    bool    FatAABBMoved = false;
+
+    static constexpr uint32_t NoIsland = 0xFFFFFFFFu;
+    uint32_t IslandID = NoIsland;   // sleeping island this body belongs to
+
+    bool IsStatic()   const { return Type == BodyType::Static; }
+    bool IsKinematic()const { return Type == BodyType::Kinematic; }
+    bool IsDynamic()  const { return Type == BodyType::Dynamic; }
+};
+
+// Structure-of-arrays body storage. Every array is indexed by the same dense
+// index, so the integrate/refit/solve loops stream through contiguous memory.
+// Removal swaps the last body into the hole (O(1)); handles stay valid because
+// they go through the slot table, which tracks each body's current dense index.
+//
+// The dense range is partitioned: [0, AwakeCount()) holds awake dynamic and all
+// kinematic bodies, the rest holds sleeping and static bodies. Per-body stages
+// only walk the awake range, so their cost does not grow with settled bodies.
+//
+// Static and kinematic bodies have zero inverse mass and inertia, so impulses
+// can be applied to both sides of a contact without branching on body type.
+class BodyStore {
+public:
+    std::vector<glm::vec3> Position;
+    std::vector<glm::quat> Orientation;
+    std::vector<glm::mat3> Rotation;    // Orientation as a matrix, refreshed by UpdateAABB
+    std::vector<glm::vec3> LinearVelocity;
+    std::vector<glm::vec3> AngularVelocity;
+    std::vector<glm::vec3> Force;
+    std::vector<glm::vec3> Torque;
+
+    std::vector<float>     InverseMass;
+    std::vector<glm::mat3> InverseInertiaLocal;
+    std::vector<glm::mat3> InverseInertiaWorld;
+    std::vector<float>     LinearDamping;
+    std::vector<float>     AngularDamping;
+    std::vector<float>     GravityScale;
+
+    std::vector<AABB>      LocalAABB;   // shape bounds, cached so refits never touch the shape
+    std::vector<AABB>      WorldAABB;
+    std::vector<AABB>      FatAABB;     // enlarged bounds the cached broadphase pairs were built from
+
+    std::vector<BodyInfo>  Info;
+
+    uint32_t Size() const { return (uint32_t)Position.size(); }
+    uint32_t AwakeCount() const { return m_AwakeCount; }
+    bool InAwakeRange(uint32_t i) const { return i < m_AwakeCount; }
+    // Inverse mass and inertia as the solvers see them: zero outside the
+    // awake range, so a sleeping body a contact reaches acts as static and
+    // is never written by islands it does not belong to.
+    float SolverInverseMass(uint32_t i) const { return i < m_AwakeCount ? InverseMass[i] : 0.0f; }
+    glm::mat3 SolverInverseInertia(uint32_t i) const { return i < m_AwakeCount ? InverseInertiaWorld[i] : glm::mat3(0.0f); }
+
+    // New bodies start outside the awake range; see MoveToAwake.
+    BodyHandle Add() {
+        uint32_t slot;
+        if (!m_FreeSlots.empty()) { slot = m_FreeSlots.back(); m_FreeSlots.pop_back(); }
+        else { slot = (uint32_t)m_Slots.size(); m_Slots.push_back({}); }
+        m_Slots[slot].Dense = Size();
+        m_DenseToSlot.push_back(slot);
+
+        Position.emplace_back(0.0f);          Orientation.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+        Rotation.emplace_back(1.0f);
+        LinearVelocity.emplace_back(0.0f);    AngularVelocity.emplace_back(0.0f);
+        Force.emplace_back(0.0f);             Torque.emplace_back(0.0f);
+        InverseMass.push_back(0.0f);
+        InverseInertiaLocal.emplace_back(0.0f); InverseInertiaWorld.emplace_back(0.0f);
+        LinearDamping.push_back(0.0f);        AngularDamping.push_back(0.0f);
+        GravityScale.push_back(1.0f);
+        LocalAABB.emplace_back();             WorldAABB.emplace_back(); FatAABB.emplace_back();
+        Info.emplace_back();
+        return { slot, m_Slots[slot].Generation };
+    }
+
+    void Remove(BodyHandle h) {
+        if (!IsValid(h)) return;
+        uint32_t i = m_Slots[h.Index].Dense;
+        if (InAwakeRange(i)) i = MoveToAsleep(i);
+        uint32_t last = Size() - 1;
+        if (i != last) {
+            ForEachArray([&](auto& v) { v[i] = v[last]; });
+            m_DenseToSlot[i] = m_DenseToSlot[last];
+            m_Slots[m_DenseToSlot[i]].Dense = i;
+        }
+        ForEachArray([](auto& v) { v.pop_back(); });
+        m_DenseToSlot.pop_back();
+
+        m_Slots[h.Index].Dense = BodyHandle::InvalidIndex;
+        ++m_Slots[h.Index].Generation;
+        m_FreeSlots.push_back(h.Index);
+    }
+
+    // Moves a body across the awake boundary and returns its new dense index.
+    uint32_t MoveToAwake(uint32_t i) {
+        if (InAwakeRange(i)) return i;
+        Swap(i, m_AwakeCount);
+        return m_AwakeCount++;
+    }
+    uint32_t MoveToAsleep(uint32_t i) {
+        if (!InAwakeRange(i)) return i;
+        Swap(i, --m_AwakeCount);
+        return m_AwakeCount;
+    }
+
+    bool IsValid(BodyHandle h) const {
+        return h.Index < m_Slots.size() && m_Slots[h.Index].Generation == h.Generation
+            && m_Slots[h.Index].Dense != BodyHandle::InvalidIndex;
+    }
+    // Dense index of a valid handle. Dense indices change when bodies are removed.
+    uint32_t IndexOf(BodyHandle h) const { return m_Slots[h.Index].Dense; }
+    uint32_t IndexOfSlot(uint32_t slot) const { return m_Slots[slot].Dense; }
+    BodyHandle HandleOf(uint32_t i) const { uint32_t s = m_DenseToSlot[i]; return { s, m_Slots[s].Generation }; }
+
+    glm::vec3 LocalToWorld(uint32_t i, const glm::vec3& lp) const { return Position[i] + (Orientation[i] * lp); }
+    glm::vec3 WorldToLocal(uint32_t i, const glm::vec3& wp) const { return glm::conjugate(Orientation[i]) * (wp - Position[i]); }
+    glm::vec3 VelocityAt(uint32_t i, const glm::vec3& wp) const { return LinearVelocity[i] + glm::cross(AngularVelocity[i], wp - Position[i]); }
+    // Distance from the body's origin to the farthest corner of its local bounds.
+    float Reach(uint32_t i) const { return glm::length(glm::max(glm::abs(LocalAABB[i].Min), glm::abs(LocalAABB[i].Max))); }
+
+    void SetStatic(uint32_t i) {
+        Info[i].Type = BodyType::Static;
+        InverseMass[i] = 0.0f; InverseInertiaLocal[i] = glm::mat3(0.0f); InverseInertiaWorld[i] = glm::mat3(0.0f);
+        LinearVelocity[i] = {}; AngularVelocity[i] = {}; Info[i].IsAwake = false;
+    }
+    void RecalculateMassProperties(uint32_t i) {
+        const BodyInfo& b = Info[i];
+        if (b.IsStatic() || !b.CollisionShape || b.Mass <= 0.0f) { SetStatic(i); return; }
+        if (b.IsKinematic()) { InverseMass[i] = 0.0f; InverseInertiaLocal[i] = glm::mat3(0.0f); return; }
+        InverseMass[i] = 1.0f / b.Mass;
+        glm::mat3 I = b.CollisionShape->ComputeInertiaTensor(b.Mass);
+        InverseInertiaLocal[i] = (std::abs(glm::determinant(I)) > 1e-12f) ? glm::inverse(I) : glm::mat3(0.0f);
+    }
+    // Uses the rotation cached by UpdateAABB.
+    void UpdateWorldInertia(uint32_t i) {
+        const glm::mat3& R = Rotation[i];
+        InverseInertiaWorld[i] = R * InverseInertiaLocal[i] * glm::transpose(R);
+    }
+    // Also refreshes the cached rotation, so it must follow every change of
+    // Orientation; the narrowphase reads Rotation rather than the quaternion.
+    void UpdateAABB(uint32_t i, float margin = 0.01f) {
+        const AABB& lo = LocalAABB[i];
+        glm::vec3 lc = (lo.Min + lo.Max) * 0.5f, le = (lo.Max - lo.Min) * 0.5f;
+        const glm::mat3& R = Rotation[i] = glm::mat3_cast(Orientation[i]);
+        glm::vec3 wc = Position[i] + R * lc;
+        glm::vec3 we = glm::abs(R[0]) * le.x + glm::abs(R[1]) * le.y + glm::abs(R[2]) * le.z;
+        WorldAABB[i].Min = wc - we - glm::vec3(margin);
+        WorldAABB[i].Max = wc + we + glm::vec3(margin);
+    }
+    // WorldAABB stretched over the body's linear motion in the next dt.
+    AABB SweptAABB(uint32_t i, float dt) const {
+        glm::vec3 d = LinearVelocity[i] * dt;
+        return { WorldAABB[i].Min + glm::min(d, glm::vec3(0.0f)), WorldAABB[i].Max + glm::max(d, glm::vec3(0.0f)) };
+    }
+    // Grows the tight bounds by a margin plus the motion predicted over `dt`,
+    // so the cached pairs stay valid until the body leaves them.
+    void UpdateFatAABB(uint32_t i, float margin, float dt) {
+        glm::vec3 d = LinearVelocity[i] * dt;
+        FatAABB[i].Min = WorldAABB[i].Min - glm::vec3(margin) + glm::min(d, glm::vec3(0.0f));
+        FatAABB[i].Max = WorldAABB[i].Max + glm::vec3(margin) + glm::max(d, glm::vec3(0.0f));
+    }
+private:
+    struct Slot { uint32_t Dense = BodyHandle::InvalidIndex; uint32_t Generation = 0; };
+
+    std::vector<Slot>     m_Slots;
+    std::vector<uint32_t> m_DenseToSlot;
+    std::vector<uint32_t> m_FreeSlots;
+    uint32_t              m_AwakeCount = 0;
+
+    void Swap(uint32_t i, uint32_t j) {
+        if (i == j) return;
+        ForEachArray([&](auto& v) { std::swap(v[i], v[j]); });
+        std::swap(m_DenseToSlot[i], m_DenseToSlot[j]);
+        m_Slots[m_DenseToSlot[i]].Dense = i;
+        m_Slots[m_DenseToSlot[j]].Dense = j;
+    }
+
+    template<typename F>
+    void ForEachArray(F&& f) {
+        f(Position); f(Orientation); f(Rotation); f(LinearVelocity); f(AngularVelocity); f(Force); f(Torque);
+        f(InverseMass); f(InverseInertiaLocal); f(InverseInertiaWorld);
+        f(LinearDamping); f(AngularDamping); f(GravityScale);
+        f(LocalAABB); f(WorldAABB); f(FatAABB); f(Info);
+    }
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "BodyStore.h"
+#include "Contact.h"
+
+// Decides which body pairs the broadphases report. Two bodies collide when
+// they are not both static, each one's category shares a bit with the
+// other's mask, and the pair has not been ignored (as jointed bodies often
+// are). Pairs that fail never reach the narrowphase.
+class CollisionFilter {
+public:
+    bool ShouldCollide(const BodyInfo& a, const BodyInfo& b) const {
+        if (a.IsStatic() && b.IsStatic()) return false;
+        if (!(a.CollisionCategory & b.CollisionMask) || !(b.CollisionCategory & a.CollisionMask)) return false;
+        return m_Ignored.empty() || !std::binary_search(m_Ignored.begin(), m_Ignored.end(), MakePairKey(a.ID, b.ID));
+    }
+
+    // Bodies are named by ID, which survives the reordering of dense indices.
+    void Ignore(uint32_t idA, uint32_t idB, bool ignore) {
+        const uint64_t key = MakePairKey(idA, idB);
+        auto it = std::lower_bound(m_Ignored.begin(), m_Ignored.end(), key);
+        bool found = it != m_Ignored.end() && *it == key;
+        if (ignore && !found) m_Ignored.insert(it, key);
+        else if (!ignore && found) m_Ignored.erase(it);
+    }
+
+    // Drops every ignored pair of a body that is being removed.
+    void Forget(uint32_t id) {
+        if (m_Ignored.empty()) return;
+        m_Ignored.erase(std::remove_if(m_Ignored.begin(), m_Ignored.end(), [&](uint64_t key) {
+            return uint32_t(key >> 32) == id || uint32_t(key) == id;
+            }), m_Ignored.end());
+    }
+
+private:
+    std::vector<uint64_t> m_Ignored;   // sorted MakePairKey of body IDs
+};
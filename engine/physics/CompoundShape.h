@@ -0,0 +1,165 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Shape.h"
+
+// A rigid arrangement of convex shapes, each placed by a transform in the
+// compound's frame, so an object built from several parts is one body
+// instead of several welded by joints. A small BVH over the children's
+// bounds, laid out like TriangleMeshShape's, lets the narrowphase visit
+// only the children near the other shape.
+//
+// Children are not owned and must outlive the compound. Meshes,
+// heightfields and nested compounds cannot be children and are skipped.
+// The mass is split between the children by volume, and the inertia is
+// taken about the compound's origin, which the body treats as its center
+// of mass.
+struct CompoundShape : public Shape {
+    struct Child {
+        Shape*    ChildShape = nullptr;
+        glm::vec3 Position{ 0.0f };
+        glm::quat Orientation{ 1, 0, 0, 0 };
+        glm::mat3 Rotation{ 1.0f };   // cached from Orientation by the constructor
+    };
+
+    // Same layout as TriangleMeshShape::Node; leaves index m_Order.
+    struct Node {
+        glm::vec3 Min;
+        uint32_t  Offset;
+        glm::vec3 Max;
+        uint32_t  Count;
+    };
+
+    static constexpr uint32_t MaxLeafChildren = 2;
+
+    explicit CompoundShape(const std::vector<Child>& children) {
+        Type = ShapeType::Compound;
+        for (const Child& c : children) {
+            if (!c.ChildShape || !IsConvex(c.ChildShape->Type)) continue;
+            Child child = c;
+            child.Rotation = glm::mat3_cast(c.Orientation);
+            m_Children.push_back(child);
+            m_ChildBounds.push_back(c.ChildShape->ComputeLocalAABB().Transformed(child.Rotation, child.Position));
+        }
+        for (const AABB& b : m_ChildBounds) m_Bounds = AABB::Union(m_Bounds, b);
+        if (m_Children.empty()) { m_Bounds = { glm::vec3(0.0f), glm::vec3(0.0f) }; return; }
+
+        m_Order.resize(m_Children.size());
+        std::iota(m_Order.begin(), m_Order.end(), 0u);
+        m_Nodes.reserve(2 * m_Children.size());
+        Build(0, (uint32_t)m_Order.size());
+    }
+
+    AABB ComputeLocalAABB() const override { return m_Bounds; }
+
+    float ComputeVolume() const override {
+        float v = 0.0f;
+        for (const Child& c : m_Children) v += c.ChildShape->ComputeVolume();
+        return v;
+    }
+
+    // Each child's inertia rotated into the compound's frame and moved to
+    // its origin by the parallel axis theorem.
+    glm::mat3 ComputeInertiaTensor(float mass) const override {
+        const float volume = ComputeVolume();
+        glm::mat3 I(0.0f);
+        for (const Child& c : m_Children) {
+            const float m = volume > 0.0f ? mass * c.ChildShape->ComputeVolume() / volume : mass / float(m_Children.size());
+            const glm::vec3& p = c.Position;
+            I += c.Rotation * c.ChildShape->ComputeInertiaTensor(m) * glm::transpose(c.Rotation);
+            I += m * (glm::mat3(glm::dot(p, p)) - glm::outerProduct(p, p));
+        }
+        return I;
+    }
+
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        glm::vec3 best(0.0f); float bestD = -FLT_MAX;
+        for (const Child& c : m_Children) {
+            glm::vec3 v = c.Position + c.Rotation * c.ChildShape->GetLocalSupport(glm::transpose(c.Rotation) * dir);
+            float d = glm::dot(v, dir);
+            if (d > bestD) { bestD = d; best = v; }
+        }
+        return best;
+    }
+
+    // Calls cb(index, child) for every child whose bounds overlap the
+    // local-space box. Indices are positions in GetChildren().
+    template<typename F>
+    void Query(const AABB& box, F&& cb) const {
+        if (m_Nodes.empty()) return;
+        std::array<uint32_t, 64> stack; int sp = 0;
+        uint32_t id = 0;
+        for (;;) {
+            const Node& n = m_Nodes[id];
+            if (Overlaps(n, box)) {
+                if (n.Count > 0) {
+                    for (uint32_t k = n.Offset; k < n.Offset + n.Count; ++k) {
+                        const uint32_t c = m_Order[k];
+                        if (m_ChildBounds[c].Overlaps(box)) cb(c, m_Children[c]);
+                    }
+                }
+                else {
+                    stack[sp++] = n.Offset;
+                    id = id + 1;
+                    continue;
+                }
+            }
+            if (sp == 0) return;
+            id = stack[--sp];
+        }
+    }
+
+    const std::vector<Child>& GetChildren() const { return m_Children; }
+    const AABB& GetChildBounds(uint32_t i) const { return m_ChildBounds[i]; }
+
+    static bool IsConvex(ShapeType t) {
+        return t != ShapeType::TriangleMesh && t != ShapeType::Heightfield && t != ShapeType::Compound;
+    }
+
+private:
+    std::vector<Child>    m_Children;
+    std::vector<AABB>     m_ChildBounds;   // in the compound's frame
+    std::vector<Node>     m_Nodes;
+    std::vector<uint32_t> m_Order;         // child indices in leaf order
+    AABB                  m_Bounds;
+
+    static bool Overlaps(const Node& n, const AABB& b) {
+        return n.Max.x >= b.Min.x && n.Min.x <= b.Max.x &&
+            n.Max.y >= b.Min.y && n.Min.y <= b.Max.y &&
+            n.Max.z >= b.Min.z && n.Min.z <= b.Max.z;
+    }
+
+    // Median split on the longest axis of the children's centers, as in
+    // TriangleMeshShape::Build.
+    uint32_t Build(uint32_t first, uint32_t last) {
+        AABB bounds, cb;
+        for (uint32_t k = first; k < last; ++k) {
+            const AABB& b = m_ChildBounds[m_Order[k]];
+            bounds = AABB::Union(bounds, b);
+            cb.Min = glm::min(cb.Min, b.Center()); cb.Max = glm::max(cb.Max, b.Center());
+        }
+        const uint32_t id = (uint32_t)m_Nodes.size();
+        m_Nodes.push_back({ bounds.Min, first, bounds.Max, last - first });
+        if (last - first <= MaxLeafChildren) return id;
+
+        glm::vec3 ext = cb.Max - cb.Min;
+        int axis = 0; if (ext.y > ext.x) axis = 1; if (ext.z > ext[axis]) axis = 2;
+        const uint32_t mid = first + (last - first) / 2;
+        std::nth_element(m_Order.begin() + first, m_Order.begin() + mid, m_Order.begin() + last,
+            [&](uint32_t a, uint32_t b) { return m_ChildBounds[a].Center()[axis] < m_ChildBounds[b].Center()[axis]; });
+
+        Build(first, mid);
+        uint32_t right = Build(mid, last);
+        m_Nodes[id].Offset = right; m_Nodes[id].Count = 0;
+        return id;
+    }
+};
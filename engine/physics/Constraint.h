@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "BodyHandle.h"
+#include "BodyStore.h"
+#include "ContactSolver.h"
+#include "XPBDSolver.h"
+
+// The velocity row of a one-dimensional joint between bodies A and B (dense
+// indices): the relative velocity along Normal, with the angular terms in
+// Axis, is driven to -Bias. A zero Axis.Mass means the row is inactive.
+struct JointRow {
+    uint32_t    A = 0, B = 0;
+    glm::vec3   Normal{ 0.0f };
+    ContactAxis Axis;
+    float       Bias = 0.0f;
+
+    float Velocity(const BodyStore& S) const {
+        return glm::dot(Normal, S.LinearVelocity[B] - S.LinearVelocity[A])
+            + glm::dot(Axis.RBxAxis, S.AngularVelocity[B]) - glm::dot(Axis.RAxAxis, S.AngularVelocity[A]);
+    }
+};
+
+struct Constraint {
+    BodyHandle BodyA;
+    BodyHandle BodyB;
+    // Called once per substep before the velocity iterations. Positions are
+    // fixed until they finish, so anything derived from them belongs here.
+    virtual void BeginSubStep(const BodyStore&, float, float) {}
+    // `useBias` is false in the soft-step relax pass, which removes the
+    // velocity the position correction added. Returns how much the pass
+    // changed the constrained relative velocity, which SolverTolerance is
+    // checked against.
+    virtual float SolveVelocity(BodyStore& bodies, float dt, float invDt, bool useBias) = 0;
+
+    // Joints made of a single row expose it, so JointTreeSolver can solve a
+    // whole tree of them at once. GetRow is valid after BeginSubStep;
+    // ApplyRowImpulse adds an impulse along the row and returns the velocity
+    // change, like SolveVelocity.
+    virtual const JointRow* GetRow() const { return nullptr; }
+    virtual float ApplyRowImpulse(BodyStore&, float, float) { return 0.0f; }
+
+    // The XPBD solver calls BeginPositionSolve once per substep and then
+    // SolvePosition once per position pass, in place of BeginSubStep and
+    // SolveVelocity. SolvePosition moves the bodies toward satisfying the
+    // constraint and returns how far it moved them. A joint without a
+    // position path is not solved by XPBD.
+    virtual void BeginPositionSolve(const BodyStore&, float) {}
+    virtual float SolvePosition(BodyStore&, float) { return 0.0f; }
+
+    virtual ~Constraint() = default;
+};
+
+struct DistanceJoint : public Constraint {
+    glm::vec3 LocalAnchorA{ 0.0f };
+    glm::vec3 LocalAnchorB{ 0.0f };
+    float TargetLength = 1.0f;
+    float ERP = 0.2f;
+    float MaxImpulse = 1e6f;
+    float Compliance = 0.0f;   // XPBD only, in m/N; 0 holds the length rigidly
+    float AccumLambda = 0.0f;
+
+    void BeginSubStep(const BodyStore& S, float, float invDt) override {
+        AccumLambda = 0.0f; m_Row.Axis.Mass = 0.0f;
+        if (!S.IsValid(BodyA) || !S.IsValid(BodyB)) return;
+        const uint32_t a = m_Row.A = S.IndexOf(BodyA), b = m_Row.B = S.IndexOf(BodyB);
+        glm::vec3 wA = S.LocalToWorld(a, LocalAnchorA);
+        glm::vec3 wB = S.LocalToWorld(b, LocalAnchorB);
+        glm::vec3 df = wB - wA;
+        float dist = glm::length(df);
+        if (dist < 1e-8f) return;
+        m_Row.Normal = df / dist;
+        m_Row.Axis = PrepareContactAxis(S, a, b, wA - S.Position[a], wB - S.Position[b], m_Row.Normal, 0.0f);
+        m_Row.Bias = ERP * invDt * (dist - TargetLength);
+    }
+
+    float SolveVelocity(BodyStore& S, float dt, float, bool useBias) override {
+        if (m_Row.Axis.Mass == 0.0f) return 0.0f;
+        float bias = useBias ? m_Row.Bias : 0.0f;
+        return ApplyRowImpulse(S, -(m_Row.Velocity(S) + bias) * m_Row.Axis.Mass, dt);
+    }
+
+    const JointRow* GetRow() const override { return &m_Row; }
+
+    float ApplyRowImpulse(BodyStore& S, float impulse, float dt) override {
+        if (m_Row.Axis.Mass == 0.0f) return 0.0f;
+        const uint32_t a = m_Row.A, b = m_Row.B;
+        float lam = std::clamp(impulse, -MaxImpulse * dt, MaxImpulse * dt);
+        AccumLambda += lam;
+        if (S.InverseMass[a] > 0.0f) { S.LinearVelocity[a] -= m_Row.Normal * (lam * S.InverseMass[a]); S.AngularVelocity[a] -= m_Row.Axis.AngularA * lam; }
+        if (S.InverseMass[b] > 0.0f) { S.LinearVelocity[b] += m_Row.Normal * (lam * S.InverseMass[b]); S.AngularVelocity[b] += m_Row.Axis.AngularB * lam; }
+        return std::abs(lam) / m_Row.Axis.Mass;
+    }
+
+    void BeginPositionSolve(const BodyStore&, float) override { m_Lambda = 0.0f; AccumLambda = 0.0f; }
+
+    float SolvePosition(BodyStore& S, float dt) override {
+        if (!S.IsValid(BodyA) || !S.IsValid(BodyB)) return 0.0f;
+        const uint32_t a = S.IndexOf(BodyA), b = S.IndexOf(BodyB);
+        glm::vec3 wA = S.LocalToWorld(a, LocalAnchorA);
+        glm::vec3 wB = S.LocalToWorld(b, LocalAnchorB);
+        glm::vec3 df = wB - wA;
+        float dist = glm::length(df);
+        if (dist < 1e-8f) return 0.0f;
+        glm::vec3 n = df / dist;
+        glm::vec3 rA = wA - S.Position[a], rB = wB - S.Position[b];
+        float w = GeneralizedInverseMass(S, a, rA, n) + GeneralizedInverseMass(S, b, rB, n);
+        float alpha = Compliance / (dt * dt);
+        if (w + alpha < 1e-10f) return 0.0f;
+        // MaxImpulse bounds the force, so the multiplier is bounded by it times dt^2.
+        float maxLambda = MaxImpulse * dt * dt;
+        float lam = std::clamp(m_Lambda + (TargetLength - dist - alpha * m_Lambda) / (w + alpha), -maxLambda, maxLambda);
+        float dl = lam - m_Lambda;
+        m_Lambda = lam; AccumLambda = lam / dt;
+        ApplyPositionImpulse(S, a, rA, -n * dl);
+        ApplyPositionImpulse(S, b, rB, n * dl);
+        return std::abs(dl) * w;
+    }
+
+private:
+    JointRow m_Row;           // prepared by BeginSubStep
+    float    m_Lambda = 0.0f; // XPBD multiplier of the current substep
+};
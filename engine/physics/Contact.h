@@ -0,0 +1,47 @@
+#pragma once
+
+#include <utility>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "FixedVector.h"
+
+struct ContactPoint {
+    glm::vec3 WorldPointA, WorldPointB;
+    glm::vec3 LocalPointA, LocalPointB;
+    float     Depth = 0.0f;
+    uint32_t  FeatureID = 0;   // identifies the features that produced the point; 0 for single-point tests
+
+    float NormalImpulse = 0.0f;
+    float TangentImpulse0 = 0.0f;
+    float TangentImpulse1 = 0.0f;
+
+    glm::vec3 Tangent0{ 1, 0, 0 };
+    glm::vec3 Tangent1{ 0, 0, 1 };
+};
+
+inline uint64_t MakePairKey(uint32_t a, uint32_t b) {
+    if (a > b) std::swap(a, b);
+    return (uint64_t(a) << 32) | uint64_t(b);
+}
+
+// Key of a manifold against one part of a shape made of many, such as a
+// mesh triangle, so every part keeps its own cache entry.
+inline uint64_t MakeSubShapeKey(uint64_t pairKey, uint32_t part) {
+    return pairKey ^ (uint64_t(part + 1) * 0x9E3779B97F4A7C15ull);
+}
+
+// Narrowphase tests reduce their contacts to at most this many per manifold.
+constexpr uint32_t MaxManifoldPoints = 4;
+
+// BodyA/BodyB are dense body indices; they are only valid for the step
+// that produced the manifold. Contacts are stored inline, so filling the
+// per-step manifold list does not touch the heap once it has grown.
+struct Manifold {
+    uint32_t   BodyA = 0;
+    uint32_t   BodyB = 0;
+    uint64_t   Key = 0;
+    glm::vec3  Normal{ 0, 1, 0 };
+    FixedVector<ContactPoint, MaxManifoldPoints> Contacts;
+};
@@ -0,0 +1,529 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "BodyStore.h"
+#include "Contact.h"
+#include "SimdFloat.h"
+#include "ThreadPool.h"
+
+enum class ContactSolverType { Sequential, GraphColored };
+
+// Iterative: up to SolverIterations rigid velocity passes per substep followed
+// by position projection. SoftStep: one soft-constraint pass before the positions
+// are integrated and one rigid relax pass after, with no position projection.
+// XPBD: position passes over the contacts and joints (XPBDSolver.h), then
+// velocities taken from the motion and one velocity pass for friction and
+// restitution.
+enum class SolverType { Iterative, SoftStep, XPBD };
+
+// Coefficients of a soft constraint behaving like a spring of `hertz` with
+// damping ratio `zeta` when stepped implicitly with timestep h. The impulse
+// becomes MassScale * Mass * (BiasRate * C - vRel) - ImpulseScale * accumulated;
+// a zero frequency gives the rigid constraint.
+struct Softness {
+    float BiasRate = 0.0f, MassScale = 1.0f, ImpulseScale = 0.0f;
+
+    static Softness Make(float hertz, float zeta, float h) {
+        if (hertz <= 0.0f) return {};
+        float omega = 2.0f * glm::pi<float>() * hertz;
+        float a1 = 2.0f * zeta + h * omega, a2 = h * omega * a1, a3 = 1.0f / (1.0f + a2);
+        return { omega / a1, a2 * a3, a3 };
+    }
+};
+
+// One constraint axis (normal or tangent) of a contact point.
+struct ContactAxis {
+    glm::vec3 RAxAxis{ 0.0f }, RBxAxis{ 0.0f };     // rA x axis, rB x axis
+    glm::vec3 AngularA{ 0.0f }, AngularB{ 0.0f };   // the above times the world inverse inertia
+    float     Mass = 0.0f;                         // inverse effective mass; 0 if degenerate
+    float     Impulse = 0.0f;
+};
+
+// A contact point prepared for the velocity iterations. Everything that is
+// constant within a substep (anchors, effective masses, friction, the
+// restitution target) is computed once by PrepareContactRows, so an iteration
+// only reads the row and updates its impulses.
+struct ContactRow {
+    uint32_t  BodyA = 0, BodyB = 0;
+    float     InvMassA = 0.0f, InvMassB = 0.0f;
+    glm::vec3 Normal{ 0.0f }, Tangent0{ 0.0f }, Tangent1{ 0.0f };
+    ContactAxis N, T0, T1;
+    float     Friction = 0.0f;
+    float     Bias = 0.0f;         // target normal velocity (restitution, or closing a speculative gap)
+    float     Separation = 0.0f;   // negative once penetration exceeds the slop
+
+    // Soft normal solve, filled in by SoftenContactRow.
+    float     SoftBias = 0.0f, MassScale = 1.0f, ImpulseScale = 0.0f;
+};
+
+inline ContactAxis PrepareContactAxis(const BodyStore& S, uint32_t a, uint32_t b,
+    const glm::vec3& rA, const glm::vec3& rB, const glm::vec3& ax, float impulse)
+{
+    ContactAxis r;
+    r.RAxAxis = glm::cross(rA, ax); r.RBxAxis = glm::cross(rB, ax);
+    r.AngularA = S.SolverInverseInertia(a) * r.RAxAxis; r.AngularB = S.SolverInverseInertia(b) * r.RBxAxis;
+    float k = S.SolverInverseMass(a) + S.SolverInverseMass(b) + glm::dot(r.RAxAxis, r.AngularA) + glm::dot(r.RBxAxis, r.AngularB);
+    r.Mass = (k > 1e-10f) ? 1.0f / k : 0.0f;
+    r.Impulse = impulse;
+    return r;
+}
+
+// Fills one row per contact point of `man`. Tangent bases and warm-start
+// impulses must already be set; the restitution target uses the current
+// velocities, so rows are prepared before the warm start is applied. A
+// speculative point (negative depth) lets the bodies close its gap within
+// the substep but no more; restitution waits until they touch.
+inline void PrepareContactRows(const BodyStore& S, const Manifold& man, ContactRow* rows, float invDt) {
+    const float REST_THRESH = 1.5f;
+    const float SLOP = 0.005f;
+    uint32_t a = man.BodyA, b = man.BodyB;
+    float e = CombineRestitution(S.Info[a].Material, S.Info[b].Material);
+    float mu = CombineFriction(S.Info[a].Material, S.Info[b].Material);
+
+    for (size_t p = 0; p < man.Contacts.size(); ++p) {
+        const ContactPoint& c = man.Contacts[p];
+        ContactRow& r = rows[p];
+        r.BodyA = a; r.BodyB = b;
+        r.InvMassA = S.SolverInverseMass(a); r.InvMassB = S.SolverInverseMass(b);
+        r.Normal = man.Normal; r.Tangent0 = c.Tangent0; r.Tangent1 = c.Tangent1;
+        glm::vec3 rA = c.WorldPointA - S.Position[a], rB = c.WorldPointB - S.Position[b];
+        r.N = PrepareContactAxis(S, a, b, rA, rB, r.Normal, c.NormalImpulse);
+        r.T0 = PrepareContactAxis(S, a, b, rA, rB, r.Tangent0, c.TangentImpulse0);
+        r.T1 = PrepareContactAxis(S, a, b, rA, rB, r.Tangent1, c.TangentImpulse1);
+        r.Friction = mu;
+        float vn = glm::dot(S.VelocityAt(b, c.WorldPointB) - S.VelocityAt(a, c.WorldPointA), r.Normal);
+        if (c.Depth < 0.0f) r.Bias = c.Depth * invDt;
+        else r.Bias = (vn < -REST_THRESH) ? -e * vn : 0.0f;
+        r.Separation = SLOP - c.Depth;
+    }
+}
+
+// Sets the soft normal target of a prepared row: a contact still within the
+// slop may close the remaining gap in one substep, a deeper one is pushed
+// apart by the spring, but no faster than `maxPush`.
+inline void SoftenContactRow(ContactRow& r, const Softness& soft, float invDt, float maxPush) {
+    if (r.Separation > 0.0f) {
+        r.SoftBias = -r.Separation * invDt; r.MassScale = 1.0f; r.ImpulseScale = 0.0f;
+    } else {
+        r.SoftBias = std::min(-soft.BiasRate * r.Separation, maxPush);
+        r.MassScale = soft.MassScale; r.ImpulseScale = soft.ImpulseScale;
+    }
+}
+
+// Copies the accumulated impulses back into the manifold for the cache.
+inline void StoreContactRows(const ContactRow* rows, Manifold& man) {
+    for (size_t p = 0; p < man.Contacts.size(); ++p) {
+        man.Contacts[p].NormalImpulse = rows[p].N.Impulse;
+        man.Contacts[p].TangentImpulse0 = rows[p].T0.Impulse;
+        man.Contacts[p].TangentImpulse1 = rows[p].T1.Impulse;
+    }
+}
+
+// Bodies with zero inverse mass are never written, so rows of different
+// islands can share a static or kinematic body across threads.
+inline void ApplyContactImpulse(BodyStore& S, const ContactRow& r, const glm::vec3& P,
+    const glm::vec3& angularA, const glm::vec3& angularB)
+{
+    if (r.InvMassA > 0.0f) { S.LinearVelocity[r.BodyA] -= P * r.InvMassA; S.AngularVelocity[r.BodyA] -= angularA; }
+    if (r.InvMassB > 0.0f) { S.LinearVelocity[r.BodyB] += P * r.InvMassB; S.AngularVelocity[r.BodyB] += angularB; }
+}
+
+inline void WarmStartContactRow(BodyStore& S, const ContactRow& r) {
+    glm::vec3 P = r.Normal * r.N.Impulse + r.Tangent0 * r.T0.Impulse + r.Tangent1 * r.T1.Impulse;
+    ApplyContactImpulse(S, r, P,
+        r.N.AngularA * r.N.Impulse + r.T0.AngularA * r.T0.Impulse + r.T1.AngularA * r.T1.Impulse,
+        r.N.AngularB * r.N.Impulse + r.T0.AngularB * r.T0.Impulse + r.T1.AngularB * r.T1.Impulse);
+}
+
+// Drives the relative velocity along `dir` toward `target`, keeping the
+// accumulated impulse within [lo, hi]. `massScale` and `impulseScale` soften
+// the axis (see Softness). Returns how much the relative velocity changed.
+inline float SolveContactAxis(BodyStore& S, const ContactRow& r, ContactAxis& ax, const glm::vec3& dir,
+    float target, float lo, float hi, float massScale = 1.0f, float impulseScale = 0.0f)
+{
+    float vRel = glm::dot(dir, S.LinearVelocity[r.BodyB] - S.LinearVelocity[r.BodyA])
+        + glm::dot(ax.RBxAxis, S.AngularVelocity[r.BodyB]) - glm::dot(ax.RAxAxis, S.AngularVelocity[r.BodyA]);
+    float old = ax.Impulse;
+    ax.Impulse = std::clamp(old + massScale * ax.Mass * (target - vRel) - impulseScale * old, lo, hi);
+    float d = ax.Impulse - old;
+    ApplyContactImpulse(S, r, dir * d, ax.AngularA * d, ax.AngularB * d);
+    return ax.Mass > 0.0f ? std::abs(d) / ax.Mass : 0.0f;
+}
+
+// Both friction axes of a row, bounded by its current normal impulse.
+inline float SolveContactFriction(BodyStore& S, ContactRow& r) {
+    float maxF = r.Friction * r.N.Impulse;
+    float change = SolveContactAxis(S, r, r.T0, r.Tangent0, 0.0f, -maxF, maxF);
+    return std::max(change, SolveContactAxis(S, r, r.T1, r.Tangent1, 0.0f, -maxF, maxF));
+}
+
+// `soft` selects the soft normal target; friction is always rigid. Returns
+// the largest velocity change of the three axes.
+inline float SolveContactRow(BodyStore& S, ContactRow& r, bool soft = false) {
+    float change = soft
+        ? SolveContactAxis(S, r, r.N, r.Normal, r.SoftBias, 0.0f, FLT_MAX, r.MassScale, r.ImpulseScale)
+        : SolveContactAxis(S, r, r.N, r.Normal, r.Bias, 0.0f, FLT_MAX);
+    return std::max(change, SolveContactFriction(S, r));
+}
+
+// Solves the normal impulses x of a manifold's n points together: the
+// velocities w = K x + b the impulses leave must not be negative, nor may the
+// impulses, and a point only pushes while its velocity is zero. The sets of
+// pushing points are tried largest first and the first that solves the
+// problem wins (total enumeration, as in Box2D's two-point block solver).
+// Four points on a face make K singular, leaving many ways to split the
+// load; a slight regularization toward the x passed in (the accumulated
+// impulses) keeps the split the warm start found instead of one that jumps
+// between corners every pass. Should rounding reject every set, one
+// Gauss-Seidel sweep from that x is run instead.
+inline void SolveNormalBlock(const float K[MaxManifoldPoints][MaxManifoldPoints], const float* b, uint32_t n, float* x) {
+    static constexpr uint8_t Sets[16] = { 15, 14, 13, 11, 7, 12, 10, 9, 6, 5, 3, 8, 4, 2, 1, 0 };
+    float diag = 0.0f, scale = 0.0f;
+    for (uint32_t i = 0; i < n; ++i) { diag = std::max(diag, K[i][i]); scale = std::max(scale, std::abs(b[i])); }
+    if (diag <= 1e-10f) return;
+    const float tolW = 1e-5f * (1.0f + scale), tolX = tolW / diag, reg = 1e-4f * diag;
+
+    for (uint8_t set : Sets) {
+        if (set >> n) continue;
+        uint32_t idx[MaxManifoldPoints], m = 0;
+        for (uint32_t i = 0; i < n; ++i) if (set & (1u << i)) idx[m++] = i;
+
+        // K restricted to the set, solved by elimination with partial pivoting.
+        float A[MaxManifoldPoints][MaxManifoldPoints + 1], y[MaxManifoldPoints] = {};
+        for (uint32_t r = 0; r < m; ++r) {
+            for (uint32_t c = 0; c < m; ++c) A[r][c] = K[idx[r]][idx[c]];
+            A[r][r] += reg;
+            A[r][m] = -b[idx[r]] + reg * x[idx[r]];
+        }
+        bool singular = false;
+        for (uint32_t c = 0; c < m; ++c) {
+            uint32_t piv = c;
+            for (uint32_t r = c + 1; r < m; ++r) if (std::abs(A[r][c]) > std::abs(A[piv][c])) piv = r;
+            if (std::abs(A[piv][c]) <= 1e-6f * diag) { singular = true; break; }
+            if (piv != c) for (uint32_t k = c; k <= m; ++k) std::swap(A[c][k], A[piv][k]);
+            for (uint32_t r = c + 1; r < m; ++r) {
+                float f = A[r][c] / A[c][c];
+                for (uint32_t k = c; k <= m; ++k) A[r][k] -= f * A[c][k];
+            }
+        }
+        if (singular) continue;
+        bool valid = true;
+        for (uint32_t r = m; r-- > 0 && valid;) {
+            float sum = A[r][m];
+            for (uint32_t k = r + 1; k < m; ++k) sum -= A[r][k] * y[k];
+            y[r] = sum / A[r][r];
+            valid = y[r] >= -tolX;
+        }
+        for (uint32_t i = 0; i < n && valid; ++i) {
+            if (set & (1u << i)) continue;
+            float w = b[i];
+            for (uint32_t k = 0; k < m; ++k) w += K[i][idx[k]] * y[k];
+            valid = w >= -tolW;
+        }
+        if (!valid) continue;
+        for (uint32_t i = 0; i < n; ++i) x[i] = 0.0f;
+        for (uint32_t k = 0; k < m; ++k) x[idx[k]] = std::max(y[k], 0.0f);
+        return;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        if (K[i][i] <= 1e-10f) continue;
+        float w = b[i];
+        for (uint32_t k = 0; k < n; ++k) w += K[i][k] * x[k];
+        x[i] = std::max(x[i] - w / K[i][i], 0.0f);
+    }
+}
+
+// SolveContactRow over the `count` rows of one manifold, with the rigid
+// normal impulses solved as a block by SolveNormalBlock before friction.
+inline float SolveContactBlock(BodyStore& S, ContactRow* rows, uint32_t count) {
+    float K[MaxManifoldPoints][MaxManifoldPoints], b[MaxManifoldPoints] = {}, x[MaxManifoldPoints];
+    const ContactRow& r0 = rows[0];
+    const glm::vec3 dv = S.LinearVelocity[r0.BodyB] - S.LinearVelocity[r0.BodyA];
+    const glm::vec3 &wA = S.AngularVelocity[r0.BodyA], &wB = S.AngularVelocity[r0.BodyB];
+    for (uint32_t i = 0; i < count; ++i) {
+        const ContactAxis& n = rows[i].N;
+        b[i] = glm::dot(r0.Normal, dv) + glm::dot(n.RBxAxis, wB) - glm::dot(n.RAxAxis, wA) - rows[i].Bias;
+        for (uint32_t j = 0; j < count; ++j)
+            K[i][j] = r0.InvMassA + r0.InvMassB + glm::dot(n.RAxAxis, rows[j].N.AngularA) + glm::dot(n.RBxAxis, rows[j].N.AngularB);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        x[i] = rows[i].N.Impulse;
+        for (uint32_t j = 0; j < count; ++j) b[i] -= K[i][j] * rows[j].N.Impulse;
+    }
+    SolveNormalBlock(K, b, count, x);
+
+    float change = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+        ContactRow& r = rows[i];
+        float d = x[i] - r.N.Impulse;
+        r.N.Impulse = x[i];
+        ApplyContactImpulse(S, r, r.Normal * d, r.N.AngularA * d, r.N.AngularB * d);
+        if (r.N.Mass > 0.0f) change = std::max(change, std::abs(d) / r.N.Mass);
+    }
+    for (uint32_t i = 0; i < count; ++i) change = std::max(change, SolveContactFriction(S, rows[i]));
+    return change;
+}
+
+// Contact velocity solver that graph-colors manifolds so no dynamic body
+// appears twice in a color, then packs the prepared rows of every color into
+// batches of FloatW::Width manifolds laid out as SIMD lanes. Each iteration a
+// batch gathers its bodies' velocities, solves every contact point
+// lane-parallel and scatters the velocities back. Batches of one color
+// share no dynamic body, so they run on the thread pool without locking;
+// static and kinematic bodies are only ever read.
+//
+// A manifold that finds no free color (a body touching more than MaxColors
+// others) gets a single-lane batch, solved on the calling thread.
+class GraphColorContactSolver {
+public:
+    static constexpr int      W = FloatW::Width;
+    static constexpr uint32_t MaxColors = 24;
+    static constexpr uint32_t MaxPoints = MaxManifoldPoints;
+    static constexpr uint32_t BatchesPerTask = 8;
+
+    // Colors `contacts` and packs their rows; the rows of manifold m start at
+    // rows[firstRow[m]].
+    void Prepare(const BodyStore& S, const std::vector<Manifold>& contacts,
+        const std::vector<ContactRow>& rows, const std::vector<uint32_t>& firstRow)
+    {
+        const uint32_t n = S.AwakeCount(), words = (n + 63) / 64;
+        for (auto& bits : m_ColorBodies) bits.assign(words, 0);
+        for (auto& list : m_ColorManifolds) list.clear();
+
+        auto writable = [&](uint32_t i) { return S.SolverInverseMass(i) > 0.0f; };
+        auto pack = [&](uint32_t m) { Pack(m_Batches.back(), contacts[m], &rows[firstRow[m]], m); };
+        auto used = [&](uint32_t c, uint32_t i) { return (m_ColorBodies[c][i >> 6] >> (i & 63)) & 1u; };
+        auto mark = [&](uint32_t c, uint32_t i) { m_ColorBodies[c][i >> 6] |= uint64_t(1) << (i & 63); };
+
+        for (uint32_t m = 0; m < (uint32_t)contacts.size(); ++m) {
+            uint32_t a = contacts[m].BodyA, b = contacts[m].BodyB;
+            bool wa = writable(a), wb = writable(b);
+            uint32_t color = MaxColors;
+            for (uint32_t c = 0; c < MaxColors; ++c) {
+                if ((wa && used(c, a)) || (wb && used(c, b))) continue;
+                if (wa) mark(c, a);
+                if (wb) mark(c, b);
+                color = c; break;
+            }
+            m_ColorManifolds[color].push_back(m);
+        }
+
+        m_Batches.clear(); m_Colors.clear();
+        for (uint32_t c = 0; c < MaxColors; ++c) {
+            const auto& list = m_ColorManifolds[c];
+            if (list.empty()) continue;
+            uint32_t begin = (uint32_t)m_Batches.size();
+            for (size_t k = 0; k < list.size(); ++k) {
+                if (k % W == 0) m_Batches.emplace_back();
+                pack(list[k]);
+            }
+            m_Colors.push_back({ begin, (uint32_t)m_Batches.size() });
+        }
+        m_OverflowBegin = (uint32_t)m_Batches.size();
+        for (uint32_t m : m_ColorManifolds[MaxColors]) {
+            m_Batches.emplace_back();
+            pack(m);
+        }
+    }
+
+    // One pass over every batch; `soft` selects the rows' soft normal target
+    // and `block` solves the rigid normals of each manifold together (see
+    // SolveNormalBlock). Returns whether no row changed its relative velocity
+    // by more than `tolerance`.
+    bool SolveIteration(BodyStore& S, ThreadPool& pool, bool soft = false, float tolerance = 0.0f, bool block = false) {
+        const FloatW tol = FloatW::Splat(tolerance);
+        for (const auto& [begin, end] : m_Colors) {
+            uint32_t tasks = (end - begin + BatchesPerTask - 1) / BatchesPerTask;
+            pool.ParallelFor(tasks, [&, begin = begin, end = end](uint32_t t, uint32_t) {
+                uint32_t b0 = begin + t * BatchesPerTask, b1 = std::min(end, b0 + BatchesPerTask);
+                for (uint32_t k = b0; k < b1; ++k) SolveBatch(S, m_Batches[k], soft, block, tol);
+                });
+        }
+        for (uint32_t k = m_OverflowBegin; k < (uint32_t)m_Batches.size(); ++k) SolveBatch(S, m_Batches[k], soft, block, tol);
+
+        bool settled = true;
+        for (const Batch& b : m_Batches) settled = settled && b.Settled;
+        return settled;
+    }
+
+    // Copies the accumulated impulses back into the manifolds for the cache.
+    void StoreImpulses(std::vector<Manifold>& contacts) const {
+        for (const Batch& b : m_Batches) {
+            for (uint32_t lane = 0; lane < b.Lanes; ++lane) {
+                Manifold& man = contacts[b.Manifold[lane]];
+                for (uint32_t p = 0; p < man.Contacts.size(); ++p) {
+                    ContactPoint& c = man.Contacts[p];
+                    c.NormalImpulse = b.Rows[p].Normal.Impulse[lane];
+                    c.TangentImpulse0 = b.Rows[p].Tangent0.Impulse[lane];
+                    c.TangentImpulse1 = b.Rows[p].Tangent1.Impulse[lane];
+                }
+            }
+        }
+    }
+
+    uint32_t ColorCount() const { return (uint32_t)m_Colors.size(); }
+    uint32_t OverflowCount() const { return (uint32_t)m_Batches.size() - m_OverflowBegin; }
+
+private:
+    // ContactAxis / ContactRow with one manifold per lane.
+    struct AxisRow {
+        Vec3W  RAxAxis, RBxAxis;
+        Vec3W  AngularA, AngularB;
+        FloatW Mass;                 // 0 in empty lanes
+        FloatW Impulse;
+    };
+    struct PointRow {
+        AxisRow Normal, Tangent0, Tangent1;
+        FloatW  Bias, SoftBias, MassScale, ImpulseScale;
+    };
+
+    // Lanes past `Lanes` and points past a lane's contact count are zero, so
+    // they solve to a zero impulse without masking.
+    struct Batch {
+        uint32_t Lanes = 0, Points = 0;
+        uint32_t PointCount[W];    // contact points of each lane
+        bool     Settled = true;   // no lane changed by more than the tolerance in the last pass
+        uint32_t Manifold[W], BodyA[W], BodyB[W];
+        bool     WriteA[W], WriteB[W];
+        Vec3W    Normal, Tangent0, Tangent1;
+        FloatW   InvMassA, InvMassB, Friction;
+        PointRow Rows[MaxPoints];
+    };
+
+    std::array<std::vector<uint64_t>, MaxColors>     m_ColorBodies;      // per color, bit per awake body
+    std::array<std::vector<uint32_t>, MaxColors + 1> m_ColorManifolds;   // the last list overflows
+    std::vector<Batch>                               m_Batches;
+    std::vector<std::pair<uint32_t, uint32_t>>       m_Colors;           // batch range of each color
+    uint32_t                                         m_OverflowBegin = 0;
+
+    static void PackAxis(AxisRow& w, int lane, const ContactAxis& r) {
+        w.RAxAxis.Set(lane, r.RAxAxis); w.RBxAxis.Set(lane, r.RBxAxis);
+        w.AngularA.Set(lane, r.AngularA); w.AngularB.Set(lane, r.AngularB);
+        w.Mass[lane] = r.Mass; w.Impulse[lane] = r.Impulse;
+    }
+
+    static void Pack(Batch& b, const Manifold& man, const ContactRow* rows, uint32_t index) {
+        const int lane = (int)b.Lanes++;
+        b.Manifold[lane] = index; b.BodyA[lane] = man.BodyA; b.BodyB[lane] = man.BodyB;
+        const uint32_t points = man.Contacts.size();
+        b.PointCount[lane] = points;
+        if (points == 0) return;
+        const ContactRow& r0 = rows[0];
+        b.WriteA[lane] = r0.InvMassA > 0.0f; b.WriteB[lane] = r0.InvMassB > 0.0f;
+        b.InvMassA[lane] = r0.InvMassA; b.InvMassB[lane] = r0.InvMassB;
+        b.Friction[lane] = r0.Friction;
+        b.Normal.Set(lane, r0.Normal); b.Tangent0.Set(lane, r0.Tangent0); b.Tangent1.Set(lane, r0.Tangent1);
+        b.Points = std::max(b.Points, points);
+        for (uint32_t p = 0; p < points; ++p) {
+            PackAxis(b.Rows[p].Normal, lane, rows[p].N);
+            PackAxis(b.Rows[p].Tangent0, lane, rows[p].T0);
+            PackAxis(b.Rows[p].Tangent1, lane, rows[p].T1);
+            b.Rows[p].Bias[lane] = rows[p].Bias;
+            b.Rows[p].SoftBias[lane] = rows[p].SoftBias;
+            b.Rows[p].MassScale[lane] = rows[p].MassScale;
+            b.Rows[p].ImpulseScale[lane] = rows[p].ImpulseScale;
+        }
+    }
+
+    // `Excess` tracks the largest impulse change beyond what the tolerance
+    // allows for each axis's effective mass; a lane settles when it stays
+    // at or below zero.
+    struct Velocities { Vec3W VA, WA, VB, WB; FloatW Excess; };
+
+    // Solves one axis toward relative velocity `target`, clamping the
+    // accumulated impulse to [lo, hi], and applies the change to `v`.
+    static void SolveAxis(AxisRow& r, const Vec3W& axis, FloatW target, FloatW lo, FloatW hi,
+        const Batch& b, Velocities& v, FloatW tol)
+    {
+        FloatW vRel = Dot(axis, v.VB) - Dot(axis, v.VA) + Dot(r.RBxAxis, v.WB) - Dot(r.RAxAxis, v.WA);
+        Apply(r, axis, r.Impulse + r.Mass * (target - vRel), lo, hi, b, v, tol);
+    }
+
+    static void SolveSoftAxis(AxisRow& r, const Vec3W& axis, const PointRow& row, FloatW lo, FloatW hi,
+        const Batch& b, Velocities& v, FloatW tol)
+    {
+        FloatW vRel = Dot(axis, v.VB) - Dot(axis, v.VA) + Dot(r.RBxAxis, v.WB) - Dot(r.RAxAxis, v.WA);
+        FloatW old = r.Impulse;
+        Apply(r, axis, old + row.MassScale * r.Mass * (row.SoftBias - vRel) - row.ImpulseScale * old, lo, hi, b, v, tol);
+    }
+
+    static void Apply(AxisRow& r, const Vec3W& axis, FloatW impulse, FloatW lo, FloatW hi,
+        const Batch& b, Velocities& v, FloatW tol)
+    {
+        FloatW old = r.Impulse;
+        r.Impulse = Min(Max(impulse, lo), hi);
+        FloatW d = r.Impulse - old;
+        v.VA -= axis * (d * b.InvMassA); v.WA -= r.AngularA * d;
+        v.VB += axis * (d * b.InvMassB); v.WB += r.AngularB * d;
+        v.Excess = Max(v.Excess, Max(d, -d) - tol * r.Mass);
+    }
+
+    // The rigid normal rows of every lane solved as one block. K and the
+    // velocities the rows would have without their impulses (w0) are formed
+    // lane-parallel; the enumeration runs lane by lane, as its branches
+    // differ between lanes.
+    static void SolveNormalBlocks(Batch& b, Velocities& v, FloatW tol) {
+        const uint32_t n = b.Points;
+        FloatW K[MaxPoints][MaxPoints], w0[MaxPoints], x[MaxPoints];
+        for (uint32_t i = 0; i < n; ++i) {
+            const AxisRow& r = b.Rows[i].Normal;
+            w0[i] = Dot(b.Normal, v.VB) - Dot(b.Normal, v.VA) + Dot(r.RBxAxis, v.WB) - Dot(r.RAxAxis, v.WA) - b.Rows[i].Bias;
+            for (uint32_t j = 0; j < n; ++j)
+                K[i][j] = b.InvMassA + b.InvMassB + Dot(r.RAxAxis, b.Rows[j].Normal.AngularA) + Dot(r.RBxAxis, b.Rows[j].Normal.AngularB);
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            x[i] = b.Rows[i].Normal.Impulse;
+            for (uint32_t j = 0; j < n; ++j) w0[i] -= K[i][j] * b.Rows[j].Normal.Impulse;
+        }
+        for (uint32_t lane = 0; lane < b.Lanes; ++lane) {
+            const uint32_t count = b.PointCount[lane];
+            float Kl[MaxPoints][MaxPoints], bl[MaxPoints], xl[MaxPoints];
+            for (uint32_t i = 0; i < count; ++i) {
+                bl[i] = w0[i][lane]; xl[i] = x[i][lane];
+                for (uint32_t j = 0; j < count; ++j) Kl[i][j] = K[i][j][lane];
+            }
+            SolveNormalBlock(Kl, bl, count, xl);
+            for (uint32_t i = 0; i < count; ++i) x[i][lane] = xl[i];
+        }
+        const FloatW zero = FloatW::Splat(0.0f), inf = FloatW::Splat(FLT_MAX);
+        for (uint32_t i = 0; i < n; ++i) Apply(b.Rows[i].Normal, b.Normal, x[i], zero, inf, b, v, tol);
+    }
+
+    static void SolveBatch(BodyStore& S, Batch& b, bool soft, bool block, FloatW tol) {
+        Velocities v{};
+        v.Excess = FloatW::Splat(-FLT_MAX);
+        for (uint32_t lane = 0; lane < b.Lanes; ++lane) {
+            v.VA.Set(lane, S.LinearVelocity[b.BodyA[lane]]); v.WA.Set(lane, S.AngularVelocity[b.BodyA[lane]]);
+            v.VB.Set(lane, S.LinearVelocity[b.BodyB[lane]]); v.WB.Set(lane, S.AngularVelocity[b.BodyB[lane]]);
+        }
+
+        const FloatW zero = FloatW::Splat(0.0f), inf = FloatW::Splat(FLT_MAX);
+        const bool blockNormals = block && !soft;
+        if (blockNormals) SolveNormalBlocks(b, v, tol);
+        for (uint32_t p = 0; p < b.Points; ++p) {
+            PointRow& row = b.Rows[p];
+            if (soft) SolveSoftAxis(row.Normal, b.Normal, row, zero, inf, b, v, tol);
+            else if (!blockNormals) SolveAxis(row.Normal, b.Normal, row.Bias, zero, inf, b, v, tol);
+            FloatW maxF = b.Friction * row.Normal.Impulse;
+            SolveAxis(row.Tangent0, b.Tangent0, zero, -maxF, maxF, b, v, tol);
+            SolveAxis(row.Tangent1, b.Tangent1, zero, -maxF, maxF, b, v, tol);
+        }
+
+        b.Settled = true;
+        for (uint32_t lane = 0; lane < b.Lanes; ++lane) b.Settled = b.Settled && v.Excess[lane] <= 0.0f;
+
+        for (uint32_t lane = 0; lane < b.Lanes; ++lane) {
+            if (b.WriteA[lane]) { S.LinearVelocity[b.BodyA[lane]] = v.VA.Get(lane); S.AngularVelocity[b.BodyA[lane]] = v.WA.Get(lane); }
+            if (b.WriteB[lane]) { S.LinearVelocity[b.BodyB[lane]] = v.VB.Get(lane); S.AngularVelocity[b.BodyB[lane]] = v.WB.Get(lane); }
+        }
+    }
+};
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Shape.h"
+
+// Convex polytope given by the hull of a point cloud, for dynamic bodies
+// whose render mesh is too detailed to collide with directly. The hull is
+// built once, with coplanar triangles merged into polygonal faces, so a
+// flat side presents all of its corners to the contact clipper instead of
+// the two halves of a quad.
+//
+// Mass properties are taken about the local origin, which is where the body
+// rotates; meshes are expected to be authored around their center.
+struct ConvexHullShape : public Shape {
+    struct Face {
+        glm::vec3 Normal;     // outward, unit length
+        float     Offset;     // dot(Normal, v) for the face's vertices
+        uint32_t  First;      // into FaceVertices
+        uint32_t  Count;
+    };
+
+    std::vector<glm::vec3> Vertices;
+    std::vector<Face>      Faces;
+    std::vector<uint32_t>  FaceVertices;   // counter-clockwise seen from outside
+
+    // `scale` is baked into the points, since bodies carry no scale of their own.
+    explicit ConvexHullShape(const std::vector<glm::vec3>& points, const glm::vec3& scale = glm::vec3(1.0f)) {
+        Type = ShapeType::ConvexHull;
+        std::vector<glm::vec3> scaled(points.size());
+        for (size_t i = 0; i < points.size(); ++i) scaled[i] = points[i] * scale;
+        Build(scaled);
+        for (const glm::vec3& v : Vertices) { m_Bounds.Min = glm::min(m_Bounds.Min, v); m_Bounds.Max = glm::max(m_Bounds.Max, v); }
+        ComputeMassProperties();
+        BuildAdjacency();
+    }
+
+    // The corners of the hull of `points`. Mesh assets compute these once,
+    // when a convex collider first asks, so colliders are built from a
+    // handful of points, not every vertex of the render mesh.
+    static std::vector<glm::vec3> ComputeHullVertices(const std::vector<glm::vec3>& points) {
+        return ConvexHullShape(points).Vertices;
+    }
+
+    AABB ComputeLocalAABB() const override { return m_Bounds; }
+
+    glm::mat3 ComputeInertiaTensor(float mass) const override {
+        if (!(m_Volume > 0.0f)) return glm::mat3(0.0f);
+        float tr = m_Covariance[0][0] + m_Covariance[1][1] + m_Covariance[2][2];
+        return (mass / m_Volume) * (glm::mat3(tr) - m_Covariance);
+    }
+
+    // Small hulls are scanned. Larger ones climb the vertex graph from the
+    // first vertex: on a convex polytope the first vertex with no better
+    // neighbor is the support point.
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        if (Vertices.size() <= ClimbThreshold) {
+            glm::vec3 best(0.0f); float bestD = -FLT_MAX;
+            for (const glm::vec3& v : Vertices) { float d = glm::dot(v, dir); if (d > bestD) { bestD = d; best = v; } }
+            return best;
+        }
+        uint32_t cur = 0; float curD = glm::dot(Vertices[0], dir);
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (uint32_t k = m_NeighborFirst[cur]; k < m_NeighborFirst[cur + 1]; ++k) {
+                float d = glm::dot(Vertices[m_Neighbors[k]], dir);
+                if (d > curD) { curD = d; cur = m_Neighbors[k]; moved = true; break; }
+            }
+        }
+        return Vertices[cur];
+    }
+
+    void GetLocalSupportFace(const glm::vec3& dir, SupportFace& out) const override {
+        out.clear();
+        if (Faces.empty()) { out.push_back(GetLocalSupport(dir)); return; }
+        uint32_t best = 0; float bestD = -FLT_MAX;
+        for (uint32_t f = 0; f < Faces.size(); ++f) {
+            float d = glm::dot(Faces[f].Normal, dir);
+            if (d > bestD) { bestD = d; best = f; }
+        }
+        // Faces with more corners than a support face holds keep an evenly
+        // spread subset, which is still convex and wound the same way.
+        const Face& f = Faces[best];
+        const uint32_t n = std::min(f.Count, MaxSupportFaceVertices);
+        for (uint32_t k = 0; k < n; ++k) out.push_back(Vertices[FaceVertices[f.First + k * f.Count / n]]);
+    }
+
+    float ComputeVolume() const override { return m_Volume; }
+
+private:
+    static constexpr size_t ClimbThreshold = 32;
+
+    std::vector<uint32_t> m_NeighborFirst;   // vertex i's neighbors are m_Neighbors[m_NeighborFirst[i], m_NeighborFirst[i + 1])
+    std::vector<uint32_t> m_Neighbors;
+    AABB      m_Bounds;
+    float     m_Volume = 0.0f;
+    glm::mat3 m_Covariance{ 0.0f };   // integral of x x^T over the hull
+
+    struct Tri {
+        uint32_t              V[3];
+        glm::vec3             N;
+        float                 D;
+        bool                  Live = true;
+        std::vector<uint32_t> Conflict;   // points in front of the triangle
+    };
+
+    static uint64_t EdgeKey(uint32_t a, uint32_t b) { return (uint64_t(a) << 32) | b; }
+
+    // Incremental quickhull over triangles, then coplanar triangles are
+    // merged into faces. Inputs with no volume become a thin box.
+    void Build(const std::vector<glm::vec3>& pts) {
+        if (pts.empty()) { BuildBox({ glm::vec3(0.0f), glm::vec3(0.0f) }); return; }
+        AABB box;
+        for (const glm::vec3& p : pts) { box.Min = glm::min(box.Min, p); box.Max = glm::max(box.Max, p); }
+        const glm::vec3 ext = box.Max - box.Min;
+        const float eps = 1e-5f * std::max({ ext.x, ext.y, ext.z, 1e-6f });
+
+        // Initial tetrahedron from extreme points.
+        uint32_t i0 = 0, i1 = 0;
+        float bestD = -1.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            uint32_t lo = 0, hi = 0;
+            for (uint32_t i = 0; i < pts.size(); ++i) {
+                if (pts[i][axis] < pts[lo][axis]) lo = i;
+                if (pts[i][axis] > pts[hi][axis]) hi = i;
+            }
+            float d = pts[hi][axis] - pts[lo][axis];
+            if (d > bestD) { bestD = d; i0 = lo; i1 = hi; }
+        }
+        const glm::vec3 dir = pts[i1] - pts[i0];
+        uint32_t i2 = i0; bestD = 0.0f;
+        for (uint32_t i = 0; i < pts.size(); ++i) {
+            glm::vec3 c = glm::cross(dir, pts[i] - pts[i0]);
+            float d = glm::dot(c, c);
+            if (d > bestD) { bestD = d; i2 = i; }
+        }
+        const glm::vec3 n012 = glm::cross(dir, pts[i2] - pts[i0]);
+        uint32_t i3 = i0; bestD = 0.0f;
+        for (uint32_t i = 0; i < pts.size(); ++i) {
+            float d = std::abs(glm::dot(n012, pts[i] - pts[i0]));
+            if (d > bestD) { bestD = d; i3 = i; }
+        }
+        const float len012 = std::sqrt(glm::dot(n012, n012));
+        if (glm::dot(dir, dir) <= eps * eps || len012 <= eps * std::sqrt(glm::dot(dir, dir)) || bestD <= eps * len012) {
+            BuildBox(box);
+            return;
+        }
+
+        std::vector<Tri> tris;
+        std::unordered_map<uint64_t, uint32_t> edges;   // directed edge -> triangle holding it
+        auto addTri = [&](uint32_t a, uint32_t b, uint32_t c) {
+            Tri t;
+            t.V[0] = a; t.V[1] = b; t.V[2] = c;
+            t.N = glm::normalize(glm::cross(pts[b] - pts[a], pts[c] - pts[a]));
+            t.D = glm::dot(t.N, pts[a]);
+            const uint32_t id = (uint32_t)tris.size();
+            edges[EdgeKey(a, b)] = id; edges[EdgeKey(b, c)] = id; edges[EdgeKey(c, a)] = id;
+            tris.push_back(std::move(t));
+            return id;
+        };
+
+        const glm::vec3 centroid = (pts[i0] + pts[i1] + pts[i2] + pts[i3]) * 0.25f;
+        const uint32_t tet[4][3] = { { i0, i1, i2 }, { i0, i3, i1 }, { i0, i2, i3 }, { i1, i3, i2 } };
+        for (const auto& t : tet) {
+            glm::vec3 n = glm::cross(pts[t[1]] - pts[t[0]], pts[t[2]] - pts[t[0]]);
+            if (glm::dot(n, pts[t[0]] - centroid) >= 0.0f) addTri(t[0], t[1], t[2]);
+            else addTri(t[0], t[2], t[1]);
+        }
+
+        auto assign = [&](uint32_t p, const uint32_t* cands, size_t count) {
+            for (size_t k = 0; k < count; ++k) {
+                Tri& t = tris[cands[k]];
+                if (glm::dot(t.N, pts[p]) - t.D > eps) { t.Conflict.push_back(p); return; }
+            }
+        };
+        const uint32_t first[4] = { 0, 1, 2, 3 };
+        for (uint32_t p = 0; p < pts.size(); ++p) {
+            if (p == i0 || p == i1 || p == i2 || p == i3) continue;
+            assign(p, first, 4);
+        }
+
+        std::vector<uint32_t> visible, stack, created, orphans;
+        std::vector<std::pair<uint32_t, uint32_t>> horizon;
+        std::vector<uint8_t> mark;
+        for (uint32_t cur = 0; cur < tris.size(); ++cur) {
+            if (!tris[cur].Live || tris[cur].Conflict.empty()) continue;
+
+            uint32_t eye = tris[cur].Conflict[0]; float farthest = -FLT_MAX;
+            for (uint32_t p : tris[cur].Conflict) {
+                float d = glm::dot(tris[cur].N, pts[p]) - tris[cur].D;
+                if (d > farthest) { farthest = d; eye = p; }
+            }
+
+            // Flood the triangles the eye sees; edges to unseen ones form the horizon.
+            mark.assign(tris.size(), 0);
+            visible.clear(); horizon.clear();
+            stack.assign(1, cur); mark[cur] = 1;
+            while (!stack.empty()) {
+                uint32_t t = stack.back(); stack.pop_back();
+                visible.push_back(t);
+                for (int e = 0; e < 3; ++e) {
+                    uint32_t a = tris[t].V[e], b = tris[t].V[(e + 1) % 3];
+                    uint32_t nb = edges.at(EdgeKey(b, a));
+                    if (mark[nb] == 1) continue;
+                    if (mark[nb] == 0 && glm::dot(tris[nb].N, pts[eye]) - tris[nb].D > eps) {
+                        mark[nb] = 1;
+                        stack.push_back(nb);
+                    }
+                    else {
+                        mark[nb] = 2;
+                    }
+                }
+            }
+            for (uint32_t t : visible) {
+                for (int e = 0; e < 3; ++e) {
+                    uint32_t a = tris[t].V[e], b = tris[t].V[(e + 1) % 3];
+                    if (mark[edges.at(EdgeKey(b, a))] != 1) horizon.push_back({ a, b });
+                }
+            }
+
+            orphans.clear();
+            for (uint32_t t : visible) {
+                Tri& tr = tris[t];
+                tr.Live = false;
+                for (uint32_t p : tr.Conflict) if (p != eye) orphans.push_back(p);
+                tr.Conflict.clear();
+                tr.Conflict.shrink_to_fit();
+                for (int e = 0; e < 3; ++e) {
+                    auto it = edges.find(EdgeKey(tr.V[e], tr.V[(e + 1) % 3]));
+                    if (it != edges.end() && it->second == t) edges.erase(it);
+                }
+            }
+            created.clear();
+            for (const auto& h : horizon) created.push_back(addTri(h.first, h.second, eye));
+            for (uint32_t p : orphans) assign(p, created.data(), created.size());
+        }
+
+        MergeFaces(pts, tris, edges);
+    }
+
+    // Groups live triangles whose normals agree within about a degree and
+    // turns each group's boundary into one polygon.
+    void MergeFaces(const std::vector<glm::vec3>& pts, const std::vector<Tri>& tris,
+        const std::unordered_map<uint64_t, uint32_t>& edges)
+    {
+        std::vector<int> group(tris.size(), -1);
+        std::unordered_map<uint32_t, uint32_t> remap;
+        auto vertex = [&](uint32_t p) {
+            auto it = remap.find(p);
+            if (it != remap.end()) return it->second;
+            uint32_t id = (uint32_t)Vertices.size();
+            Vertices.push_back(pts[p]);
+            remap.emplace(p, id);
+            return id;
+        };
+        auto emit = [&](const std::vector<uint32_t>& loop) {
+            if (loop.size() < 3) return;
+            glm::vec3 n(0.0f);
+            for (size_t k = 0; k < loop.size(); ++k) {
+                const glm::vec3& a = pts[loop[k]], & b = pts[loop[(k + 1) % loop.size()]];
+                n += glm::vec3((a.y - b.y) * (a.z + b.z), (a.z - b.z) * (a.x + b.x), (a.x - b.x) * (a.y + b.y));
+            }
+            n = glm::normalize(n);
+            Face f{ n, -FLT_MAX, (uint32_t)FaceVertices.size(), (uint32_t)loop.size() };
+            for (uint32_t p : loop) { FaceVertices.push_back(vertex(p)); f.Offset = std::max(f.Offset, glm::dot(n, pts[p])); }
+            Faces.push_back(f);
+        };
+
+        std::vector<uint32_t> members, stack, loop;
+        std::unordered_map<uint32_t, uint32_t> next;
+        for (uint32_t seed = 0; seed < tris.size(); ++seed) {
+            if (!tris[seed].Live || group[seed] >= 0) continue;
+            members.clear();
+            stack.assign(1, seed); group[seed] = (int)seed;
+            while (!stack.empty()) {
+                uint32_t t = stack.back(); stack.pop_back();
+                members.push_back(t);
+                for (int e = 0; e < 3; ++e) {
+                    uint32_t nb = edges.at(EdgeKey(tris[t].V[(e + 1) % 3], tris[t].V[e]));
+                    if (group[nb] < 0 && glm::dot(tris[nb].N, tris[seed].N) >= 0.99985f) { group[nb] = (int)seed; stack.push_back(nb); }
+                }
+            }
+
+            next.clear();
+            size_t boundary = 0;
+            bool simple = true;
+            for (uint32_t t : members) {
+                for (int e = 0; e < 3; ++e) {
+                    uint32_t a = tris[t].V[e], b = tris[t].V[(e + 1) % 3];
+                    if (group[edges.at(EdgeKey(b, a))] == (int)seed) continue;
+                    simple &= next.emplace(a, b).second;
+                    ++boundary;
+                }
+            }
+            loop.clear();
+            if (simple && !next.empty()) {
+                uint32_t start = next.begin()->first, v = start;
+                do { loop.push_back(v); v = next[v]; } while (v != start && loop.size() <= boundary);
+                simple = v == start && loop.size() == boundary;
+            }
+            if (!simple) {
+                // A pinched boundary; keep the triangles as separate faces.
+                for (uint32_t t : members) emit({ tris[t].V[0], tris[t].V[1], tris[t].V[2] });
+                continue;
+            }
+
+            // Corners between collinear boundary edges are not corners.
+            std::vector<uint32_t> corners;
+            for (size_t k = 0; k < loop.size(); ++k) {
+                const glm::vec3& p = pts[loop[(k + loop.size() - 1) % loop.size()]];
+                const glm::vec3& c = pts[loop[k]];
+                const glm::vec3& n = pts[loop[(k + 1) % loop.size()]];
+                glm::vec3 e0 = c - p, e1 = n - c;
+                glm::vec3 x = glm::cross(e0, e1);
+                if (glm::dot(x, x) > 1e-10f * glm::dot(e0, e0) * glm::dot(e1, e1)) corners.push_back(loop[k]);
+            }
+            emit(corners);
+        }
+    }
+
+    void BuildBox(AABB box) {
+        // Pad flat or empty input to a minimum thickness so the box has volume.
+        const glm::vec3 c = (box.Min + box.Max) * 0.5f;
+        const glm::vec3 h = glm::max((box.Max - box.Min) * 0.5f, glm::vec3(0.005f));
+        for (int i = 0; i < 8; ++i)
+            Vertices.push_back(c + glm::vec3(i & 1 ? h.x : -h.x, i & 2 ? h.y : -h.y, i & 4 ? h.z : -h.z));
+        // Corner indices of each face, counter-clockwise seen from outside.
+        static const uint32_t quads[6][4] = {
+            { 1, 3, 7, 5 }, { 0, 4, 6, 2 }, { 2, 6, 7, 3 }, { 0, 1, 5, 4 }, { 4, 5, 7, 6 }, { 0, 2, 3, 1 }
+        };
+        static const glm::vec3 normals[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        for (int f = 0; f < 6; ++f) {
+            Faces.push_back({ normals[f], glm::dot(normals[f], Vertices[quads[f][0]]), (uint32_t)FaceVertices.size(), 4 });
+            for (uint32_t v : quads[f]) FaceVertices.push_back(v);
+        }
+    }
+
+    void BuildAdjacency() {
+        std::vector<std::vector<uint32_t>> adj(Vertices.size());
+        for (const Face& f : Faces) {
+            // Every corner of a face, not only the next one: merged faces are
+            // flat only within a tolerance, and a climb must be able to cross them.
+            for (uint32_t k = 0; k < f.Count; ++k) {
+                for (uint32_t j = k + 1; j < f.Count; ++j) {
+                    uint32_t a = FaceVertices[f.First + k], b = FaceVertices[f.First + j];
+                    if (std::find(adj[a].begin(), adj[a].end(), b) == adj[a].end()) { adj[a].push_back(b); adj[b].push_back(a); }
+                }
+            }
+        }
+        m_NeighborFirst.assign(1, 0);
+        for (const auto& n : adj) {
+            m_Neighbors.insert(m_Neighbors.end(), n.begin(), n.end());
+            m_NeighborFirst.push_back((uint32_t)m_Neighbors.size());
+        }
+    }
+
+    // Volume and second moment from the tetrahedra between the origin and
+    // a fan of every face; signed volumes make the origin's position moot.
+    void ComputeMassProperties() {
+        const glm::mat3 canonical = glm::mat3(2, 1, 1, 1, 2, 1, 1, 1, 2) * (1.0f / 120.0f);
+        for (const Face& f : Faces) {
+            const glm::vec3& a = Vertices[FaceVertices[f.First]];
+            for (uint32_t k = 1; k + 1 < f.Count; ++k) {
+                const glm::vec3& b = Vertices[FaceVertices[f.First + k]];
+                const glm::vec3& c = Vertices[FaceVertices[f.First + k + 1]];
+                glm::mat3 A(a, b, c);
+                float det = glm::dot(a, glm::cross(b, c));
+                m_Volume += det / 6.0f;
+                m_Covariance += det * (A * canonical * glm::transpose(A));
+            }
+        }
+    }
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+
+#include "AABB.h"
+
+// Incrementally maintained bounding volume hierarchy. Leaves store "fat"
+// AABBs (enlarged by a margin and the predicted displacement, computed by the
+// caller) so a proxy only has to be reinserted once its tight bounds escape
+// the fat ones. The tree is kept balanced with AVL-style rotations on the way
+// back up from insert/remove.
+class DynamicAABBTree {
+public:
+    static constexpr int32_t Null = -1;
+
+    int32_t CreateProxy(const AABB& fatAABB, uint32_t userData) {
+        int32_t id = AllocateNode();
+        m_Nodes[id].Box = fatAABB;
+        m_Nodes[id].UserData = userData;
+        m_Nodes[id].Height = 0;
+        InsertLeaf(id);
+        ++m_ProxyCount;
+        return id;
+    }
+
+    void DestroyProxy(int32_t id) {
+        RemoveLeaf(id);
+        FreeNode(id);
+        --m_ProxyCount;
+    }
+
+    // Reinserts the proxy with new fat bounds. Callers only do this once the
+    // tight bounds have left the old fat AABB.
+    void MoveProxy(int32_t id, const AABB& fatAABB) {
+        RemoveLeaf(id);
+        m_Nodes[id].Box = fatAABB;
+        InsertLeaf(id);
+    }
+
+    uint32_t GetUserData(int32_t id) const { return m_Nodes[id].UserData; }
+    const AABB& GetFatAABB(int32_t id) const { return m_Nodes[id].Box; }
+    int32_t GetHeight() const { return m_Root == Null ? 0 : m_Nodes[m_Root].Height; }
+    int32_t GetProxyCount() const { return m_ProxyCount; }
+
+    // Calls cb(proxyId) for every leaf whose fat AABB overlaps `aabb`.
+    // The callback returns false to stop the traversal early. The tree is AVL
+    // balanced, so the traversal depth stays far below the fixed stack size.
+    template<typename F>
+    void Query(const AABB& aabb, F&& cb) const {
+        if (m_Root == Null) return;
+        std::array<int32_t, 256> stack; int sp = 0;
+        stack[sp++] = m_Root;
+        while (sp > 0) {
+            int32_t id = stack[--sp];
+            const Node& n = m_Nodes[id];
+            if (!n.Box.Overlaps(aabb)) continue;
+            if (n.IsLeaf()) { if (!cb(id)) return; }
+            else if (sp + 2 <= (int)stack.size()) { stack[sp++] = n.Child1; stack[sp++] = n.Child2; }
+        }
+    }
+
+private:
+    struct Node {
+        AABB    Box;
+        uint32_t UserData = 0;
+        int32_t Parent = Null;   // doubles as the free-list link
+        int32_t Child1 = Null;
+        int32_t Child2 = Null;
+        int32_t Height = -1;     // leaf = 0, free = -1
+        bool IsLeaf() const { return Child1 == Null; }
+    };
+
+    std::vector<Node> m_Nodes;
+    int32_t m_Root = Null;
+    int32_t m_FreeList = Null;
+    int32_t m_ProxyCount = 0;
+
+    int32_t AllocateNode() {
+        if (m_FreeList == Null) {
+            m_Nodes.emplace_back();
+            m_FreeList = int32_t(m_Nodes.size()) - 1;
+            m_Nodes[m_FreeList].Parent = Null;
+        }
+        int32_t id = m_FreeList;
+        m_FreeList = m_Nodes[id].Parent;
+        m_Nodes[id] = Node{};
+        m_Nodes[id].Height = 0;
+        return id;
+    }
+
+    void FreeNode(int32_t id) {
+        m_Nodes[id].Parent = m_FreeList;
+        m_Nodes[id].Height = -1;
+        m_FreeList = id;
+    }
+
+    void InsertLeaf(int32_t leaf) {
+        if (m_Root == Null) { m_Root = leaf; m_Nodes[leaf].Parent = Null; return; }
+
+        // Descend choosing the child with the lowest surface area cost.
+        AABB leafBox = m_Nodes[leaf].Box;
+        int32_t idx = m_Root;
+        while (!m_Nodes[idx].IsLeaf()) {
+            const Node& n = m_Nodes[idx];
+            float area = n.Box.SurfaceArea();
+            float combined = AABB::Union(n.Box, leafBox).SurfaceArea();
+            float cost = 2.0f * combined;
+            float inherit = 2.0f * (combined - area);
+
+            auto childCost = [&](int32_t c) {
+                AABB u = AABB::Union(leafBox, m_Nodes[c].Box);
+                return m_Nodes[c].IsLeaf()
+                    ? u.SurfaceArea() + inherit
+                    : u.SurfaceArea() - m_Nodes[c].Box.SurfaceArea() + inherit;
+            };
+            float c1 = childCost(n.Child1), c2 = childCost(n.Child2);
+            if (cost < c1 && cost < c2) break;
+            idx = (c1 < c2) ? n.Child1 : n.Child2;
+        }
+
+        int32_t sibling = idx;
+        int32_t oldParent = m_Nodes[sibling].Parent;
+        int32_t newParent = AllocateNode();
+        m_Nodes[newParent].Parent = oldParent;
+        m_Nodes[newParent].Box = AABB::Union(leafBox, m_Nodes[sibling].Box);
+        m_Nodes[newParent].Height = m_Nodes[sibling].Height + 1;
+        m_Nodes[newParent].Child1 = sibling;
+        m_Nodes[newParent].Child2 = leaf;
+        m_Nodes[sibling].Parent = newParent;
+        m_Nodes[leaf].Parent = newParent;
+
+        if (oldParent != Null) {
+            if (m_Nodes[oldParent].Child1 == sibling) m_Nodes[oldParent].Child1 = newParent;
+            else m_Nodes[oldParent].Child2 = newParent;
+        }
+        else m_Root = newParent;
+
+        Refit(m_Nodes[leaf].Parent);
+    }
+
+    void RemoveLeaf(int32_t leaf) {
+        if (leaf == m_Root) { m_Root = Null; return; }
+
+        int32_t parent = m_Nodes[leaf].Parent;
+        int32_t grand = m_Nodes[parent].Parent;
+        int32_t sibling = (m_Nodes[parent].Child1 == leaf) ? m_Nodes[parent].Child2 : m_Nodes[parent].Child1;
+
+        if (grand != Null) {
+            if (m_Nodes[grand].Child1 == parent) m_Nodes[grand].Child1 = sibling;
+            else m_Nodes[grand].Child2 = sibling;
+            m_Nodes[sibling].Parent = grand;
+            FreeNode(parent);
+            Refit(grand);
+        }
+        else {
+            m_Root = sibling;
+            m_Nodes[sibling].Parent = Null;
+            FreeNode(parent);
+        }
+    }
+
+    // Walks from `idx` to the root, rebalancing and refitting bounds/heights.
+    void Refit(int32_t idx) {
+        while (idx != Null) {
+            idx = Balance(idx);
+            Node& n = m_Nodes[idx];
+            n.Height = 1 + std::max(m_Nodes[n.Child1].Height, m_Nodes[n.Child2].Height);
+            n.Box = AABB::Union(m_Nodes[n.Child1].Box, m_Nodes[n.Child2].Box);
+            idx = n.Parent;
+        }
+    }
+
+    // Performs a left or right rotation if node A is imbalanced.
+    // Returns the new root of the rotated subtree.
+    int32_t Balance(int32_t iA) {
+        Node& A = m_Nodes[iA];
+        if (A.IsLeaf() || A.Height < 2) return iA;
+
+        int32_t iB = A.Child1, iC = A.Child2;
+        int32_t balance = m_Nodes[iC].Height - m_Nodes[iB].Height;
+
+        if (balance > 1) return Rotate(iA, iC, iB, false);
+        if (balance < -1) return Rotate(iA, iB, iC, true);
+        return iA;
+    }
+
+    // Promotes the taller child `iUp` above `iA`; `iOther` is A's remaining child.
+    int32_t Rotate(int32_t iA, int32_t iUp, int32_t iOther, bool upIsChild1) {
+        Node& A = m_Nodes[iA];
+        Node& U = m_Nodes[iUp];
+        int32_t iF = U.Child1, iG = U.Child2;
+
+        U.Child1 = iA;
+        U.Parent = A.Parent;
+        A.Parent = iUp;
+
+        if (U.Parent != Null) {
+            if (m_Nodes[U.Parent].Child1 == iA) m_Nodes[U.Parent].Child1 = iUp;
+            else m_Nodes[U.Parent].Child2 = iUp;
+        }
+        else m_Root = iUp;
+
+        // Keep the taller grandchild under U, hand the other to A.
+        int32_t keep = iF, give = iG;
+        if (m_Nodes[iF].Height < m_Nodes[iG].Height) { keep = iG; give = iF; }
+
+        U.Child2 = keep;
+        if (upIsChild1) A.Child1 = give; else A.Child2 = give;
+        m_Nodes[give].Parent = iA;
+
+        A.Box = AABB::Union(m_Nodes[iOther].Box, m_Nodes[give].Box);
+        A.Height = 1 + std::max(m_Nodes[iOther].Height, m_Nodes[give].Height);
+        U.Box = AABB::Union(A.Box, m_Nodes[keep].Box);
+        U.Height = 1 + std::max(A.Height, m_Nodes[keep].Height);
+        return iUp;
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+// Vector with inline storage for up to N elements. It never allocates, so it
+// can live in per-step buffers such as manifolds and clip polygons. The
+// interface follows the subset of std::vector the physics code uses.
+template<typename T, uint32_t N>
+class FixedVector {
+public:
+    static constexpr uint32_t Capacity = N;
+
+    uint32_t size() const { return m_Size; }
+    bool     empty() const { return m_Size == 0; }
+    bool     full() const { return m_Size == N; }
+    void     clear() { m_Size = 0; }
+
+    void push_back(const T& v) { assert(m_Size < N); m_Items[m_Size++] = v; }
+    void pop_back() { assert(m_Size > 0); --m_Size; }
+
+    T&       operator[](uint32_t i) { return m_Items[i]; }
+    const T& operator[](uint32_t i) const { return m_Items[i]; }
+    T&       back() { return m_Items[m_Size - 1]; }
+
+    T*       begin() { return m_Items; }
+    T*       end() { return m_Items + m_Size; }
+    const T* begin() const { return m_Items; }
+    const T* end() const { return m_Items + m_Size; }
+
+private:
+    T        m_Items[N];
+    uint32_t m_Size = 0;
+};
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "FixedVector.h"
+
+// GJK and EPA over two support-mapped shapes. A shape is anything with
+//     glm::vec3 Support(const glm::vec3& dir) const;   // world space
+//     float Radius;
+// where Support describes the shape's core and Radius inflates it: a sphere
+// is a point core with its radius, polytopes have a radius of zero. GJK
+// finds the distance between the cores; only when they overlap does EPA
+// run, so curved shapes never reach the slowly converging polytope search.
+
+// A vertex of the Minkowski difference A - B with the support points that
+// produced it.
+struct GjkVertex {
+    glm::vec3 W, A, B;
+};
+
+using GjkSimplex = FixedVector<GjkVertex, 4>;
+
+// Barycentric weights of the point of triangle abc closest to the origin
+// (Ericson, Real-Time Collision Detection 5.1.5). Vertices that do not
+// support the point get a weight of zero.
+inline void TriangleWeights(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float w[3]) {
+    glm::vec3 ab = b - a, ac = c - a;
+    float d1 = -glm::dot(ab, a), d2 = -glm::dot(ac, a);
+    if (d1 <= 0.0f && d2 <= 0.0f) { w[0] = 1; w[1] = 0; w[2] = 0; return; }
+    float d3 = -glm::dot(ab, b), d4 = -glm::dot(ac, b);
+    if (d3 >= 0.0f && d4 <= d3) { w[0] = 0; w[1] = 1; w[2] = 0; return; }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) { float t = d1 / (d1 - d3); w[0] = 1 - t; w[1] = t; w[2] = 0; return; }
+    float d5 = -glm::dot(ab, c), d6 = -glm::dot(ac, c);
+    if (d6 >= 0.0f && d5 <= d6) { w[0] = 0; w[1] = 0; w[2] = 1; return; }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) { float t = d2 / (d2 - d6); w[0] = 1 - t; w[1] = 0; w[2] = t; return; }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) { float t = (d4 - d3) / ((d4 - d3) + (d5 - d6)); w[0] = 0; w[1] = 1 - t; w[2] = t; return; }
+    float den = va + vb + vc;
+    if (!(den > 1e-30f)) { w[0] = 1; w[1] = 0; w[2] = 0; return; }   // degenerate: any vertex is a valid start
+    w[1] = vb / den; w[2] = vc / den; w[0] = 1 - w[1] - w[2];
+}
+
+// Replaces the simplex by the smallest sub-simplex supporting its point
+// closest to the origin and returns that point; `lambda` receives the
+// weights of the remaining vertices. A full simplex is left in place when
+// it contains the origin.
+inline glm::vec3 ReduceSimplex(GjkSimplex& s, float lambda[4]) {
+    float w[4] = { 1, 0, 0, 0 };
+    switch (s.size()) {
+    case 2: {
+        glm::vec3 ab = s[1].W - s[0].W;
+        float len2 = glm::dot(ab, ab);
+        float t = len2 > 1e-30f ? std::clamp(-glm::dot(s[0].W, ab) / len2, 0.0f, 1.0f) : 0.0f;
+        w[0] = 1 - t; w[1] = t;
+        break;
+    }
+    case 3:
+        TriangleWeights(s[0].W, s[1].W, s[2].W, w);
+        break;
+    case 4: {
+        // The origin is outside a face if it lies across it from the
+        // opposite vertex; the closest point is on one of those faces.
+        static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 1, 3, 2 }, { 0, 2, 3, 1 }, { 1, 2, 3, 0 } };
+        float best = FLT_MAX;
+        bool outside = false;
+        for (const auto& f : faces) {
+            const glm::vec3& a = s[f[0]].W;
+            glm::vec3 n = glm::cross(s[f[1]].W - a, s[f[2]].W - a);
+            float sO = -glm::dot(n, a), sD = glm::dot(n, s[f[3]].W - a);
+            if (sD * sD <= 1e-12f * glm::dot(n, n) * glm::dot(s[f[3]].W - a, s[f[3]].W - a)) {
+                // Flat tetrahedron: continue from the face without the newest vertex.
+                s.pop_back();
+                return ReduceSimplex(s, lambda);
+            }
+            if (sO * sD >= 0.0f) continue;
+            outside = true;
+            float fw[3];
+            TriangleWeights(a, s[f[1]].W, s[f[2]].W, fw);
+            glm::vec3 p = a * fw[0] + s[f[1]].W * fw[1] + s[f[2]].W * fw[2];
+            float d = glm::dot(p, p);
+            if (d < best) { best = d; w[f[0]] = fw[0]; w[f[1]] = fw[1]; w[f[2]] = fw[2]; w[f[3]] = 0.0f; }
+        }
+        if (!outside) {
+            for (int i = 0; i < 4; ++i) lambda[i] = 0.25f;
+            return glm::vec3(0.0f);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    GjkSimplex kept;
+    glm::vec3 v(0.0f);
+    for (uint32_t i = 0; i < s.size(); ++i) {
+        if (w[i] <= 0.0f) continue;
+        lambda[kept.size()] = w[i];
+        kept.push_back(s[i]);
+        v += s[i].W * w[i];
+    }
+    s = kept;
+    return v;
+}
+
+struct GjkResult {
+    bool      Overlap = false;    // the cores intersect; the simplex encloses the origin
+    float     Distance = 0.0f;    // between the cores, or a lower bound past maxDistance
+    glm::vec3 PointA{ 0.0f }, PointB{ 0.0f };
+};
+
+// Distance between the cores of A and B. `simplex` may hold vertices from a
+// previous query, rebuilt from the same support points; the search then
+// starts next to the answer and usually ends after an iteration or two.
+// It is left holding the final simplex, for EPA or for the next query.
+// Stops as soon as the cores are known to be further apart than maxDistance.
+template<typename SA, typename SB>
+GjkResult GjkDistance(const SA& a, const SB& b, GjkSimplex& simplex, const glm::vec3& initialDir, float maxDistance) {
+    auto support = [&](const glm::vec3& d) { GjkVertex v; v.A = a.Support(d); v.B = b.Support(-d); v.W = v.A - v.B; return v; };
+
+    GjkResult r;
+    if (simplex.empty()) simplex.push_back(support(initialDir));
+    float lambda[4] = { 1, 0, 0, 0 };
+    glm::vec3 v(0.0f);
+    for (int iter = 0; iter < 32; ++iter) {
+        v = ReduceSimplex(simplex, lambda);
+        float vv = glm::dot(v, v);
+        if (simplex.full() || vv < 1e-12f) { r.Overlap = true; return r; }
+
+        GjkVertex w = support(-v);
+        float vw = glm::dot(v, w.W);
+        if (vw > 0.0f && vw * vw > maxDistance * maxDistance * vv) { r.Distance = vw / std::sqrt(vv); return r; }
+        bool repeated = vv - vw <= 1e-6f * vv;
+        for (const GjkVertex& s : simplex) repeated |= s.W == w.W;
+        if (repeated) break;
+        simplex.push_back(w);
+    }
+    for (uint32_t i = 0; i < simplex.size(); ++i) { r.PointA += simplex[i].A * lambda[i]; r.PointB += simplex[i].B * lambda[i]; }
+    r.Distance = std::sqrt(glm::dot(v, v));
+    return r;
+}
+
+// Expanding polytope algorithm: grows the simplex GJK left around the
+// origin toward the face of A - B nearest to it. Fills the normal (from A
+// to B), the depth, and the deepest points of both cores. Returns false if
+// the polytope degenerates, which only happens for flat or touching cores.
+template<typename SA, typename SB>
+bool Epa(const SA& a, const SB& b, const GjkSimplex& simplex, glm::vec3& normal, float& depth, glm::vec3& pointA, glm::vec3& pointB) {
+    auto support = [&](const glm::vec3& d) { GjkVertex v; v.A = a.Support(d); v.B = b.Support(-d); v.W = v.A - v.B; return v; };
+
+    struct Face { uint8_t I[3]; glm::vec3 N; float D; };
+    FixedVector<GjkVertex, 64> verts;
+    FixedVector<Face, 128>     faces;
+    for (const GjkVertex& v : simplex) verts.push_back(v);
+
+    // GJK may stop on a point, edge or triangle touching the origin; grow it
+    // into a tetrahedron first.
+    if (verts.size() == 1) {
+        static const glm::vec3 axes[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        for (const glm::vec3& d : axes) {
+            GjkVertex w = support(d);
+            if (glm::dot(w.W - verts[0].W, w.W - verts[0].W) > 1e-10f) { verts.push_back(w); break; }
+        }
+    }
+    if (verts.size() == 2) {
+        glm::vec3 d = glm::normalize(verts[1].W - verts[0].W);
+        glm::vec3 e = std::abs(d.x) < 0.57735f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+        glm::vec3 p = glm::normalize(glm::cross(d, e)), q = glm::cross(d, p);
+        for (int k = 0; k < 6; ++k) {
+            float ang = float(k) * 1.0471976f;
+            GjkVertex w = support(p * std::cos(ang) + q * std::sin(ang));
+            glm::vec3 off = glm::cross(w.W - verts[0].W, d);
+            if (glm::dot(off, off) > 1e-10f) { verts.push_back(w); break; }
+        }
+    }
+    if (verts.size() == 3) {
+        glm::vec3 n = glm::cross(verts[1].W - verts[0].W, verts[2].W - verts[0].W);
+        GjkVertex w = support(n);
+        if (std::abs(glm::dot(n, w.W - verts[0].W)) <= 1e-10f) w = support(-n);
+        if (std::abs(glm::dot(n, w.W - verts[0].W)) > 1e-10f) verts.push_back(w);
+    }
+    if (verts.size() < 4) return false;
+
+    auto addFace = [&](uint8_t i, uint8_t j, uint8_t k) {
+        glm::vec3 n = glm::cross(verts[j].W - verts[i].W, verts[k].W - verts[i].W);
+        float len = std::sqrt(glm::dot(n, n));
+        if (!(len > 1e-12f) || faces.full()) return false;
+        n /= len;
+        faces.push_back({ { i, j, k }, n, glm::dot(n, verts[i].W) });
+        return true;
+    };
+    static const uint8_t tetra[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+    for (const auto& t : tetra) {
+        glm::vec3 n = glm::cross(verts[t[1]].W - verts[t[0]].W, verts[t[2]].W - verts[t[0]].W);
+        bool ok = glm::dot(n, verts[t[3]].W - verts[t[0]].W) <= 0.0f ? addFace(t[0], t[1], t[2]) : addFace(t[0], t[2], t[1]);
+        if (!ok) return false;
+    }
+
+    uint32_t best = 0;
+    for (int iter = 0; iter < 64; ++iter) {
+        best = 0;
+        for (uint32_t f = 1; f < faces.size(); ++f) if (faces[f].D < faces[best].D) best = f;
+        const Face nearest = faces[best];
+        GjkVertex w = support(nearest.N);
+        if (glm::dot(w.W, nearest.N) - nearest.D < 1e-4f || verts.full()) break;
+
+        // Remove the faces w sees and keep the edges around the hole.
+        const uint8_t wi = (uint8_t)verts.size();
+        verts.push_back(w);
+        FixedVector<std::pair<uint8_t, uint8_t>, 96> horizon;
+        uint32_t live = 0;
+        for (uint32_t f = 0; f < faces.size(); ++f) {
+            const Face& face = faces[f];
+            if (glm::dot(face.N, w.W - verts[face.I[0]].W) <= 0.0f) { faces[live++] = face; continue; }
+            for (int e = 0; e < 3; ++e) {
+                std::pair<uint8_t, uint8_t> edge{ face.I[e], face.I[(e + 1) % 3] };
+                bool shared = false;
+                for (auto& h : horizon) {
+                    if (h.first == edge.second && h.second == edge.first) { h = horizon.back(); horizon.pop_back(); shared = true; break; }
+                }
+                if (shared) continue;
+                if (horizon.full()) return false;   // dropping an edge would leave a hole in the polytope
+                horizon.push_back(edge);
+            }
+        }
+        while (faces.size() > live) faces.pop_back();
+        bool ok = true;
+        for (const auto& h : horizon) ok &= addFace(h.first, h.second, wi);
+        if (!ok || faces.empty()) return false;
+    }
+
+    best = 0;
+    for (uint32_t f = 1; f < faces.size(); ++f) if (faces[f].D < faces[best].D) best = f;
+    const Face& f = faces[best];
+    normal = f.N;
+    depth = f.D;
+
+    // Barycentric weights of the origin's projection onto the face.
+    const GjkVertex& v0 = verts[f.I[0]], & v1 = verts[f.I[1]], & v2 = verts[f.I[2]];
+    glm::vec3 e0 = v1.W - v0.W, e1 = v2.W - v0.W, p = f.N * f.D - v0.W;
+    float d00 = glm::dot(e0, e0), d01 = glm::dot(e0, e1), d11 = glm::dot(e1, e1);
+    float d20 = glm::dot(p, e0), d21 = glm::dot(p, e1), den = d00 * d11 - d01 * d01;
+    float l1 = den > 1e-30f ? (d11 * d20 - d01 * d21) / den : 0.0f;
+    float l2 = den > 1e-30f ? (d00 * d21 - d01 * d20) / den : 0.0f;
+    float l0 = 1.0f - l1 - l2;
+    pointA = v0.A * l0 + v1.A * l1 + v2.A * l2;
+    pointB = v0.B * l0 + v1.B * l1 + v2.B * l2;
+    return true;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Shape.h"
+#include "TriangleMeshShape.h"
+
+// Static terrain given by a grid of heights, centered on the local origin
+// in XZ. Each cell is split into two triangles that are built on demand,
+// so a query only reads the samples under the shape it is run for and the
+// cost does not depend on the size of the terrain. Heights can be
+// quantized to 16 bits, which halves the memory of large grids at a
+// precision of (max - min) / 65535.
+//
+// Like meshes, the surface is one-sided and collides only with shapes above it.
+struct HeightfieldShape : public Shape {
+    // `heights` holds countX * countZ samples, row by row along X, spaced
+    // `spacing` apart in X and Z. Any other sample count makes an empty
+    // field that collides with nothing.
+    HeightfieldShape(const std::vector<float>& heights, uint32_t countX, uint32_t countZ, const glm::vec2& spacing,
+        bool quantize = false)
+        : m_CountX(countX), m_CountZ(countZ), m_Spacing(spacing)
+    {
+        Type = ShapeType::Heightfield;
+        const bool valid = countX > 0 && countZ > 0 && heights.size() == size_t(countX) * countZ;
+        assert(valid && "heightfield needs countX * countZ samples");
+        if (!valid) { m_CountX = m_CountZ = 0; m_Origin = glm::vec2(0.0f); m_Bounds = { glm::vec3(0.0f), glm::vec3(0.0f) }; return; }
+
+        m_Origin = { -0.5f * spacing.x * float(countX - 1), -0.5f * spacing.y * float(countZ - 1) };
+        float lo = FLT_MAX, hi = -FLT_MAX;
+        for (float h : heights) { lo = std::min(lo, h); hi = std::max(hi, h); }
+        m_Bounds = { glm::vec3(m_Origin.x, lo, m_Origin.y),
+            glm::vec3(-m_Origin.x, hi, -m_Origin.y) };
+
+        if (quantize) {
+            m_QuantOffset = lo;
+            m_QuantScale = hi > lo ? (hi - lo) / 65535.0f : 0.0f;
+            m_Quantized.reserve(heights.size());
+            for (float h : heights)
+                m_Quantized.push_back(m_QuantScale > 0.0f ? (uint16_t)std::lround((h - lo) / m_QuantScale) : 0);
+        }
+        else {
+            m_Heights = heights;
+        }
+    }
+
+    AABB ComputeLocalAABB() const override { return m_Bounds; }
+
+    // Heightfields are static only, so the inertia is never used.
+    glm::mat3 ComputeInertiaTensor(float) const override { return glm::mat3(0.0f); }
+
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        glm::vec3 best(0.0f); float bestD = -FLT_MAX;
+        for (uint32_t z = 0; z < m_CountZ; ++z)
+            for (uint32_t x = 0; x < m_CountX; ++x) {
+                glm::vec3 v = GetVertex(x, z);
+                float d = glm::dot(v, dir);
+                if (d > bestD) { bestD = d; best = v; }
+            }
+        return best;
+    }
+
+    float GetHeight(uint32_t x, uint32_t z) const {
+        const uint32_t i = z * m_CountX + x;
+        return m_Quantized.empty() ? m_Heights[i] : m_QuantOffset + float(m_Quantized[i]) * m_QuantScale;
+    }
+
+    glm::vec3 GetVertex(uint32_t x, uint32_t z) const {
+        return { m_Origin.x + float(x) * m_Spacing.x, GetHeight(x, z), m_Origin.y + float(z) * m_Spacing.y };
+    }
+
+    // Calls cb(index, triangle) for both triangles of every cell whose
+    // column overlaps the local-space box. Triangle 2c and 2c + 1 belong to
+    // cell c = z * (countX - 1) + x, so indices are stable.
+    template<typename F>
+    void Query(const AABB& box, F&& cb) const {
+        if (m_CountX < 2 || m_CountZ < 2) return;
+        if (box.Max.x < m_Bounds.Min.x || box.Min.x > m_Bounds.Max.x ||
+            box.Max.z < m_Bounds.Min.z || box.Min.z > m_Bounds.Max.z ||
+            box.Max.y < m_Bounds.Min.y || box.Min.y > m_Bounds.Max.y) return;
+
+        auto cellRange = [](float lo, float hi, float origin, float spacing, uint32_t cells, uint32_t& first, uint32_t& last) {
+            first = (uint32_t)std::clamp(std::floor((lo - origin) / spacing), 0.0f, float(cells - 1));
+            last = (uint32_t)std::clamp(std::floor((hi - origin) / spacing), 0.0f, float(cells - 1));
+        };
+        uint32_t x0, x1, z0, z1;
+        cellRange(box.Min.x, box.Max.x, m_Origin.x, m_Spacing.x, m_CountX - 1, x0, x1);
+        cellRange(box.Min.z, box.Max.z, m_Origin.y, m_Spacing.y, m_CountZ - 1, z0, z1);
+
+        TriangleMeshShape::Triangle tri;
+        for (uint32_t z = z0; z <= z1; ++z) {
+            for (uint32_t x = x0; x <= x1; ++x) {
+                const glm::vec3 v00 = GetVertex(x, z), v10 = GetVertex(x + 1, z);
+                const glm::vec3 v01 = GetVertex(x, z + 1), v11 = GetVertex(x + 1, z + 1);
+                const float lo = std::min({ v00.y, v10.y, v01.y, v11.y }), hi = std::max({ v00.y, v10.y, v01.y, v11.y });
+                if (hi < box.Min.y || lo > box.Max.y) continue;
+
+                // Counter-clockwise seen from above.
+                const uint32_t cell = z * (m_CountX - 1) + x;
+                tri.V[0] = v00; tri.V[1] = v01; tri.V[2] = v10;
+                cb(2 * cell, tri);
+                tri.V[0] = v10; tri.V[1] = v01; tri.V[2] = v11;
+                cb(2 * cell + 1, tri);
+            }
+        }
+    }
+
+    uint32_t GetCountX() const { return m_CountX; }
+    uint32_t GetCountZ() const { return m_CountZ; }
+    bool IsQuantized() const { return !m_Quantized.empty(); }
+
+private:
+    uint32_t              m_CountX, m_CountZ;
+    glm::vec2             m_Spacing;
+    glm::vec2             m_Origin;            // local XZ of sample (0, 0)
+    std::vector<float>    m_Heights;           // empty when quantized
+    std::vector<uint16_t> m_Quantized;
+    float                 m_QuantOffset = 0.0f, m_QuantScale = 0.0f;
+    AABB                  m_Bounds;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "BodyHandle.h"
+
+// Groups awake bodies into islands: sets of dynamic bodies connected through
+// touching contacts or joints. Rebuilt every substep with a union-find over
+// the awake range of the body store; static and kinematic bodies never link
+// islands together, so islands can be solved independently.
+class IslandBuilder {
+public:
+    void Reset(uint32_t count) {
+        m_Parent.resize(count);
+        for (uint32_t i = 0; i < count; ++i) m_Parent[i] = i;
+    }
+
+    void Link(uint32_t a, uint32_t b) {
+        a = Find(a); b = Find(b);
+        if (a == b) return;
+        if (a < b) m_Parent[b] = a; else m_Parent[a] = b;
+    }
+
+    uint32_t Find(uint32_t i) {
+        while (m_Parent[i] != i) { m_Parent[i] = m_Parent[m_Parent[i]]; i = m_Parent[i]; }
+        return i;
+    }
+
+    // Fills Offsets/Bodies so island k is Bodies[Offsets[k] .. Offsets[k + 1]).
+    void Build() {
+        const uint32_t n = (uint32_t)m_Parent.size();
+        m_RootToIsland.assign(n, NoIsland);
+        Offsets.clear(); Offsets.push_back(0);
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t r = Find(i);
+            if (m_RootToIsland[r] == NoIsland) { m_RootToIsland[r] = (uint32_t)Offsets.size() - 1; Offsets.push_back(0); }
+            ++Offsets[m_RootToIsland[r] + 1];
+        }
+        for (uint32_t k = 1; k < (uint32_t)Offsets.size(); ++k) Offsets[k] += Offsets[k - 1];
+
+        Bodies.resize(n);
+        m_Cursor.assign(Offsets.begin(), Offsets.end() - 1);
+        for (uint32_t i = 0; i < n; ++i) Bodies[m_Cursor[m_RootToIsland[Find(i)]]++] = i;
+    }
+
+    uint32_t IslandCount() const { return (uint32_t)Offsets.size() - 1; }
+    // Island index of body i; only valid after Build.
+    uint32_t IslandOf(uint32_t i) { return m_RootToIsland[Find(i)]; }
+
+    std::vector<uint32_t> Offsets;
+    std::vector<uint32_t> Bodies;
+
+private:
+    static constexpr uint32_t NoIsland = 0xFFFFFFFFu;
+
+    std::vector<uint32_t> m_Parent;
+    std::vector<uint32_t> m_RootToIsland;
+    std::vector<uint32_t> m_Cursor;
+};
+
+// Buckets per-island items (manifolds, joints) with a counting sort, so
+// island k owns Items[Offsets[k] .. Offsets[k + 1]). Storage is reused
+// between substeps.
+template<typename T>
+class IslandBuckets {
+public:
+    std::vector<uint32_t> Offsets;
+    std::vector<T>        Items;
+
+    void Reset(uint32_t islands) { Offsets.assign(islands + 2, 0); m_Pending.clear(); }
+    void Add(uint32_t island, const T& item) { m_Pending.push_back({ island, item }); ++Offsets[island + 2]; }
+
+    void Build() {
+        for (uint32_t k = 2; k < (uint32_t)Offsets.size(); ++k) Offsets[k] += Offsets[k - 1];
+        Items.resize(m_Pending.size());
+        for (const auto& [k, item] : m_Pending) Items[Offsets[k + 1]++] = item;
+        Offsets.pop_back();
+    }
+
+    uint32_t Count(uint32_t island) const { return Offsets[island + 1] - Offsets[island]; }
+
+private:
+    std::vector<std::pair<uint32_t, T>> m_Pending;
+};
+
+// An island that went to sleep as a whole. It keeps its bodies and the
+// broadphase pairs that only involve sleeping or static bodies, so neither is
+// visited again until something wakes the island.
+struct SleepingIsland {
+    std::vector<BodyHandle> Bodies;
+    std::vector<BodyPair>   Pairs;
+};
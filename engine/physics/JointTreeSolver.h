@@ -0,0 +1,287 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "BodyStore.h"
+#include "Constraint.h"
+#include "Island.h"
+
+// Iterative: every joint is solved one at a time, interleaved with the
+// contacts. Direct: single-row joints that form trees over the dynamic bodies
+// (chains, ropes, branching rigs) are solved exactly and all at once in every
+// velocity pass, so long chains do not stretch however few passes run; joints
+// in loops, and joints with more than one row, still iterate.
+enum class JointSolverType { Iterative, Direct };
+
+// Baraff's linear-time solve ("Linear-Time Dynamics using Lagrange
+// Multipliers", 1996) of the joint rows of each island. The system
+//
+//     [ M  J^T ] [ dv ]   [ 0 ]
+//     [ J   0  ] [ -l ] = [ r ]
+//
+// has one node per dynamic body (6x6 mass block) and one per joint row
+// (1x1), coupled only where a joint meets a body. When the joints form a
+// tree that graph is a tree, so factoring leaves first gives an LDL^T
+// decomposition with no fill-in. Static and kinematic bodies do not move
+// under an impulse, so they are not nodes; the world they stand for is one
+// node, though, and a tree may only be pinned to it once.
+//
+// Build runs once per substep on the calling thread; Factor and Solve touch
+// one island's nodes and bodies only, so islands can run on the pool.
+class JointTreeSolver {
+public:
+    // Takes the single-row joints of every island that form trees out of
+    // `joints`, which keeps the rest for the iterative solver.
+    void Build(const BodyStore& S, IslandBuckets<Constraint*>& joints) {
+        const uint32_t n = S.AwakeCount();
+        const uint32_t islands = (uint32_t)joints.Offsets.size() - 1;
+        auto dynamic = [&](uint32_t i) { return i < n && S.Info[i].IsDynamic(); };
+
+        m_Joints = joints.Items;
+        m_IslandOffsets.assign(joints.Offsets.begin(), joints.Offsets.end());
+        m_Nodes.clear();
+        m_IslandNodes.assign(1, 0);
+
+        // Bodies and joint ends by dense index: a candidate joint is added to
+        // the adjacency of each dynamic body it holds.
+        m_JointNode.assign(m_Joints.size(), Unused);
+        m_Ends.resize(m_Joints.size());
+        m_Adjacency.assign(n + 1, 0);
+        for (uint32_t j = 0; j < (uint32_t)m_Joints.size(); ++j) {
+            Constraint* c = m_Joints[j];
+            m_Ends[j] = { Unused, Unused };
+            if (!c->GetRow() || !S.IsValid(c->BodyA) || !S.IsValid(c->BodyB)) { m_JointNode[j] = Loose; continue; }
+            uint32_t a = S.IndexOf(c->BodyA), b = S.IndexOf(c->BodyB);
+            if (a == b) { m_JointNode[j] = Loose; continue; }
+            m_Ends[j] = { dynamic(a) ? a : Unused, dynamic(b) ? b : Unused };
+            if (m_Ends[j].first == Unused && m_Ends[j].second == Unused) { m_JointNode[j] = Loose; continue; }
+            if (m_Ends[j].first != Unused) ++m_Adjacency[m_Ends[j].first + 1];
+            if (m_Ends[j].second != Unused) ++m_Adjacency[m_Ends[j].second + 1];
+        }
+        for (uint32_t i = 1; i <= n; ++i) m_Adjacency[i] += m_Adjacency[i - 1];
+        m_AdjacentJoints.resize(m_Adjacency[n]);
+        m_Cursor.assign(m_Adjacency.begin(), m_Adjacency.end() - 1);
+        for (uint32_t j = 0; j < (uint32_t)m_Joints.size(); ++j) {
+            if (m_Ends[j].first != Unused) m_AdjacentJoints[m_Cursor[m_Ends[j].first]++] = j;
+            if (m_Ends[j].second != Unused) m_AdjacentJoints[m_Cursor[m_Ends[j].second]++] = j;
+        }
+        m_BodyNode.assign(n, Unused);
+
+        // A joint to a static or kinematic body has a zero pivot, so it must
+        // not be a leaf: a tree holding one is grown again rooted at it. Trees
+        // closing a loop, directly or through a second joint to the world, go
+        // back to the iterative solver whole.
+        for (uint32_t k = 0; k < islands; ++k) {
+            for (uint32_t j = m_IslandOffsets[k]; j < m_IslandOffsets[k + 1]; ++j) {
+                if (m_JointNode[j] != Unused) continue;
+                const uint32_t first = (uint32_t)m_Nodes.size();
+                uint32_t grounded = 0, anchor = j;
+                bool tree = Grow(j, grounded, anchor);
+                if (tree && grounded == 1 && anchor != j) {
+                    Discard(first, Unused);
+                    tree = Grow(anchor, grounded, anchor);
+                }
+                if (!tree || grounded > 1) Discard(first, Loose);
+            }
+            m_IslandNodes.push_back((uint32_t)m_Nodes.size());
+        }
+
+        joints.Reset(islands);
+        for (uint32_t k = 0; k < islands; ++k)
+            for (uint32_t j = m_IslandOffsets[k]; j < m_IslandOffsets[k + 1]; ++j)
+                if (m_JointNode[j] == Loose) joints.Add(k, m_Joints[j]);
+        joints.Build();
+    }
+
+    // Prepares the tree joints of island k for the substep and factors their
+    // system, leaves first. A body's pivot is its mass matrix plus a rank one
+    // term for each child joint, so it is kept inverted from the start and
+    // updated by Sherman-Morrison instead of being inverted as a 6x6.
+    void Factor(const BodyStore& S, uint32_t k, float dt, float invDt) {
+        const uint32_t first = m_IslandNodes[k], last = m_IslandNodes[k + 1];
+        for (uint32_t i = first; i < last; ++i) {
+            Node& node = m_Nodes[i];
+            node.D = {};
+            if (!node.IsBody) { m_Joints[node.Index]->BeginSubStep(S, dt, invDt); continue; }
+            const uint32_t b = node.Index;
+            const glm::mat3& invInertia = S.InverseInertiaWorld[b];
+            for (int r = 0; r < 3; ++r) {
+                node.D[r * 6 + r] = S.InverseMass[b];
+                for (int c = 0; c < 3; ++c) node.D[(r + 3) * 6 + c + 3] = invInertia[c][r];
+            }
+        }
+
+        for (uint32_t i = last; i-- > first; ) {
+            Node& node = m_Nodes[i];
+            if (!node.IsBody) node.D[0] = std::abs(node.D[0]) > 1e-12f ? 1.0f / node.D[0] : 0.0f;
+            if (node.Parent == NoParent) continue;
+
+            // J = D^-1 H(i, parent); the parent's pivot loses H(i, parent)^T J.
+            Node& parent = m_Nodes[node.Parent];
+            float h[6];
+            Coupling(node.IsBody ? parent : node, node.IsBody ? node.Index : parent.Index, h);
+            if (node.IsBody) {
+                for (int r = 0; r < 6; ++r) {
+                    node.J[r] = 0.0f;
+                    for (int c = 0; c < 6; ++c) node.J[r] += node.D[r * 6 + c] * h[c];
+                }
+                for (int r = 0; r < 6; ++r) parent.D[0] -= h[r] * node.J[r];
+                continue;
+            }
+            for (int r = 0; r < 6; ++r) node.J[r] = node.D[0] * h[r];
+            // (A + w h h^T)^-1 = A^-1 - w u u^T / (1 + w h.u), u = A^-1 h, with
+            // w = -1 / D of the joint, which is never negative.
+            const float w = -node.D[0];
+            if (w <= 0.0f) continue;
+            float u[6], hu = 0.0f;
+            for (int r = 0; r < 6; ++r) {
+                u[r] = 0.0f;
+                for (int c = 0; c < 6; ++c) u[r] += parent.D[r * 6 + c] * h[c];
+                hu += h[r] * u[r];
+            }
+            const float f = w / (1.0f + w * hu);
+            for (int r = 0; r < 6; ++r)
+                for (int c = 0; c < 6; ++c) parent.D[r * 6 + c] -= f * u[r] * u[c];
+        }
+    }
+
+    // Solves every tree row of island k together against the current
+    // velocities and applies the impulses through the joints. Returns the
+    // largest velocity change.
+    float Solve(BodyStore& S, uint32_t k, float dt, bool useBias) {
+        const uint32_t first = m_IslandNodes[k], last = m_IslandNodes[k + 1];
+        float error = 0.0f;
+        for (uint32_t i = first; i < last; ++i) {
+            Node& node = m_Nodes[i];
+            node.X = {};
+            if (node.IsBody) continue;
+            const JointRow& row = *m_Joints[node.Index]->GetRow();
+            if (row.Axis.Mass != 0.0f) node.X[0] = -(row.Velocity(S) + (useBias ? row.Bias : 0.0f));
+            error = std::max(error, std::abs(node.X[0]));
+        }
+        // Nothing but the trees themselves moved the bodies since the last
+        // solve, which left them exact.
+        if (error <= SettledVelocity) return 0.0f;
+
+        // Forward substitution leaves first, then back substitution from the
+        // roots; each node only reads and writes its parent.
+        for (uint32_t i = last; i-- > first; ) {
+            const Node& node = m_Nodes[i];
+            if (node.Parent == NoParent) continue;
+            Node& parent = m_Nodes[node.Parent];
+            if (node.IsBody) for (int r = 0; r < 6; ++r) parent.X[0] -= node.J[r] * node.X[r];
+            else for (int r = 0; r < 6; ++r) parent.X[r] -= node.J[r] * node.X[0];
+        }
+        for (uint32_t i = first; i < last; ++i) {
+            Node& node = m_Nodes[i];
+            if (node.IsBody) {
+                std::array<float, 6> x = node.X;
+                for (int r = 0; r < 6; ++r) {
+                    node.X[r] = 0.0f;
+                    for (int c = 0; c < 6; ++c) node.X[r] += node.D[r * 6 + c] * x[c];
+                }
+            }
+            else {
+                node.X[0] *= node.D[0];
+            }
+            if (node.Parent == NoParent) continue;
+            const Node& parent = m_Nodes[node.Parent];
+            if (node.IsBody) for (int r = 0; r < 6; ++r) node.X[r] -= node.J[r] * parent.X[0];
+            else for (int r = 0; r < 6; ++r) node.X[0] -= node.J[r] * parent.X[r];
+        }
+
+        float change = 0.0f;
+        for (uint32_t i = first; i < last; ++i) {
+            const Node& node = m_Nodes[i];
+            if (!node.IsBody) change = std::max(change, m_Joints[node.Index]->ApplyRowImpulse(S, -node.X[0], dt));
+        }
+        return change;
+    }
+
+    uint32_t IslandCount() const { return (uint32_t)m_IslandNodes.size() - 1; }
+    uint32_t NodeCount() const { return (uint32_t)m_Nodes.size(); }
+
+private:
+    static constexpr uint32_t Unused = 0xFFFFFFFFu;
+    static constexpr uint32_t Loose = 0xFFFFFFFEu;   // left to the iterative solver
+    static constexpr uint32_t NoParent = 0xFFFFFFFFu;
+    static constexpr float    SettledVelocity = 1e-4f;   // m/s of row error a solve is skipped below
+
+    // A body (6x6 pivot) or a joint row (1x1, stored in D[0], J[0..5] and X[0]).
+    struct Node {
+        uint32_t Index;    // dense body index, or index into m_Joints
+        uint32_t Parent;   // node index
+        bool     IsBody;
+        std::array<float, 36> D{};   // inverse of the pivot block once factored
+        std::array<float, 6>  J{};   // D^-1 H(node, parent)
+        std::array<float, 6>  X{};   // solve scratch
+    };
+
+    std::vector<Constraint*>                     m_Joints;          // this substep's joints, island by island
+    std::vector<uint32_t>                        m_IslandOffsets;   // island k owns m_Joints[m_IslandOffsets[k] ..]
+    std::vector<std::pair<uint32_t, uint32_t>>   m_Ends;            // dynamic end bodies of each joint, or Unused
+    std::vector<uint32_t>                        m_JointNode;       // node of each joint, Unused or Loose
+    std::vector<uint32_t>                        m_BodyNode;        // node of each awake body, or Unused
+    std::vector<uint32_t>                        m_Adjacency;       // joints of body i: m_AdjacentJoints[m_Adjacency[i] ..]
+    std::vector<uint32_t>                        m_AdjacentJoints;
+    std::vector<uint32_t>                        m_Cursor;
+    std::vector<Node>                            m_Nodes;           // breadth-first, tree by tree, island by island
+    std::vector<uint32_t>                        m_IslandNodes;     // island k owns m_Nodes[m_IslandNodes[k] ..]
+
+    // Grows the tree of joint `root` breadth first onto m_Nodes, so parents
+    // precede their children. Returns false if it reaches a visited body
+    // again; `grounded` counts its joints with a single dynamic end and
+    // `anchor` is the last of them.
+    bool Grow(uint32_t root, uint32_t& grounded, uint32_t& anchor) {
+        bool tree = true;
+        grounded = 0;
+        m_JointNode[root] = (uint32_t)m_Nodes.size();
+        m_Nodes.push_back({ root, NoParent, false });
+        for (uint32_t head = m_JointNode[root]; head < (uint32_t)m_Nodes.size(); ++head) {
+            const Node node = m_Nodes[head];
+            if (node.IsBody) {
+                for (uint32_t e = m_Adjacency[node.Index]; e < m_Adjacency[node.Index + 1]; ++e) {
+                    const uint32_t adj = m_AdjacentJoints[e];
+                    if (m_JointNode[adj] != Unused) continue;
+                    m_JointNode[adj] = (uint32_t)m_Nodes.size();
+                    m_Nodes.push_back({ adj, head, false });
+                }
+                continue;
+            }
+            const auto [a, b] = m_Ends[node.Index];
+            if (a == Unused || b == Unused) { ++grounded; anchor = node.Index; }
+            for (uint32_t end : { a, b }) {
+                if (end == Unused || (node.Parent != NoParent && end == m_Nodes[node.Parent].Index)) continue;
+                if (m_BodyNode[end] != Unused) { tree = false; continue; }
+                m_BodyNode[end] = (uint32_t)m_Nodes.size();
+                m_Nodes.push_back({ end, head, true });
+            }
+        }
+        return tree;
+    }
+
+    // Drops the nodes from `first` on, marking their joints `mark`.
+    void Discard(uint32_t first, uint32_t mark) {
+        for (uint32_t i = first; i < (uint32_t)m_Nodes.size(); ++i) {
+            if (m_Nodes[i].IsBody) m_BodyNode[m_Nodes[i].Index] = Unused;
+            else m_JointNode[m_Nodes[i].Index] = mark;
+        }
+        m_Nodes.resize(first);
+    }
+
+    // The block of joint node `joint` against body `body`: -(n, rA x n) on
+    // body A, (n, rB x n) on body B.
+    void Coupling(const Node& joint, uint32_t body, float* h) const {
+        const JointRow& row = *m_Joints[joint.Index]->GetRow();
+        const float s = body == row.A ? -1.0f : 1.0f;
+        const glm::vec3& rxn = body == row.A ? row.Axis.RAxAxis : row.Axis.RBxAxis;
+        if (row.Axis.Mass == 0.0f) { std::fill(h, h + 6, 0.0f); return; }
+        for (int r = 0; r < 3; ++r) { h[r] = s * row.Normal[r]; h[r + 3] = s * rxn[r]; }
+    }
+};
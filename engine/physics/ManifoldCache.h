@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Contact.h"
+#include "PairTable.h"
+
+// Accumulated impulses of the previous substep's manifolds, keyed by body-ID
+// pair, for warm starting. A contact point is matched by the feature ID the
+// narrowphase gave it, so it keeps its impulse exactly as long as the same
+// pair of features produces it.
+class ManifoldCache {
+public:
+    // `scale` converts impulses stored at a different substep length.
+    void WarmStart(Manifold& m, float scale = 1.0f) const {
+        const Entry* e = m_Table.Find(m.Key);
+        if (!e) return;
+        for (auto& c : m.Contacts) {
+            for (uint32_t p = 0; p < e->Count; ++p) {
+                if (e->Features[p] != c.FeatureID) continue;
+                c.NormalImpulse = e->Impulses[p].x * scale;
+                c.TangentImpulse0 = e->Impulses[p].y * scale;
+                c.TangentImpulse1 = e->Impulses[p].z * scale;
+                break;
+            }
+        }
+    }
+
+    void Store(const Manifold& m) {
+        Entry& e = m_Table.Insert(m.Key);
+        e.Count = m.Contacts.size();
+        for (uint32_t p = 0; p < e.Count; ++p) {
+            const ContactPoint& c = m.Contacts[p];
+            e.Features[p] = c.FeatureID;
+            e.Impulses[p] = { c.NormalImpulse, c.TangentImpulse0, c.TangentImpulse1 };
+        }
+    }
+
+    // Drops the pairs that were not stored since the previous call; called
+    // once per step, so a pair that stops touching loses its impulses.
+    void EvictStale() { m_Table.EvictStale(); }
+
+    void Clear() { m_Table.Clear(); }
+    uint32_t Size() const { return m_Table.Size(); }
+
+private:
+    struct Entry {
+        uint64_t  Key = EmptyPairKey;
+        uint32_t  Stamp = 0;
+        uint32_t  Count = 0;
+        uint32_t  Features[MaxManifoldPoints];
+        glm::vec3 Impulses[MaxManifoldPoints];   // normal, tangent 0, tangent 1
+    };
+
+    PairTable<Entry> m_Table;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+// Never produced by MakePairKey, which does not pair a body with itself.
+constexpr uint64_t EmptyPairKey = ~uint64_t(0);
+
+// Per-pair state that lives across steps, in one flat array with linear
+// probing. Entry needs `uint64_t Key = EmptyPairKey` and `uint32_t Stamp`.
+// Entries not inserted since the previous EvictStale are dropped by the
+// next one. The table only grows, so a settled scene inserts without
+// allocating.
+template<typename Entry>
+class PairTable {
+public:
+    const Entry* Find(uint64_t key) const {
+        if (m_Entries.empty()) return nullptr;
+        const Entry& e = Slot(m_Entries, key);
+        return e.Key == key ? &e : nullptr;
+    }
+
+    // The entry for `key`, created if needed and marked as used this step.
+    Entry& Insert(uint64_t key) {
+        if ((m_Count + 1) * 2 > (uint32_t)m_Entries.size()) Rehash(std::max<uint32_t>(64, (uint32_t)m_Entries.size() * 2), false);
+        Entry& e = Slot(m_Entries, key);
+        if (e.Key == EmptyPairKey) { e.Key = key; ++m_Count; }
+        e.Stamp = m_Stamp;
+        return e;
+    }
+
+    void EvictStale() {
+        bool stale = false;
+        for (const Entry& e : m_Entries) stale |= e.Key != EmptyPairKey && e.Stamp != m_Stamp;
+        if (stale) Rehash((uint32_t)m_Entries.size(), true);
+        ++m_Stamp;
+    }
+
+    void Clear() { m_Entries.assign(m_Entries.size(), Entry{}); m_Count = 0; }
+    uint32_t Size() const { return m_Count; }
+
+private:
+    std::vector<Entry> m_Entries, m_Scratch;     // power-of-two sizes, at most half full
+    uint32_t           m_Count = 0;
+    uint32_t           m_Stamp = 1;
+
+    static uint64_t Hash(uint64_t k) {
+        k ^= k >> 33; k *= 0xff51afd7ed558ccdull;
+        k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ull;
+        return k ^ (k >> 33);
+    }
+
+    // The entry holding `key`, or the empty entry where it would go.
+    template<typename Entries>
+    static auto Slot(Entries& entries, uint64_t key) -> decltype(entries[0]) {
+        const size_t mask = entries.size() - 1;
+        size_t i = Hash(key) & mask;
+        while (entries[i].Key != key && entries[i].Key != EmptyPairKey) i = (i + 1) & mask;
+        return entries[i];
+    }
+
+    // Moves the entries into a table of `size` slots, leaving out those not
+    // inserted since the last eviction if `dropStale` is set.
+    void Rehash(uint32_t size, bool dropStale) {
+        m_Scratch.assign(size, Entry{});
+        m_Count = 0;
+        for (const Entry& e : m_Entries) {
+            if (e.Key == EmptyPairKey || (dropStale && e.Stamp != m_Stamp)) continue;
+            Slot(m_Scratch, e.Key) = e;
+            ++m_Count;
+        }
+        std::swap(m_Entries, m_Scratch);
+    }
+};
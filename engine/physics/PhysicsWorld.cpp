@@ -1 +1,15 @@
 #include "PhysicsWorld.h"
+
+#if defined(PHYSIM_COUNT_ALLOCATIONS)
+#include <cstdlib>
+#include <new>
+
+// Array and nothrow forms forward to these, so every default allocation is counted.
+void* operator new(std::size_t size) {
+    AllocationCounter::Count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
@@ -9,6 +9,8 @@
 #include <math.h>
 #include <cfloat>
 #include <cstdint>
+#include <cassert>
+#include <memory>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -18,192 +20,65 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "AABB.h"
-
-enum class ShapeType { Sphere, Box, TriangleMesh };
-
-struct Shape {
-    ShapeType Type;
-    virtual ~Shape() = default;
-    virtual AABB      ComputeLocalAABB()               const = 0;
-    virtual glm::mat3 ComputeInertiaTensor(float mass)  const = 0;
-    virtual glm::vec3 GetLocalSupport(const glm::vec3& dir) const = 0;
-};
-
-struct SphereShape : public Shape {
-    float Radius;
-    explicit SphereShape(float r) : Radius(r) { Type = ShapeType::Sphere; }
-    AABB ComputeLocalAABB() const override { return { glm::vec3(-Radius), glm::vec3(Radius) }; }
-    glm::mat3 ComputeInertiaTensor(float mass) const override {
-        float I = (2.0f / 5.0f) * mass * Radius * Radius;
-        return glm::mat3(I);
-    }
-    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
-        float len = glm::length(dir);
-        return (len > 1e-8f) ? (dir / len) * Radius : glm::vec3(0, Radius, 0);
-    }
-};
-
-struct BoxShape : public Shape {
-    glm::vec3 HalfExtents;
-    explicit BoxShape(const glm::vec3& half) : HalfExtents(half) { Type = ShapeType::Box; }
-    AABB ComputeLocalAABB() const override { return { -HalfExtents, HalfExtents }; }
-    glm::mat3 ComputeInertiaTensor(float mass) const override {
-        float ex = 2.0f * HalfExtents.x, ey = 2.0f * HalfExtents.y, ez = 2.0f * HalfExtents.z;
-        float ix = (1.0f / 12.0f) * mass * (ey * ey + ez * ez);
-        float iy = (1.0f / 12.0f) * mass * (ex * ex + ez * ez);
-        float iz = (1.0f / 12.0f) * mass * (ex * ex + ey * ey);
-        return { glm::vec3(ix, 0, 0), glm::vec3(0, iy, 0), glm::vec3(0, 0, iz) };
-    }
-    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
-        return {
-            dir.x >= 0 ? HalfExtents.x : -HalfExtents.x,
-            dir.y >= 0 ? HalfExtents.y : -HalfExtents.y,
-            dir.z >= 0 ? HalfExtents.z : -HalfExtents.z
-        };
-    }
-};
-
-struct PhysicsMaterial {
-    float Restitution = 0.2f;
-    float Friction = 0.5f;
-};
-inline float CombineRestitution(const PhysicsMaterial& a, const PhysicsMaterial& b) { return std::max(a.Restitution, b.Restitution); }
-inline float CombineFriction(const PhysicsMaterial& a, const PhysicsMaterial& b) { return std::sqrt(a.Friction * b.Friction); }
-
-enum class BodyType { Static, Kinematic, Dynamic };
-
-struct RigidBody {
-    uint32_t  ID = 0;
-    BodyType  Type = BodyType::Dynamic;
-    void* UserData = nullptr;
+#include "DynamicAABBTree.h"
+#include "Shape.h"
+#include "TriangleMeshShape.h"
+#include "HeightfieldShape.h"
+#include "CompoundShape.h"
+#include "ConvexHullShape.h"
+#include "Gjk.h"
+#include "BodyStore.h"
+#include "BodyKernels.h"
+#include "CollisionFilter.h"
+#include "Island.h"
+#include "ThreadPool.h"
+#include "Contact.h"
+#include "ContactSolver.h"
+#include "Constraint.h"
+#include "JointTreeSolver.h"
+#include "XPBDSolver.h"
+#include "ManifoldCache.h"
+#include "SimplexCache.h"
+#include "StaticAABBTree.h"
+#include "AllocationCounter.h"
+
+struct BodyDesc {
+    static constexpr uint32_t AutoID = 0xFFFFFFFFu;
 
     glm::vec3 Position{ 0.0f };
     glm::quat Orientation{ 1, 0, 0, 0 };
     glm::vec3 LinearVelocity{ 0.0f };
     glm::vec3 AngularVelocity{ 0.0f };
 
-    float     Mass = 1.0f;
-    float     InverseMass = 1.0f;
-    glm::mat3 InverseInertiaLocal{ 1.0f };
-    glm::mat3 InverseInertiaWorld{ 1.0f };
-
-    float LinearDamping = 0.02f;
-    float AngularDamping = 0.05f;
-
-    glm::vec3 ForceAccumulator{ 0.0f };
-    glm::vec3 TorqueAccumulator{ 0.0f };
-
-    PhysicsMaterial Material;
     Shape* CollisionShape = nullptr;
-    AABB   WorldAABB;
-    float  GravityScale = 1.0f;
-    bool   IsAwake = true;
-    float  SleepTimer = 0.0f;
-
-    void SetStatic() {
-        Type = BodyType::Static;
-        InverseMass = 0.0f; InverseInertiaLocal = glm::mat3(0.0f); InverseInertiaWorld = glm::mat3(0.0f);
-        LinearVelocity = {}; AngularVelocity = {}; IsAwake = false;
-    }
-    void RecalculateMassProperties() {
-        if (Type == BodyType::Static || !CollisionShape || Mass <= 0.0f) { SetStatic(); return; }
-        InverseMass = 1.0f / Mass;
-        glm::mat3 I = CollisionShape->ComputeInertiaTensor(Mass);
-        InverseInertiaLocal = (std::abs(glm::determinant(I)) > 1e-12f) ? glm::inverse(I) : glm::mat3(0.0f);
-    }
-    void UpdateWorldInertia() {
-        if (Type != BodyType::Dynamic) return;
-        glm::mat3 R = glm::mat3_cast(Orientation);
-        InverseInertiaWorld = R * InverseInertiaLocal * glm::transpose(R);
-    }
-    void UpdateAABB(float margin = 0.01f) {
-        if (!CollisionShape) return;
-        AABB lo = CollisionShape->ComputeLocalAABB();
-        glm::vec3 lc = (lo.Min + lo.Max) * 0.5f, le = (lo.Max - lo.Min) * 0.5f;
-        glm::vec3 wc = Position + (Orientation * lc);
-        glm::mat3 R = glm::mat3_cast(Orientation);
-        glm::vec3 we = glm::abs(R[0]) * le.x + glm::abs(R[1]) * le.y + glm::abs(R[2]) * le.z;
-        WorldAABB.Min = wc - we - glm::vec3(margin);
-        WorldAABB.Max = wc + we + glm::vec3(margin);
-    }
-    void WakeUp() { if (!IsAwake) { IsAwake = true; SleepTimer = 0.0f; } }
-
-    glm::vec3 LocalToWorld(const glm::vec3& lp) const { return Position + (Orientation * lp); }
-    glm::vec3 WorldToLocal(const glm::vec3& wp) const { return glm::conjugate(Orientation) * (wp - Position); }
-    glm::vec3 VelocityAt(const glm::vec3& wp) const { return LinearVelocity + glm::cross(AngularVelocity, wp - Position); }
-
-    void ApplyForce(const glm::vec3& f) { if (IsDynamic()) { ForceAccumulator += f; WakeUp(); } }
-    void ApplyTorque(const glm::vec3& t) { if (IsDynamic()) { TorqueAccumulator += t; WakeUp(); } }
-    void ApplyForceAtPoint(const glm::vec3& f, const glm::vec3& wp) {
-        if (!IsDynamic()) return; ForceAccumulator += f; TorqueAccumulator += glm::cross(wp - Position, f); WakeUp();
-    }
-    void ApplyCentralImpulse(const glm::vec3& j) { if (IsDynamic()) LinearVelocity += j * InverseMass; }
-    void ApplyImpulse(const glm::vec3& j, const glm::vec3& r) {
-        if (!IsDynamic()) return; LinearVelocity += j * InverseMass; AngularVelocity += InverseInertiaWorld * glm::cross(r, j);
-    }
-
-    bool IsStatic()   const { return Type == BodyType::Static; }
-    bool IsKinematic()const { return Type == BodyType::Kinematic; }
-    bool IsDynamic()  const { return Type == BodyType::Dynamic; }
-    bool CanMove()    const { return Type == BodyType::Dynamic; }
-};
-
-struct ContactPoint {
-    glm::vec3 WorldPointA, WorldPointB;
-    glm::vec3 LocalPointA, LocalPointB;
-    float     Depth = 0.0f;
-
-    float NormalImpulse = 0.0f;
-    float TangentImpulse0 = 0.0f;
-    float TangentImpulse1 = 0.0f;
-
-    glm::vec3 Tangent0{ 1, 0, 0 };
-    glm::vec3 Tangent1{ 0, 0, 1 };
+    BodyType Type = BodyType::Dynamic;
+    float    Mass = 1.0f;
+    float    GravityScale = 1.0f;
+    PhysicsMaterial Material;
+    // Swept against other bodies every substep so it cannot pass through
+    // them however fast it moves; for small, fast dynamic bodies.
+    bool     IsBullet = false;
+    // The body collides with another only if each one's category shares a
+    // bit with the other's mask.
+    uint32_t CollisionCategory = 1;
+    uint32_t CollisionMask = ~0u;
+
+    uint32_t ID = AutoID;   // key for snapshots and the contact cache
+    void* UserData = nullptr;
 };
 
-struct Manifold {
-    RigidBody* BodyA = nullptr;
-    RigidBody* BodyB = nullptr;
-    glm::vec3  Normal{ 0, 1, 0 };
-    std::vector<ContactPoint> Contacts;
-
-    uint64_t Key() const {
-        uint32_t a = BodyA ? BodyA->ID : 0u, b = BodyB ? BodyB->ID : 0u;
-        if (a > b) std::swap(a, b);
-        return (uint64_t(a) << 32) | uint64_t(b);
-    }
-};
+// World-space pose of a collision shape, with the rotation matrix cached.
+struct ShapeTransform {
+    glm::vec3 Position{ 0.0f };
+    glm::quat Orientation{ 1, 0, 0, 0 };
+    glm::mat3 Rotation{ 1.0f };
 
-class ManifoldCache {
-    struct Cached { glm::vec3 LA, LB; float NI, T0, T1; };
-    std::unordered_map<uint64_t, std::vector<Cached>> C;
-    static constexpr float MATCH_SQ = 0.09f;
-    static constexpr float WARM_SCALE = 0.85f;
+    ShapeTransform() = default;
+    ShapeTransform(const glm::vec3& p, const glm::quat& q) : Position(p), Orientation(q), Rotation(glm::mat3_cast(q)) {}
+    ShapeTransform(const glm::vec3& p, const glm::quat& q, const glm::mat3& r) : Position(p), Orientation(q), Rotation(r) {}
 
-public:
-    void WarmStart(Manifold& m) const {
-        auto it = C.find(m.Key());
-        if (it == C.end()) return;
-        for (auto& c : m.Contacts) {
-            float best = MATCH_SQ; const Cached* pick = nullptr;
-            for (const auto& cc : it->second) {
-                float d = glm::length2(c.LocalPointA - cc.LA) + glm::length2(c.LocalPointB - cc.LB);
-                if (d < best) { best = d; pick = &cc; }
-            }
-            if (pick) {
-                c.NormalImpulse = pick->NI * WARM_SCALE;
-                c.TangentImpulse0 = pick->T0 * WARM_SCALE;
-                c.TangentImpulse1 = pick->T1 * WARM_SCALE;
-            }
-        }
-    }
-    void Store(const Manifold& m) {
-        std::vector<Cached> v; v.reserve(m.Contacts.size());
-        for (const auto& c : m.Contacts)
-            v.push_back({ c.LocalPointA, c.LocalPointB, c.NormalImpulse, c.TangentImpulse0, c.TangentImpulse1 });
-        C[m.Key()] = std::move(v);
-    }
-    void Clear() { C.clear(); }
+    glm::vec3 LocalToWorld(const glm::vec3& lp) const { return Position + Rotation * lp; }
+    glm::vec3 WorldToLocal(const glm::vec3& wp) const { return glm::transpose(Rotation) * (wp - Position); }
 };
 
 inline void BuildTangentBasis(const glm::vec3& n, glm::vec3& t0, glm::vec3& t1) {
@@ -213,34 +88,59 @@ inline void BuildTangentBasis(const glm::vec3& n, glm::vec3& t0, glm::vec3& t1)
     t1 = glm::cross(n, t0);
 }
 
-inline float EffectiveMass(RigidBody* A, RigidBody* B,
+inline float EffectiveMass(const BodyStore& S, uint32_t a, uint32_t b,
     const glm::vec3& rA, const glm::vec3& rB, const glm::vec3& ax)
 {
     glm::vec3 rAxN = glm::cross(rA, ax), rBxN = glm::cross(rB, ax);
-    return A->InverseMass + B->InverseMass
-        + glm::dot(rAxN, A->InverseInertiaWorld * rAxN)
-        + glm::dot(rBxN, B->InverseInertiaWorld * rBxN);
+    return S.SolverInverseMass(a) + S.SolverInverseMass(b)
+        + glm::dot(rAxN, S.SolverInverseInertia(a) * rAxN)
+        + glm::dot(rBxN, S.SolverInverseInertia(b) * rBxN);
 }
 
-static std::vector<glm::vec3> ClipByPlane(const std::vector<glm::vec3>& poly,
-    const glm::vec3& n, float d)
-{
-    std::vector<glm::vec3> out;
-    size_t sz = poly.size();
-    for (size_t i = 0; i < sz; ++i) {
-        const glm::vec3& pA = poly[i], & pB = poly[(i + 1) % sz];
-        float dA = glm::dot(n, pA) - d, dB = glm::dot(n, pB) - d;
+// Clip vertices remember the polygon edges that meet at them: incident face
+// edges are 0-3 and the side planes of the reference face 4-7. The pair
+// names the vertex independently of where the boxes are, which is what the
+// manifold cache matches on.
+struct ClipVertex {
+    glm::vec3 P;
+    uint8_t   In = 0, Out = 0;
+};
+
+// A quad clipped by four planes keeps at most eight vertices.
+using ClipPolygon = FixedVector<ClipVertex, 8>;
+
+template<typename Polygon>
+static void ClipByPlane(const Polygon& poly, const glm::vec3& n, float d, uint8_t plane, Polygon& out) {
+    out.clear();
+    uint32_t sz = poly.size();
+    for (uint32_t i = 0; i < sz; ++i) {
+        const ClipVertex& vA = poly[i], & vB = poly[(i + 1) % sz];
+        float dA = glm::dot(n, vA.P) - d, dB = glm::dot(n, vB.P) - d;
         bool aIn = dA >= 0.0f, bIn = dB >= 0.0f;
-        if (aIn) out.push_back(pA);
-        if (aIn != bIn) { float t = dA / (dA - dB); out.push_back(pA + t * (pB - pA)); }
+        if (aIn) out.push_back(vA);
+        if (aIn != bIn) {
+            float t = dA / (dA - dB);
+            ClipVertex v{ vA.P + t * (vB.P - vA.P) };
+            // The cut edge is the one leaving vA; the plane continues or ends the polygon.
+            if (aIn) { v.In = vA.Out; v.Out = plane; }
+            else { v.In = plane; v.Out = vA.Out; }
+            out.push_back(v);
+        }
     }
-    return out;
 }
 
-static std::vector<glm::vec3> ClipToRefFace(const std::array<glm::vec3, 4>& iv,
-    const glm::vec3& fc, const glm::vec3& U, const glm::vec3& V, float hU, float hV)
+// Incident polygon with its edges numbered from 0: vertex i lies between
+// edge i - 1 and edge i.
+template<typename Polygon>
+static void MakeClipPolygon(const glm::vec3* verts, uint8_t count, Polygon& out) {
+    out.clear();
+    for (uint8_t i = 0; i < count; ++i) out.push_back({ verts[i], uint8_t((i + count - 1) % count), i });
+}
+
+// Clips `out` in place to the side planes of a rectangular reference face.
+static void ClipToRefFace(const glm::vec3& fc, const glm::vec3& U, const glm::vec3& V, float hU, float hV, ClipPolygon& out)
 {
-    std::vector<glm::vec3> p(iv.begin(), iv.end());
+    ClipPolygon tmp;
     struct Pl { glm::vec3 n; float d; };
     Pl planes[4] = {
         {  U,  glm::dot(U, fc) - hU },
@@ -248,18 +148,21 @@ static std::vector<glm::vec3> ClipToRefFace(const std::array<glm::vec3, 4>& iv,
         {  V,  glm::dot(V, fc) - hV },
         { -V,  glm::dot(-V, fc) - hV },
     };
-    for (const auto& pl : planes) { p = ClipByPlane(p, pl.n, pl.d); if (p.empty()) return p; }
-    return p;
+    for (uint8_t k = 0; k < 4; ++k) {
+        ClipByPlane(out, planes[k].n, planes[k].d, uint8_t(4 + k), tmp);
+        out = tmp;
+        if (out.empty()) return;
+    }
 }
 
-static void GetBoxFace(RigidBody* body, BoxShape* box, int axisIdx, int sign,
+static void GetBoxFace(const ShapeTransform& T, const BoxShape* box, int axisIdx, int sign,
     std::array<glm::vec3, 4>& verts, glm::vec3& center, glm::vec3& normal,
     glm::vec3& U, glm::vec3& V, float& hU, float& hV)
 {
-    glm::mat3 R = glm::mat3_cast(body->Orientation);
+    const glm::mat3& R = T.Rotation;
     int a = axisIdx, b = (a + 1) % 3, c = (a + 2) % 3;
     normal = R[a] * float(sign);
-    center = body->Position + normal * box->HalfExtents[a];
+    center = T.Position + normal * box->HalfExtents[a];
     U = R[b]; V = R[c]; hU = box->HalfExtents[b]; hV = box->HalfExtents[c];
     if (glm::dot(glm::cross(U, V), normal) < 0.0f) U = -U;
     verts[0] = center + U * hU + V * hV;
@@ -268,136 +171,230 @@ static void GetBoxFace(RigidBody* body, BoxShape* box, int axisIdx, int sign,
     verts[3] = center - U * hU + V * hV;
 }
 
-static float SATOverlap(const glm::vec3& axis, BoxShape* bA, RigidBody* rA, BoxShape* bB, RigidBody* rB) {
-    glm::mat3 RA = glm::mat3_cast(rA->Orientation), RB = glm::mat3_cast(rB->Orientation);
-    float pA = bA->HalfExtents.x * std::abs(glm::dot(RA[0], axis))
-        + bA->HalfExtents.y * std::abs(glm::dot(RA[1], axis))
-        + bA->HalfExtents.z * std::abs(glm::dot(RA[2], axis));
-    float pB = bB->HalfExtents.x * std::abs(glm::dot(RB[0], axis))
-        + bB->HalfExtents.y * std::abs(glm::dot(RB[1], axis))
-        + bB->HalfExtents.z * std::abs(glm::dot(RB[2], axis));
-    return (pA + pB) - std::abs(glm::dot(rB->Position - rA->Position, axis));
-}
-
-static void ReduceContacts(std::vector<ContactPoint>& pts) {
-    if (pts.size() <= 4) return;
-    auto it = std::max_element(pts.begin(), pts.end(),
-        [](const ContactPoint& a, const ContactPoint& b) { return a.Depth < b.Depth; });
-    std::vector<ContactPoint> r; r.push_back(*it); pts.erase(it);
-    while (r.size() < 4 && !pts.empty()) {
-        float best = -1.0f; auto bi = pts.begin();
-        for (auto jt = pts.begin(); jt != pts.end(); ++jt) {
+// Keeps the deepest point, then repeatedly the point farthest from those
+// already kept, until the manifold is full.
+// At most 64 candidates.
+static void ReduceContacts(const ContactPoint* pts, uint32_t count, Manifold& m) {
+    m.Contacts.clear();
+    if (count == 0) return;
+    assert(count <= 64);
+    uint64_t taken = 0;
+    uint32_t deepest = 0;
+    for (uint32_t i = 1; i < count; ++i) if (pts[i].Depth > pts[deepest].Depth) deepest = i;
+    m.Contacts.push_back(pts[deepest]); taken |= uint64_t(1) << deepest;
+    while (!m.Contacts.full() && m.Contacts.size() < count) {
+        float best = -1.0f; uint32_t bi = 0;
+        for (uint32_t j = 0; j < count; ++j) {
+            if (taken & (uint64_t(1) << j)) continue;
             float minD = FLT_MAX;
-            for (const auto& x : r) minD = std::min(minD, glm::length2(jt->WorldPointA - x.WorldPointA));
-            if (minD > best) { best = minD; bi = jt; }
+            for (const auto& x : m.Contacts) minD = std::min(minD, glm::length2(pts[j].WorldPointA - x.WorldPointA));
+            if (minD > best) { best = minD; bi = j; }
         }
-        r.push_back(*bi); pts.erase(bi);
+        m.Contacts.push_back(pts[bi]); taken |= uint64_t(1) << bi;
     }
-    pts = std::move(r);
 }
 
-inline bool TestSphereSphere(RigidBody* A, RigidBody* B, Manifold& m) {
-    auto* sA = static_cast<SphereShape*>(A->CollisionShape);
-    auto* sB = static_cast<SphereShape*>(B->CollisionShape);
-    glm::vec3 d = B->Position - A->Position;
+// Shape-vs-shape tests work on world transforms only and fill the normal
+// (pointing from A to B) plus world-space contact points and depths.
+// DispatchCollision fills in the body indices and local anchors.
+
+inline bool TestSphereSphere(const SphereShape* sA, const ShapeTransform& A,
+    const SphereShape* sB, const ShapeTransform& B, Manifold& m)
+{
+    glm::vec3 d = B.Position - A.Position;
     float d2 = glm::length2(d), rs = sA->Radius + sB->Radius;
     if (d2 > rs * rs) return false;
     float dist = std::sqrt(d2);
     glm::vec3 n = dist > 1e-8f ? d / dist : glm::vec3(0, 1, 0);
-    m.BodyA = A; m.BodyB = B; m.Normal = n;
+    m.Normal = n;
     ContactPoint c;
     c.Depth = rs - dist;
-    c.WorldPointA = A->Position + n * sA->Radius;
-    c.WorldPointB = B->Position - n * sB->Radius;
-    c.LocalPointA = A->WorldToLocal(c.WorldPointA);
-    c.LocalPointB = B->WorldToLocal(c.WorldPointB);
+    c.WorldPointA = A.Position + n * sA->Radius;
+    c.WorldPointB = B.Position - n * sB->Radius;
     m.Contacts.push_back(c); return true;
 }
 
-inline bool TestSphereBox(RigidBody* sph, RigidBody* box, Manifold& m) {
-    auto* S = static_cast<SphereShape*>(sph->CollisionShape);
-    auto* B = static_cast<BoxShape*>  (box->CollisionShape);
-    glm::vec3 lc = box->WorldToLocal(sph->Position);
+inline bool TestSphereBox(const SphereShape* S, const ShapeTransform& sph,
+    const BoxShape* B, const ShapeTransform& box, Manifold& m)
+{
+    glm::vec3 lc = box.WorldToLocal(sph.Position);
     glm::vec3 cl = glm::clamp(lc, -B->HalfExtents, B->HalfExtents);
     glm::vec3 df = lc - cl;
     float d2 = glm::length2(df);
     if (d2 > S->Radius * S->Radius) return false;
-    m.BodyA = sph; m.BodyB = box; m.Contacts.clear();
+    m.Contacts.clear();
     ContactPoint c;
     if (d2 > 1e-8f) {
         float dist = std::sqrt(d2);
-        m.Normal = -glm::normalize(box->Orientation * (df / dist));
+        m.Normal = -glm::normalize(box.Rotation * (df / dist));
         c.Depth = S->Radius - dist;
-        c.WorldPointA = sph->Position + m.Normal * S->Radius;
-        c.WorldPointB = box->LocalToWorld(cl);
+        c.WorldPointA = sph.Position + m.Normal * S->Radius;
+        c.WorldPointB = box.LocalToWorld(cl);
     }
     else {
         glm::vec3 d = B->HalfExtents - glm::abs(lc);
         int ax = 0; if (d.y < d.x) ax = 1; if (d.z < d[ax]) ax = 2;
         glm::vec3 fn(0.0f); fn[ax] = lc[ax] >= 0.0f ? 1.0f : -1.0f;
-        m.Normal = -glm::normalize(box->Orientation * fn);
+        m.Normal = -glm::normalize(box.Rotation * fn);
         c.Depth = S->Radius + d[ax];
-        c.WorldPointA = sph->Position - m.Normal * S->Radius;
-        c.WorldPointB = box->LocalToWorld(fn * B->HalfExtents[ax]);
+        c.WorldPointA = sph.Position - m.Normal * S->Radius;
+        c.WorldPointB = box.LocalToWorld(fn * B->HalfExtents[ax]);
     }
-    c.LocalPointA = sph->WorldToLocal(c.WorldPointA);
-    c.LocalPointB = box->WorldToLocal(c.WorldPointB);
     m.Contacts.push_back(c); return true;
 }
 
-inline bool TestBoxBox(RigidBody* A, RigidBody* B, Manifold& m) {
-    auto* bA = static_cast<BoxShape*>(A->CollisionShape);
-    auto* bB = static_cast<BoxShape*>(B->CollisionShape);
-    glm::mat3 RA = glm::mat3_cast(A->Orientation), RB = glm::mat3_cast(B->Orientation);
+// Closest points of the segments pA + u * s, |s| <= hu and pB + v * t,
+// |t| <= hv, with u and v unit length.
+inline void ClosestSegmentPoints(const glm::vec3& pA, const glm::vec3& u, float hu,
+    const glm::vec3& pB, const glm::vec3& v, float hv, float& s, float& t)
+{
+    glm::vec3 w = pA - pB;
+    float b = glm::dot(u, v), d = glm::dot(u, w), e = glm::dot(v, w), denom = 1.0f - b * b;
+    s = denom > 1e-6f ? std::clamp((b * e - d) / denom, -hu, hu) : 0.0f;
+    // The point of B closest to A's point, then, if that left B's range,
+    // the point of A closest to B's end.
+    t = e + b * s;
+    if (t < -hv || t > hv) {
+        t = std::clamp(t, -hv, hv);
+        s = std::clamp(b * t - d, -hu, hu);
+    }
+}
+
+// Single contact between the two edges that realize the separating axis
+// a_i x b_j: the closest points of the supporting edges of A and B.
+inline void BoxEdgeContact(const BoxShape* bA, const ShapeTransform& A, const BoxShape* bB, const ShapeTransform& B,
+    int i, int j, Manifold& m)
+{
+    const glm::mat3& RA = A.Rotation, & RB = B.Rotation;
+    const glm::vec3 hA = bA->HalfExtents, hB = bB->HalfExtents;
+    glm::vec3 n = glm::normalize(glm::cross(RA[i], RB[j]));
+    if (glm::dot(n, B.Position - A.Position) < 0.0f) n = -n;
+
+    // Centers of A's edge along a_i furthest along n and of B's edge along
+    // b_j furthest against it; the chosen signs name the edges.
+    glm::vec3 eA = A.Position, eB = B.Position;
+    uint32_t signs = 0;
+    for (int k = 0; k < 3; ++k) {
+        if (k != i) { bool pos = glm::dot(RA[k], n) >= 0.0f; eA += RA[k] * (pos ? hA[k] : -hA[k]); signs |= uint32_t(pos) << k; }
+        if (k != j) { bool pos = glm::dot(RB[k], n) < 0.0f;  eB += RB[k] * (pos ? hB[k] : -hB[k]); signs |= uint32_t(pos) << (3 + k); }
+    }
+
+    const glm::vec3& u = RA[i], & v = RB[j];
+    float s, t;
+    ClosestSegmentPoints(eA, u, hA[i], eB, v, hB[j], s, t);
 
-    float minOv = FLT_MAX;
-    int   bestIdx = 0;
-    bool  refIsA = true;
+    ContactPoint c;
+    c.WorldPointA = eA + u * s;
+    c.WorldPointB = eB + v * t;
+    c.Depth = std::max(glm::dot(c.WorldPointA - c.WorldPointB, n), 0.0f);
+    c.FeatureID = (1u << 20) | (uint32_t(i * 3 + j) << 6) | signs;
+    m.Normal = n; m.Contacts.clear();
+    m.Contacts.push_back(c);
+}
 
-    auto testFace = [&](const glm::vec3& ax, bool fromA, int idx) -> bool {
-        float ov = SATOverlap(ax, bA, A, bB, B);
-        if (ov < 0.0f) return false;
-        if (ov < minOv) { minOv = ov; refIsA = fromA; bestIdx = idx; }
+// Separating axis test over all 15 axes: 3 face normals of each box and
+// the 9 edge cross products. Every overlap comes from the one relative
+// rotation C[i][j] = a_i . b_j and the center offset in both frames, so no
+// axis is built or projected in world space. Face axes produce a clipped
+// manifold of up to four points, edge axes a single edge-edge point.
+inline bool TestBoxBox(const BoxShape* bA, const ShapeTransform& A,
+    const BoxShape* bB, const ShapeTransform& B, Manifold& m)
+{
+    const glm::mat3& RA = A.Rotation, & RB = B.Rotation;
+    const glm::vec3 hA = bA->HalfExtents, hB = bB->HalfExtents;
+    const glm::vec3 AB = B.Position - A.Position;
+
+    // Overlap along each axis; negative means the axis separates the boxes.
+    // Row i of C is built with A's face axis i, so most separated pairs are
+    // rejected before the rest of the matrix is computed. The epsilon keeps
+    // near-parallel edges from reporting a false separation.
+    float C[3][3], absC[3][3], tA[3], tB[3], faceOv[6], edgeOv[9];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) { C[i][j] = glm::dot(RA[i], RB[j]); absC[i][j] = std::abs(C[i][j]) + 1e-6f; }
+        tA[i] = glm::dot(AB, RA[i]);
+        faceOv[i] = hA[i] + hB[0] * absC[i][0] + hB[1] * absC[i][1] + hB[2] * absC[i][2] - std::abs(tA[i]);
+        if (faceOv[i] < 0.0f) return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        tB[i] = glm::dot(AB, RB[i]);
+        faceOv[3 + i] = hB[i] + hA[0] * absC[0][i] + hA[1] * absC[1][i] + hA[2] * absC[2][i] - std::abs(tB[i]);
+        if (faceOv[3 + i] < 0.0f) return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; ++j) {
+            const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+            float rA = hA[i1] * absC[i2][j] + hA[i2] * absC[i1][j];
+            float rB = hB[j1] * absC[i][j2] + hB[j2] * absC[i][j1];
+            float dist = std::abs(tA[i2] * C[i1][j] - tA[i1] * C[i2][j]);
+            float len2 = 1.0f - C[i][j] * C[i][j];   // |a_i x b_j|^2; parallel edges give no axis
+            edgeOv[i * 3 + j] = len2 > 1e-6f ? (rA + rB - dist) / std::sqrt(len2) : FLT_MAX;
+        }
+    }
+    for (float ov : edgeOv) if (ov < 0.0f) return false;
+
+    // B's faces only win by a margin, so resting contacts keep the same
+    // reference face (and with it their feature IDs) from step to step.
+    // Edge axes must beat the faces clearly as well: a nearly degenerate
+    // edge axis repeats a face axis and would trade a face manifold for a
+    // single point.
+    const float FACE_TOL = 0.005f, EDGE_REL = 0.95f, EDGE_TOL = 0.005f;
+    float minOv = faceOv[0];
+    int   bestFace = 0;
+    for (int k = 1; k < 6; ++k)
+        if (faceOv[k] + (k >= 3 ? FACE_TOL : 0.0f) < minOv) { minOv = faceOv[k]; bestFace = k; }
+    int bestEdge = (int)(std::min_element(edgeOv, edgeOv + 9) - edgeOv);
+    if (edgeOv[bestEdge] < EDGE_REL * minOv - EDGE_TOL) {
+        BoxEdgeContact(bA, A, bB, B, bestEdge / 3, bestEdge % 3, m);
         return true;
-        };
-    for (int i = 0; i < 3; ++i) if (!testFace(RA[i], true, i)) return false;
-    for (int i = 0; i < 3; ++i) if (!testFace(RB[i], false, i)) return false;
+    }
+    const bool refIsA = bestFace < 3;
+    const int  bestIdx = bestFace % 3;
 
-    RigidBody* refBody = refIsA ? A : B;   BoxShape* refBox = refIsA ? bA : bB;
-    RigidBody* incBody = refIsA ? B : A;   BoxShape* incBox = refIsA ? bB : bA;
-    glm::mat3  refR = glm::mat3_cast(refBody->Orientation);
-    glm::mat3  incR = glm::mat3_cast(incBody->Orientation);
-    glm::vec3  AB = B->Position - A->Position;
+    const ShapeTransform& refT = refIsA ? A : B;   const BoxShape* refBox = refIsA ? bA : bB;
+    const ShapeTransform& incT = refIsA ? B : A;   const BoxShape* incBox = refIsA ? bB : bA;
+    const glm::mat3& refR = refT.Rotation;
+    const glm::mat3& incR = incT.Rotation;
 
     glm::vec3 bestAx = refR[bestIdx];
     if (glm::dot(bestAx, AB) < 0.0f) bestAx = -bestAx;
 
-    m.BodyA = A; m.BodyB = B; m.Normal = bestAx; m.Contacts.clear();
+    m.Normal = bestAx; m.Contacts.clear();
 
-    int refSign = (glm::dot(refR[bestIdx], bestAx) >= 0.0f) ? +1 : -1;
+    // The reference face faces the incident box: along the normal for A,
+    // against it for B.
+    glm::vec3 toInc = refIsA ? bestAx : -bestAx;
+    int refSign = (glm::dot(refR[bestIdx], toInc) >= 0.0f) ? +1 : -1;
     std::array<glm::vec3, 4> refV;
     glm::vec3 refC, refN, refU, refVv; float hU, hV;
-    GetBoxFace(refBody, refBox, bestIdx, refSign, refV, refC, refN, refU, refVv, hU, hV);
+    GetBoxFace(refT, refBox, bestIdx, refSign, refV, refC, refN, refU, refVv, hU, hV);
 
+    // The incident face is the one most anti-parallel to the reference normal.
     int   incAx = 0;
-    float minDot = FLT_MAX;
+    float maxDot = -1.0f;
     for (int i = 0; i < 3; ++i) {
-        float d = glm::dot(incR[i], refN);
-        if (d < minDot) { minDot = d; incAx = i; }
+        float d = std::abs(glm::dot(incR[i], refN));
+        if (d > maxDot) { maxDot = d; incAx = i; }
     }
     int incSign = (glm::dot(incR[incAx], refN) >= 0.0f) ? -1 : +1;
     std::array<glm::vec3, 4> incV;
     glm::vec3 incC, incN, incU, incVv; float iHU, iHV;
-    GetBoxFace(incBody, incBox, incAx, incSign, incV, incC, incN, incU, incVv, iHU, iHV);
+    GetBoxFace(incT, incBox, incAx, incSign, incV, incC, incN, incU, incVv, iHU, iHV);
 
-    auto clipped = ClipToRefFace(incV, refC, refU, refVv, hU, hV);
+    ClipPolygon clipped;
+    MakeClipPolygon(incV.data(), 4, clipped);
+    ClipToRefFace(refC, refU, refVv, hU, hV, clipped);
     if (clipped.empty()) return false;
 
     float refD = glm::dot(refN, refC);
 
     const float KEEP_THRESHOLD = -0.01f;
+    const uint32_t faces = (uint32_t(refIsA) << 8) | (uint32_t(bestIdx * 2 + (refSign > 0)) << 4) | uint32_t(incAx * 2 + (incSign > 0));
 
-    for (const auto& p : clipped) {
+    ContactPoint candidates[ClipPolygon::Capacity];
+    uint32_t count = 0;
+    for (const auto& v : clipped) {
+        const glm::vec3& p = v.P;
         float depth = refD - glm::dot(refN, p);
         if (depth < KEEP_THRESHOLD) continue;
         ContactPoint c;
@@ -405,42 +402,1005 @@ inline bool TestBoxBox(RigidBody* A, RigidBody* B, Manifold& m) {
         glm::vec3 onRef = p + refN * depth;
         c.WorldPointA = refIsA ? onRef : p;
         c.WorldPointB = refIsA ? p : onRef;
-        c.LocalPointA = A->WorldToLocal(c.WorldPointA);
-        c.LocalPointB = B->WorldToLocal(c.WorldPointB);
+        c.FeatureID = (faces << 8) | (uint32_t(v.In) << 4) | v.Out;
+        candidates[count++] = c;
+    }
+    ReduceContacts(candidates, count, m);
+    return !m.Contacts.empty();
+}
+
+// Capsule tests work on the core segment, Position + Rotation[1] * t with
+// |t| <= HalfHeight, and add the radius afterwards.
+
+inline bool TestSphereCapsule(const SphereShape* S, const ShapeTransform& sph,
+    const CapsuleShape* C, const ShapeTransform& cap, Manifold& m)
+{
+    const glm::vec3 u = cap.Rotation[1];
+    const float t = std::clamp(glm::dot(sph.Position - cap.Position, u), -C->HalfHeight, C->HalfHeight);
+    const glm::vec3 q = cap.Position + u * t, d = q - sph.Position;
+    float d2 = glm::length2(d), rs = S->Radius + C->Radius;
+    if (d2 > rs * rs) return false;
+    float dist = std::sqrt(d2);
+    glm::vec3 n, t1;
+    if (dist > 1e-6f) n = d / dist;
+    else BuildTangentBasis(u, n, t1);   // center on the axis: any direction across it
+    m.Normal = n;
+    ContactPoint c;
+    c.Depth = rs - dist;
+    c.WorldPointA = sph.Position + n * S->Radius;
+    c.WorldPointB = q - n * C->Radius;
+    m.Contacts.push_back(c); return true;
+}
+
+// Closest points of two core segments. Nearly parallel capsules that
+// overlap along their length, like a log resting on another, touch along a
+// line, so both ends of the overlap become contacts.
+inline bool TestCapsuleCapsule(const CapsuleShape* cA, const ShapeTransform& A,
+    const CapsuleShape* cB, const ShapeTransform& B, Manifold& m)
+{
+    const glm::vec3 u = A.Rotation[1], v = B.Rotation[1];
+    const float hA = cA->HalfHeight, hB = cB->HalfHeight, rs = cA->Radius + cB->Radius;
+    float s, t;
+    ClosestSegmentPoints(A.Position, u, hA, B.Position, v, hB, s, t);
+    const glm::vec3 pa = A.Position + u * s, pb = B.Position + v * t, d = pb - pa;
+    float d2 = glm::length2(d);
+    if (d2 > rs * rs) return false;
+    float dist = std::sqrt(d2);
+    glm::vec3 n, t1;
+    if (dist > 1e-6f) n = d / dist;
+    else {
+        // Crossing cores: separate across both axes, or across the shared one.
+        n = glm::cross(u, v);
+        if (glm::length2(n) > 1e-6f) n = glm::normalize(n);
+        else BuildTangentBasis(u, n, t1);
+        if (glm::dot(n, B.Position - A.Position) < 0.0f) n = -n;
+    }
+    m.Normal = n;
+    m.Contacts.clear();
+
+    const float KEEP_THRESHOLD = -0.01f;
+    auto add = [&](const glm::vec3& a, const glm::vec3& b, uint32_t feature) {
+        float depth = rs - glm::dot(b - a, n);
+        if (depth < KEEP_THRESHOLD) return;
+        ContactPoint c;
+        c.Depth = std::max(depth, 0.0f);
+        c.WorldPointA = a + n * cA->Radius;
+        c.WorldPointB = b - n * cB->Radius;
+        c.FeatureID = feature;
         m.Contacts.push_back(c);
+    };
+    if (glm::length2(glm::cross(u, v)) < 0.0025f) {
+        float s0 = glm::dot(B.Position - v * hB - A.Position, u), s1 = glm::dot(B.Position + v * hB - A.Position, u);
+        float lo = std::max(-hA, std::min(s0, s1)), hi = std::min(hA, std::max(s0, s1));
+        if (hi - lo > 1e-4f) {
+            for (float sk : { lo, hi }) {
+                glm::vec3 a = A.Position + u * sk;
+                glm::vec3 b = B.Position + v * std::clamp(glm::dot(a - B.Position, v), -hB, hB);
+                add(a, b, sk == lo ? 1 : 2);
+            }
+        }
     }
-    if (m.Contacts.empty()) return false;
-    ReduceContacts(m.Contacts);
+    if (m.Contacts.empty()) add(pa, pb, 0);
+    return !m.Contacts.empty();
+}
+
+// Closest points of the segment c + u * t, |t| <= h, and the box |x| <= e,
+// both in the box's frame. The squared distance is a convex quadratic
+// between the parameters where the segment crosses a face plane, so each
+// piece is minimized in closed form. Returns the distance; 0 means the
+// segment touches the box.
+inline float ClosestSegmentBox(const glm::vec3& c, const glm::vec3& u, float h, const glm::vec3& e, float& t, glm::vec3& q) {
+    float cuts[8]; int n = 0;
+    cuts[n++] = -h;
+    for (int i = 0; i < 3; ++i) {
+        if (std::abs(u[i]) < 1e-8f) continue;
+        for (float b : { -e[i], e[i] }) {
+            float k = (b - c[i]) / u[i];
+            if (k > -h && k < h) cuts[n++] = k;
+        }
+    }
+    cuts[n++] = h;
+    for (int k = 1; k < n; ++k)
+        for (int j = k; j > 0 && cuts[j] < cuts[j - 1]; --j) std::swap(cuts[j], cuts[j - 1]);
+
+    float best = FLT_MAX; t = 0.0f;
+    for (int k = 0; k + 1 < n; ++k) {
+        // Which face planes the segment is outside of on this piece.
+        const float t0 = cuts[k], t1 = cuts[k + 1];
+        const glm::vec3 mid = c + u * (0.5f * (t0 + t1));
+        float uu = 0.0f, ub = 0.0f;
+        glm::vec3 bound(0.0f), active(0.0f);
+        for (int i = 0; i < 3; ++i) {
+            if (mid[i] > e[i]) bound[i] = e[i];
+            else if (mid[i] < -e[i]) bound[i] = -e[i];
+            else continue;
+            active[i] = 1.0f;
+            uu += u[i] * u[i]; ub += u[i] * (c[i] - bound[i]);
+        }
+        float tk = uu > 1e-12f ? std::clamp(-ub / uu, t0, t1) : 0.5f * (t0 + t1);
+        glm::vec3 off = (c + u * tk - bound) * active;
+        float f = glm::dot(off, off);
+        if (f < best) { best = f; t = tk; }
+    }
+    q = glm::clamp(c + u * t, -e, e);
+    return std::sqrt(best);
+}
+
+// A capsule lying on a box face gets the ends of its core clipped to the
+// face, so it rests on two points; edges and corners give one. A core that
+// reaches into the box is pushed out along the separating axis of least
+// overlap, over the box faces and the box edges crossed with the core.
+inline bool TestCapsuleBox(const CapsuleShape* C, const ShapeTransform& cap,
+    const BoxShape* B, const ShapeTransform& box, Manifold& m)
+{
+    const glm::mat3 toBox = glm::transpose(box.Rotation);
+    const glm::vec3 c = toBox * (cap.Position - box.Position), u = toBox * cap.Rotation[1];
+    const glm::vec3& e = B->HalfExtents;
+    const float R = C->Radius, h = C->HalfHeight;
+
+    float t; glm::vec3 q;
+    const float dist = ClosestSegmentBox(c, u, h, e, t, q);
+    if (dist > R) return false;
+
+    glm::vec3 n;   // from the capsule into the box, in the box's frame
+    float depth;
+    if (dist > 1e-6f) {
+        n = (q - (c + u * t)) / dist;
+        depth = R - dist;
+    }
+    else {
+        const float FACE_TOL = 0.005f, EDGE_REL = 0.95f, EDGE_TOL = 0.005f;
+        auto overlap = [&](const glm::vec3& L, glm::vec3& dir) {
+            float rB = e.x * std::abs(L.x) + e.y * std::abs(L.y) + e.z * std::abs(L.z);
+            float a0 = glm::dot(c - u * h, L), a1 = glm::dot(c + u * h, L);
+            float up = rB - std::min(a0, a1) + R, down = std::max(a0, a1) + R + rB;
+            dir = up < down ? -L : L;   // toward the box, seen from the capsule
+            return std::min(up, down);
+        };
+        depth = FLT_MAX;
+        for (int i = 0; i < 3; ++i) {
+            glm::vec3 L(0.0f), dir; L[i] = 1.0f;
+            float ov = overlap(L, dir);
+            if (ov + FACE_TOL < depth) { depth = ov; n = dir; }
+        }
+        float bestEdge = FLT_MAX; glm::vec3 edgeDir(0.0f);
+        for (int i = 0; i < 3; ++i) {
+            glm::vec3 axis(0.0f); axis[i] = 1.0f;
+            glm::vec3 L = glm::cross(axis, u);
+            if (glm::length2(L) < 1e-6f) continue;
+            glm::vec3 dir;
+            float ov = overlap(glm::normalize(L), dir);
+            if (ov < bestEdge) { bestEdge = ov; edgeDir = dir; }
+        }
+        if (bestEdge < EDGE_REL * depth - EDGE_TOL) { depth = bestEdge; n = edgeDir; }
+        // Deepest point of the core along n.
+        t = glm::dot(u, n) >= 0.0f ? h : -h;
+    }
+
+    m.Normal = box.Rotation * n;
+    m.Contacts.clear();
+    int i = 0; if (std::abs(n.y) > std::abs(n.x)) i = 1; if (std::abs(n.z) > std::abs(n[i])) i = 2;
+    if (std::abs(n[i]) > 0.999f) {
+        // Clip the core to the slab of the face it rests on.
+        const float s = n[i] > 0.0f ? -1.0f : 1.0f;   // side of the face, opposite n
+        float lo = -h, hi = h; uint8_t loPlane = 0, hiPlane = 0;
+        for (int j = 0; j < 3 && lo <= hi; ++j) {
+            if (j == i) continue;
+            if (std::abs(u[j]) < 1e-8f) { if (std::abs(c[j]) > e[j]) lo = hi + 1.0f; continue; }
+            float k0 = (-e[j] - c[j]) / u[j], k1 = (e[j] - c[j]) / u[j];
+            uint8_t p0 = uint8_t(1 + 2 * j), p1 = uint8_t(2 + 2 * j);
+            if (k0 > k1) { std::swap(k0, k1); std::swap(p0, p1); }
+            if (k0 > lo) { lo = k0; loPlane = p0; }
+            if (k1 < hi) { hi = k1; hiPlane = p1; }
+        }
+        const float KEEP_THRESHOLD = -0.01f;
+        const uint32_t face = uint32_t(1 + i * 2 + (s > 0.0f));
+        for (int end = 0; end < 2 && lo <= hi; ++end) {
+            if (end == 1 && hi - lo < 1e-6f) break;
+            const float tk = end == 0 ? lo : hi;
+            const glm::vec3 p = c + u * tk;
+            const float height = s * p[i] - e[i];   // of the core point above the face
+            const float d = R - height;
+            if (d < KEEP_THRESHOLD) continue;
+            ContactPoint cp;
+            cp.Depth = std::max(d, 0.0f);
+            cp.WorldPointA = box.LocalToWorld(p + n * R);
+            cp.WorldPointB = box.LocalToWorld(p + n * height);
+            cp.FeatureID = (face << 8) | (uint32_t(end) << 4) | (end == 0 ? loPlane : hiPlane);
+            m.Contacts.push_back(cp);
+        }
+        if (!m.Contacts.empty()) return true;
+    }
+    const glm::vec3 p = c + u * t;
+    ContactPoint cp;
+    cp.Depth = depth;
+    cp.WorldPointA = box.LocalToWorld(p + n * R);
+    cp.WorldPointB = box.LocalToWorld(p + n * (R - depth));
+    m.Contacts.push_back(cp);
+    return true;
+}
+
+// World-space support mapping of a shape for GJK and EPA. Spheres and
+// capsules are a point or segment core with their radius, so GJK finds
+// their distance exactly instead of approximating a curved surface.
+struct ShapeSupport {
+    const Shape*          S;
+    const ShapeTransform& X;
+    glm::mat3             ToLocal;
+    float                 Radius = 0.0f;
+    float                 HalfHeight = 0.0f;   // of a capsule's core
+
+    ShapeSupport(const Shape* s, const ShapeTransform& x) : S(s), X(x), ToLocal(glm::transpose(x.Rotation)) {
+        if (s->Type == ShapeType::Sphere) Radius = static_cast<const SphereShape*>(s)->Radius;
+        if (s->Type == ShapeType::Capsule) {
+            Radius = static_cast<const CapsuleShape*>(s)->Radius;
+            HalfHeight = static_cast<const CapsuleShape*>(s)->HalfHeight;
+        }
+    }
+    glm::vec3 Support(const glm::vec3& d) const {
+        if (S->Type == ShapeType::Sphere) return X.Position;
+        if (S->Type == ShapeType::Capsule) return X.Position + X.Rotation[1] * (glm::dot(X.Rotation[1], d) >= 0.0f ? HalfHeight : -HalfHeight);
+        return X.LocalToWorld(S->GetLocalSupport(ToLocal * d));
+    }
+};
+
+// The shape's support polygon facing `dir`, in world space.
+static void GetSupportFace(const ShapeSupport& s, const glm::vec3& dir, SupportFace& out) {
+    s.S->GetLocalSupportFace(s.ToLocal * dir, out);
+    for (auto& v : out) v = s.X.LocalToWorld(v);
+}
+
+// Polygons from support faces: up to 32 incident edges, each clipped by up
+// to 32 reference side planes.
+using ConvexClipPolygon = FixedVector<ClipVertex, 2 * MaxSupportFaceVertices>;
+
+// Turns a GJK/EPA contact into a manifold. When both shapes present a face
+// along the normal, the face better aligned with it is the reference and
+// the other is clipped to the planes through its edges, parallel to the
+// normal; clipped points are projected onto the reference plane along the
+// normal. A side line, as of a capsule or cylinder lying down, is clipped
+// the same way against the other shape's face. Otherwise, as for edges,
+// vertices and curved shapes, the single deepest point is the manifold.
+// Feature IDs name the clip edges, with bit 12 set when B holds the
+// reference face. A negative `depth` is a speculative contact: the shapes
+// are apart, and the points keep their gap instead of being clamped.
+static void BuildConvexManifold(const SupportFace& faceA, const SupportFace& faceB, const glm::vec3& n,
+    const glm::vec3& pointA, const glm::vec3& pointB, float depth, Manifold& m)
+{
+    m.Normal = n;
+    m.Contacts.clear();
+    auto faceNormal = [](const SupportFace& f) {
+        return glm::normalize(glm::cross(f[1] - f[0], f[2] - f[0]));
+    };
+    if (faceA.size() >= 2 && faceB.size() >= 2 && (faceA.size() >= 3 || faceB.size() >= 3)) {
+        glm::vec3 nA = faceA.size() >= 3 ? faceNormal(faceA) : glm::vec3(0.0f);
+        glm::vec3 nB = faceB.size() >= 3 ? faceNormal(faceB) : glm::vec3(0.0f);
+        float alignA = faceA.size() >= 3 ? glm::dot(nA, n) : -1.0f, alignB = faceB.size() >= 3 ? -glm::dot(nB, n) : -1.0f;
+        const bool swapped = alignB > alignA + 1e-3f;
+        const SupportFace& ref = swapped ? faceB : faceA, & inc = swapped ? faceA : faceB;
+        const glm::vec3 nRef = swapped ? nB : nA;
+        const float align = swapped ? alignB : alignA;
+        if (align > 0.1f) {
+            glm::vec3 centroid(0.0f);
+            for (const auto& v : ref) centroid += v;
+            centroid /= float(ref.size());
+
+            ConvexClipPolygon poly, tmp;
+            MakeClipPolygon(inc.begin(), (uint8_t)inc.size(), poly);
+            for (uint32_t k = 0; k < ref.size() && !poly.empty(); ++k) {
+                const glm::vec3& v0 = ref[k];
+                glm::vec3 side = glm::cross(n, ref[(k + 1) % ref.size()] - v0);
+                if (glm::dot(side, centroid - v0) < 0.0f) side = -side;
+                ClipByPlane(poly, side, glm::dot(side, v0), uint8_t(MaxSupportFaceVertices + k), tmp);
+                poly = tmp;
+            }
+
+            const float KEEP_THRESHOLD = -0.01f;
+            const float keep = std::min(KEEP_THRESHOLD, depth + KEEP_THRESHOLD);
+            const float dRef = glm::dot(nRef, ref[0]), nDot = glm::dot(nRef, n);
+            ContactPoint candidates[ConvexClipPolygon::Capacity];
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < poly.size(); ++i) {
+                const ClipVertex& v = poly[i];
+                // Distance along the normal from the incident point to the reference plane.
+                float t = swapped ? (glm::dot(nRef, v.P) - dRef) / nDot : (dRef - glm::dot(nRef, v.P)) / nDot;
+                if (t < keep) continue;
+                // A line clipped as a two-vertex polygon yields each cut twice, next to each other.
+                if (inc.size() == 2 && glm::length2(v.P - poly[(i + poly.size() - 1) % poly.size()].P) < 1e-10f) continue;
+                ContactPoint& c = candidates[count++];
+                c.Depth = depth >= 0.0f ? std::max(t, 0.0f) : t;
+                c.WorldPointA = swapped ? v.P : v.P + n * t;
+                c.WorldPointB = swapped ? v.P - n * t : v.P;
+                c.FeatureID = (uint32_t(swapped) << 12) | (uint32_t(v.In) << 6) | v.Out;
+            }
+            ReduceContacts(candidates, count, m);
+            if (!m.Contacts.empty()) return;
+        }
+    }
+    ContactPoint c;
+    c.WorldPointA = pointA; c.WorldPointB = pointB;
+    c.Depth = depth;
+    c.FeatureID = 1u << 13;
+    m.Contacts.push_back(c);
+}
+
+// Contact between any two shapes from their support mappings. GJK starts
+// from `simplex`, the pair's simplex of the previous step moved with the
+// bodies, and leaves the final one there. EPA runs only when the cores
+// overlap; for spheres that means deep penetration. Shapes up to
+// `speculative` apart still make a contact, with a negative depth.
+template<typename SA, typename SB>
+static bool ConvexContact(const SA& sa, const SB& sb, GjkSimplex& simplex, glm::vec3& n,
+    glm::vec3& pointA, glm::vec3& pointB, float& depth, float speculative = 0.0f)
+{
+    const float margin = sa.Radius + sb.Radius;
+    GjkResult r = GjkDistance(sa, sb, simplex, sa.Support(glm::vec3(1, 0, 0)) - sb.Support(glm::vec3(-1, 0, 0)), margin + speculative);
+    if (!r.Overlap && r.Distance > margin + speculative) return false;
+    if (!r.Overlap && r.Distance > 1e-5f) {
+        n = (r.PointB - r.PointA) / r.Distance;
+        depth = margin - r.Distance;
+        pointA = r.PointA + n * sa.Radius;
+        pointB = r.PointB - n * sb.Radius;
+        return true;
+    }
+    if (!Epa(sa, sb, simplex, n, depth, pointA, pointB)) return false;
+    depth += margin;
+    pointA += n * sa.Radius;
+    pointB -= n * sb.Radius;
+    return true;
+}
+
+inline bool TestConvex(const Shape* A, const ShapeTransform& xA, const Shape* B, const ShapeTransform& xB,
+    GjkSimplex& simplex, Manifold& m, float speculative = 0.0f)
+{
+    ShapeSupport sa(A, xA), sb(B, xB);
+    glm::vec3 n, pointA, pointB; float depth;
+    if (!ConvexContact(sa, sb, simplex, n, pointA, pointB, depth, speculative)) return false;
+    SupportFace faceA, faceB;
+    GetSupportFace(sa, n, faceA);
+    GetSupportFace(sb, -n, faceB);
+    BuildConvexManifold(faceA, faceB, n, pointA, pointB, depth, m);
     return true;
 }
 
-static void DispatchCollision(RigidBody* A, RigidBody* B, std::vector<Manifold>& out) {
-    if (!A->CollisionShape || !B->CollisionShape) return;
-    if (A->IsStatic() && B->IsStatic()) return;
-    if (!A->IsAwake && !B->IsAwake) return;
+// Closest point of triangle abc to p (Ericson, Real-Time Collision
+// Detection 5.1.5). `feature` names the region it lies in: the face (0), a
+// vertex (1-3) or the edge leaving a vertex (4-6).
+inline glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+    uint32_t& feature)
+{
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) { feature = 1; return a; }
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) { feature = 2; return b; }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) { feature = 4; return a + ab * (d1 / (d1 - d3)); }
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) { feature = 3; return c; }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) { feature = 6; return a + ac * (d2 / (d2 - d6)); }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) { feature = 5; return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))); }
+    float inv = 1.0f / (va + vb + vc);
+    feature = 0;
+    return a + ab * (vb * inv) + ac * (vc * inv);
+}
+
+// Triangle tests work in the mesh's frame and fill the normal pointing
+// from the shape into the mesh. Their feature IDs stay below bit
+// TriangleFeatureShift; AddTriangleContacts tags each point with its
+// triangle above that.
+constexpr uint32_t TriangleFeatureShift = 14;
+
+inline bool SphereTriangleContact(const glm::vec3& center, float radius,
+    const TriangleMeshShape::Triangle& tri, glm::vec3& normal, ContactPoint& c)
+{
+    glm::vec3 n = glm::cross(tri.V[1] - tri.V[0], tri.V[2] - tri.V[0]);
+    if (glm::dot(n, center - tri.V[0]) < 0.0f) return false;   // behind a one-sided triangle
+    uint32_t feature;
+    glm::vec3 q = ClosestPointOnTriangle(center, tri.V[0], tri.V[1], tri.V[2], feature);
+    glm::vec3 d = center - q;
+    float d2 = glm::length2(d);
+    if (d2 > radius * radius) return false;
+    float dist = std::sqrt(d2);
+    normal = dist > 1e-6f ? -d / dist : -glm::normalize(n);
+    c.Depth = radius - dist;
+    c.WorldPointA = center + normal * radius;
+    c.WorldPointB = q;
+    c.FeatureID = feature;
+    return true;
+}
+
+// Separating axis test of a box against one triangle over the triangle
+// normal, the three box faces and the nine edge cross products. Only axes
+// that push the box out of the front side count, and the triangle normal
+// wins ties, so a box sliding over a flat mesh does not catch on the edges
+// between its triangles. Returns the number of points written to `out`.
+inline uint32_t BoxTriangleContacts(const BoxShape* box, const ShapeTransform& xBox,
+    const TriangleMeshShape::Triangle& tri, glm::vec3& normal, ContactPoint* out)
+{
+    const glm::mat3& R = xBox.Rotation;
+    const glm::vec3 h = box->HalfExtents;
+    const glm::vec3 p[3] = { tri.V[0] - xBox.Position, tri.V[1] - xBox.Position, tri.V[2] - xBox.Position };
+    const glm::vec3 e[3] = { p[1] - p[0], p[2] - p[1], p[0] - p[2] };
+    const glm::vec3 n = glm::normalize(glm::cross(e[0], p[2] - p[0]));
+
+    float height = -glm::dot(n, p[0]);
+    if (height < 0.0f) return 0;
+    float best = h.x * std::abs(glm::dot(n, R[0])) + h.y * std::abs(glm::dot(n, R[1])) + h.z * std::abs(glm::dot(n, R[2])) - height;
+    if (best < 0.0f) return 0;
+
+    // Overlap along L and the direction that moves the box out the fastest.
+    auto overlap = [&](const glm::vec3& L, float r, glm::vec3& d) {
+        float t0 = glm::dot(p[0], L), t1 = glm::dot(p[1], L), t2 = glm::dot(p[2], L);
+        float up = std::max({ t0, t1, t2 }) + r, down = r - std::min({ t0, t1, t2 });
+        d = up < down ? L : -L;
+        return std::min(up, down);
+    };
+
+    const float FACE_TOL = 0.005f, EDGE_REL = 0.95f, EDGE_TOL = 0.005f;
+    glm::vec3 dir = n;   // moves the box out of the triangle
+    int axis = 0;        // 0 triangle face, 1-3 box face, 4-12 edge pair
+    for (int i = 0; i < 3; ++i) {
+        glm::vec3 d;
+        float ov = overlap(R[i], h[i], d);
+        if (ov < 0.0f) return 0;
+        if (glm::dot(d, n) > 0.0f && ov + FACE_TOL < best) { best = ov; dir = d; axis = 1 + i; }
+    }
+    float bestEdge = FLT_MAX; glm::vec3 edgeDir(0.0f); int edge = 0;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            glm::vec3 L = glm::cross(R[i], e[j]);
+            float len2 = glm::length2(L);
+            if (len2 < 1e-6f * glm::length2(e[j])) continue;   // parallel edges give no axis
+            L /= std::sqrt(len2);
+            float r = h.x * std::abs(glm::dot(R[0], L)) + h.y * std::abs(glm::dot(R[1], L)) + h.z * std::abs(glm::dot(R[2], L));
+            glm::vec3 d;
+            float ov = overlap(L, r, d);
+            if (ov < 0.0f) return 0;
+            if (glm::dot(d, n) > 0.0f && ov < bestEdge) { bestEdge = ov; edgeDir = d; edge = i * 3 + j; }
+        }
+    }
+    if (bestEdge < EDGE_REL * best - EDGE_TOL) { dir = edgeDir; axis = 4 + edge; }
+
+    const float KEEP_THRESHOLD = -0.01f;
+    uint32_t count = 0;
+    if (axis >= 4) {
+        // The box edge furthest against dir meets the triangle edge.
+        const int i = (axis - 4) / 3, j = (axis - 4) % 3;
+        glm::vec3 eB = xBox.Position;
+        uint32_t signs = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (k == i) continue;
+            bool pos = glm::dot(R[k], dir) < 0.0f;
+            eB += R[k] * (pos ? h[k] : -h[k]);
+            signs = (signs << 1) | uint32_t(pos);
+        }
+        float len = std::sqrt(glm::length2(e[j]));
+        glm::vec3 v = e[j] / len, mid = tri.V[j] + e[j] * 0.5f;
+        float s, t;
+        ClosestSegmentPoints(eB, R[i], h[i], mid, v, len * 0.5f, s, t);
+        normal = -dir;
+        ContactPoint& c = out[count++];
+        c = ContactPoint{};
+        c.WorldPointA = eB + R[i] * s;
+        c.WorldPointB = mid + v * t;
+        c.Depth = std::max(glm::dot(c.WorldPointA - c.WorldPointB, normal), 0.0f);
+        c.FeatureID = (uint32_t(7 + axis - 4) << 8) | signs;
+        return count;
+    }
+
+    std::array<glm::vec3, 4> verts;
+    glm::vec3 fc, fn, U, V; float hU, hV;
+    ClipPolygon poly, tmp;
+    if (axis == 0) {
+        // The box face most anti-parallel to the normal, clipped to the triangle.
+        int inc = 0; float maxDot = -1.0f;
+        for (int i = 0; i < 3; ++i) { float d = std::abs(glm::dot(R[i], n)); if (d > maxDot) { maxDot = d; inc = i; } }
+        GetBoxFace(xBox, box, inc, glm::dot(R[inc], n) >= 0.0f ? -1 : +1, verts, fc, fn, U, V, hU, hV);
+        MakeClipPolygon(verts.data(), 4, poly);
+        for (uint8_t k = 0; k < 3 && !poly.empty(); ++k) {
+            glm::vec3 side = glm::cross(n, tri.V[(k + 1) % 3] - tri.V[k]);
+            ClipByPlane(poly, side, glm::dot(side, tri.V[k]), uint8_t(4 + k), tmp);
+            poly = tmp;
+        }
+        normal = -n;
+        for (const auto& v : poly) {
+            float depth = glm::dot(n, tri.V[0] - v.P);
+            if (depth < KEEP_THRESHOLD) continue;
+            ContactPoint& c = out[count++];
+            c = ContactPoint{};
+            c.Depth = std::max(depth, 0.0f);
+            c.WorldPointA = v.P;
+            c.WorldPointB = v.P + n * depth;
+            c.FeatureID = (uint32_t(v.In) << 4) | v.Out;
+        }
+        return count;
+    }
+
+    // The box face facing the triangle, with the triangle clipped to it.
+    const int i = axis - 1, sign = glm::dot(R[i], dir) > 0.0f ? -1 : +1;
+    GetBoxFace(xBox, box, i, sign, verts, fc, fn, U, V, hU, hV);
+    MakeClipPolygon(tri.V, 3, poly);
+    ClipToRefFace(fc, U, V, hU, hV, poly);
+    normal = fn;
+    for (const auto& v : poly) {
+        float depth = glm::dot(fn, fc - v.P);
+        if (depth < KEEP_THRESHOLD) continue;
+        ContactPoint& c = out[count++];
+        c = ContactPoint{};
+        c.Depth = std::max(depth, 0.0f);
+        c.WorldPointA = v.P + fn * depth;
+        c.WorldPointB = v.P;
+        c.FeatureID = (uint32_t(1 + i * 2 + (sign > 0)) << 8) | (uint32_t(v.In) << 4) | v.Out;
+    }
+    return count;
+}
 
-    ShapeType tA = A->CollisionShape->Type, tB = B->CollisionShape->Type;
-    Manifold m; bool hit = false;
+// Adds one triangle's contacts to the manifolds out[first..]. Triangles
+// that push along the same normal, like the two halves of a quad, share a
+// manifold, so a box resting on a flat mesh keeps one four-point manifold.
+// The manifold's Key holds the index of its first triangle until
+// DispatchCollision turns it into a cache key, so a point's feature ID only
+// adds its triangle's offset from that one, shifted to TriangleFeatureShift.
+// Only two triangles of one manifold whose offsets differ by a multiple of
+// 2^18 could share an ID, and then only their warm start suffers.
+static void AddTriangleContacts(const glm::vec3& normal, uint32_t index, const ContactPoint* pts, uint32_t count,
+    std::vector<Manifold>& out, size_t first)
+{
+    if (count == 0) return;
+    for (size_t k = first; k < out.size(); ++k) {
+        Manifold& m = out[k];
+        if (glm::dot(m.Normal, normal) < 0.999f) continue;
+        ContactPoint merged[ClipPolygon::Capacity];
+        uint32_t n = 0;
+        for (const auto& c : m.Contacts) merged[n++] = c;
+        for (uint32_t i = 0; i < count && n < ClipPolygon::Capacity; ++i) {
+            bool shared = false;   // vertices on an edge both triangles own
+            for (const auto& c : m.Contacts) shared |= glm::length2(c.WorldPointB - pts[i].WorldPointB) < 1e-6f;
+            if (shared) continue;
+            merged[n] = pts[i];
+            merged[n++].FeatureID |= (index - (uint32_t)m.Key) << TriangleFeatureShift;
+        }
+        ReduceContacts(merged, n, m);
+        return;
+    }
+    Manifold m;
+    m.Normal = normal; m.Key = index;
+    ReduceContacts(pts, count, m);
+    out.push_back(m);
+}
+
+// Moves manifolds found in the mesh's frame to world space.
+static void MeshManifoldsToWorld(const ShapeTransform& xMesh, std::vector<Manifold>& out, size_t first) {
+    for (size_t k = first; k < out.size(); ++k) {
+        Manifold& m = out[k];
+        m.Normal = xMesh.Rotation * m.Normal;
+        for (auto& c : m.Contacts) {
+            c.WorldPointA = xMesh.LocalToWorld(c.WorldPointA);
+            c.WorldPointB = xMesh.LocalToWorld(c.WorldPointB);
+        }
+    }
+}
+
+// Support mapping of one mesh triangle, in the mesh's frame.
+struct TriangleSupport {
+    const TriangleMeshShape::Triangle& T;
+    float Radius = 0.0f;
+
+    glm::vec3 Support(const glm::vec3& d) const {
+        float d0 = glm::dot(T.V[0], d), d1 = glm::dot(T.V[1], d), d2 = glm::dot(T.V[2], d);
+        return d0 >= d1 && d0 >= d2 ? T.V[0] : (d1 >= d2 ? T.V[1] : T.V[2]);
+    }
+};
+
+// Any convex shape against one triangle, through GJK and EPA. As in the box
+// test, the triangle normal is kept unless another direction separates the
+// shape with clearly less motion, and a direction that would push the shape
+// behind the triangle never wins. Triangles are visited once per query, so
+// there is no simplex to warm start from. A shape up to `speculative` away
+// gets a speculative contact along the closest points instead.
+inline bool ConvexTriangleContacts(const ShapeSupport& shape, const TriangleMeshShape::Triangle& tri, Manifold& m,
+    float speculative = 0.0f)
+{
+    glm::vec3 triN = glm::normalize(glm::cross(tri.V[1] - tri.V[0], tri.V[2] - tri.V[0]));
+    if (glm::dot(triN, shape.X.Position - tri.V[0]) < 0.0f) return false;   // behind a one-sided triangle
+    glm::vec3 deepest = shape.Support(-triN) - triN * shape.Radius;
+    float faceDepth = glm::dot(triN, tri.V[0] - deepest);
+    if (faceDepth < -speculative) return false;
+
+    TriangleSupport ts{ tri };
+    GjkSimplex simplex;
+    glm::vec3 n, pointA, pointB; float depth;
+    if (!ConvexContact(shape, ts, simplex, n, pointA, pointB, depth, speculative)) return false;
+
+    const float EDGE_REL = 0.95f, EDGE_TOL = 0.005f;
+    const bool apart = depth < 0.0f;
+    if (glm::dot(n, triN) >= 0.0f || (!apart && !(depth < EDGE_REL * faceDepth - EDGE_TOL))) {
+        n = -triN; depth = faceDepth;
+        pointA = deepest; pointB = deepest + triN * faceDepth;
+    }
+    SupportFace faceA, faceB;
+    GetSupportFace(shape, n, faceA);
+    for (const glm::vec3& v : tri.V) faceB.push_back(v);
+    BuildConvexManifold(faceA, faceB, n, pointA, pointB, depth, m);
+    return true;
+}
+
+// Mesh tests append one manifold per group of triangles instead of filling
+// a single one; only the triangles the mesh's Query reports for the
+// shape's bounds are visited. They serve any static triangle source with
+// that Query: TriangleMeshShape and HeightfieldShape. With a `speculative`
+// distance, triangles the dedicated tests find apart but within it get a
+// speculative contact from ConvexTriangleContacts.
+template<typename Mesh>
+void TestSphereMesh(const SphereShape* S, const ShapeTransform& sph,
+    const Mesh* mesh, const ShapeTransform& xMesh, std::vector<Manifold>& out, float speculative = 0.0f)
+{
+    const size_t first = out.size();
+    const glm::vec3 center = xMesh.WorldToLocal(sph.Position);
+    const AABB bounds(center - glm::vec3(S->Radius + speculative), center + glm::vec3(S->Radius + speculative));
+    const ShapeTransform local(center, glm::quat(1, 0, 0, 0), glm::mat3(1.0f));
+    const ShapeSupport support(S, local);
+    mesh->Query(bounds, [&](uint32_t index, const TriangleMeshShape::Triangle& tri) {
+        glm::vec3 normal; ContactPoint c; Manifold m;
+        if (SphereTriangleContact(center, S->Radius, tri, normal, c)) AddTriangleContacts(normal, index, &c, 1, out, first);
+        else if (speculative > 0.0f && ConvexTriangleContacts(support, tri, m, speculative))
+            AddTriangleContacts(m.Normal, index, m.Contacts.begin(), m.Contacts.size(), out, first);
+        });
+    MeshManifoldsToWorld(xMesh, out, first);
+}
+
+template<typename Mesh>
+void TestBoxMesh(const BoxShape* B, const ShapeTransform& box,
+    const Mesh* mesh, const ShapeTransform& xMesh, std::vector<Manifold>& out, float speculative = 0.0f)
+{
+    const size_t first = out.size();
+    const glm::mat3 toMesh = glm::transpose(xMesh.Rotation);
+    const ShapeTransform local(xMesh.WorldToLocal(box.Position), glm::conjugate(xMesh.Orientation) * box.Orientation, toMesh * box.Rotation);
+    const glm::mat3& R = local.Rotation;
+    const glm::vec3 ext = glm::abs(R[0]) * B->HalfExtents.x + glm::abs(R[1]) * B->HalfExtents.y + glm::abs(R[2]) * B->HalfExtents.z
+        + glm::vec3(speculative);
+    const AABB bounds(local.Position - ext, local.Position + ext);
+    const ShapeSupport support(B, local);
+    mesh->Query(bounds, [&](uint32_t index, const TriangleMeshShape::Triangle& tri) {
+        glm::vec3 lo = glm::min(tri.V[0], glm::min(tri.V[1], tri.V[2])), hi = glm::max(tri.V[0], glm::max(tri.V[1], tri.V[2]));
+        if (!bounds.Overlaps({ lo, hi })) return;
+        glm::vec3 normal; ContactPoint pts[ClipPolygon::Capacity]; Manifold m;
+        uint32_t count = BoxTriangleContacts(B, local, tri, normal, pts);
+        if (count > 0) AddTriangleContacts(normal, index, pts, count, out, first);
+        else if (speculative > 0.0f && ConvexTriangleContacts(support, tri, m, speculative))
+            AddTriangleContacts(m.Normal, index, m.Contacts.begin(), m.Contacts.size(), out, first);
+        });
+    MeshManifoldsToWorld(xMesh, out, first);
+}
+
+template<typename Mesh>
+void TestConvexMesh(const Shape* S, const ShapeTransform& xS,
+    const Mesh* mesh, const ShapeTransform& xMesh, std::vector<Manifold>& out, float speculative = 0.0f)
+{
+    const size_t first = out.size();
+    const ShapeTransform local(xMesh.WorldToLocal(xS.Position), glm::conjugate(xMesh.Orientation) * xS.Orientation,
+        glm::transpose(xMesh.Rotation) * xS.Rotation);
+    const AABB lb = S->ComputeLocalAABB();
+    const glm::vec3 c = local.LocalToWorld((lb.Min + lb.Max) * 0.5f), h = (lb.Max - lb.Min) * 0.5f;
+    const glm::mat3& R = local.Rotation;
+    const glm::vec3 ext = glm::abs(R[0]) * h.x + glm::abs(R[1]) * h.y + glm::abs(R[2]) * h.z + glm::vec3(speculative);
+    const AABB bounds(c - ext, c + ext);
+    const ShapeSupport support(S, local);
+    mesh->Query(bounds, [&](uint32_t index, const TriangleMeshShape::Triangle& tri) {
+        glm::vec3 lo = glm::min(tri.V[0], glm::min(tri.V[1], tri.V[2])), hi = glm::max(tri.V[0], glm::max(tri.V[1], tri.V[2]));
+        if (!bounds.Overlaps({ lo, hi })) return;
+        Manifold m;
+        if (ConvexTriangleContacts(support, tri, m, speculative)) AddTriangleContacts(m.Normal, index, m.Contacts.begin(), m.Contacts.size(), out, first);
+        });
+    MeshManifoldsToWorld(xMesh, out, first);
+}
+
+// Shapes made of triangles, which only ever collide as body B of a mesh pair.
+inline bool IsMeshShape(const Shape* s) {
+    return s->Type == ShapeType::TriangleMesh || s->Type == ShapeType::Heightfield;
+}
+
+// Appends the manifolds of a convex shape against a mesh, with the mesh as
+// B so the normals point into it. Each manifold's Key holds the index of
+// its first triangle until the caller turns it into a sub-shape key.
+static void CollideMesh(const Shape* sA, const ShapeTransform& xA, const Shape* mesh, const ShapeTransform& xB,
+    std::vector<Manifold>& out, float speculative)
+{
+    auto collide = [&](const auto* m) {
+        if (sA->Type == ShapeType::Sphere)
+            TestSphereMesh(static_cast<const SphereShape*>(sA), xA, m, xB, out, speculative);
+        else if (sA->Type == ShapeType::Box)
+            TestBoxMesh(static_cast<const BoxShape*>(sA), xA, m, xB, out, speculative);
+        else
+            TestConvexMesh(sA, xA, m, xB, out, speculative);
+    };
+    if (mesh->Type == ShapeType::Heightfield) collide(static_cast<const HeightfieldShape*>(mesh));
+    else collide(static_cast<const TriangleMeshShape*>(mesh));
+}
+
+// Per-participant narrowphase output: the manifolds found and the GJK
+// simplices to remember for the next step.
+struct NarrowphaseBuffer {
+    std::vector<Manifold>      Manifolds;
+    std::vector<CachedSimplex> Simplices;
+
+    void clear() { Manifolds.clear(); Simplices.clear(); }
+};
+
+// Pairs without a dedicated test go through GJK/EPA. The cached simplex is
+// kept in the frame of each shape, with LocalA on the body with the lower
+// ID (`flipped` when that is B), since A and B swap when the bodies' dense
+// indices do.
+static bool DispatchConvexCollision(const Shape* sA, const ShapeTransform& xA, const Shape* sB, const ShapeTransform& xB,
+    uint64_t key, bool flipped, const SimplexCache& simplices, NarrowphaseBuffer& out, Manifold& m, float speculative = 0.0f)
+{
+    GjkSimplex simplex;
+    if (const CachedSimplex* cached = simplices.Find(key)) {
+        for (uint32_t k = 0; k < cached->Count; ++k) {
+            GjkVertex v;
+            v.A = xA.LocalToWorld(flipped ? cached->LocalB[k] : cached->LocalA[k]);
+            v.B = xB.LocalToWorld(flipped ? cached->LocalA[k] : cached->LocalB[k]);
+            v.W = v.A - v.B;
+            simplex.push_back(v);
+        }
+    }
+    bool hit = TestConvex(sA, xA, sB, xB, simplex, m, speculative);
+
+    CachedSimplex stored;
+    stored.Key = key; stored.Count = simplex.size();
+    for (uint32_t k = 0; k < simplex.size(); ++k) {
+        glm::vec3 la = xA.WorldToLocal(simplex[k].A), lb = xB.WorldToLocal(simplex[k].B);
+        stored.LocalA[k] = flipped ? lb : la;
+        stored.LocalB[k] = flipped ? la : lb;
+    }
+    out.Simplices.push_back(stored);
+    return hit;
+}
+
+// Collides two shapes that are not compounds; B may be a mesh. Appends the
+// manifolds with world points only, keyed by `key` (or a sub-shape key of
+// it per mesh triangle). Shapes that are apart but within `speculative` of
+// each other get a speculative manifold from the GJK path, which the
+// dedicated tests do not make.
+static void CollideShapes(const Shape* sA, const ShapeTransform& xA, const Shape* sB, const ShapeTransform& xB,
+    uint64_t key, bool flipped, const SimplexCache& simplices, NarrowphaseBuffer& out, float speculative)
+{
+    if (IsMeshShape(sB)) {
+        const size_t first = out.Manifolds.size();
+        CollideMesh(sA, xA, sB, xB, out.Manifolds, speculative);
+        for (size_t k = first; k < out.Manifolds.size(); ++k)
+            out.Manifolds[k].Key = MakeSubShapeKey(key, (uint32_t)out.Manifolds[k].Key);
+        return;
+    }
+
+    ShapeType tA = sA->Type, tB = sB->Type;
+    Manifold m; bool hit = false, dedicated = true;
 
     auto flip = [](Manifold& m) {
-        m.Normal = -m.Normal; std::swap(m.BodyA, m.BodyB);
-        for (auto& c : m.Contacts) { std::swap(c.WorldPointA, c.WorldPointB); std::swap(c.LocalPointA, c.LocalPointB); }
+        m.Normal = -m.Normal;
+        for (auto& c : m.Contacts) std::swap(c.WorldPointA, c.WorldPointB);
         };
 
-    if (tA == ShapeType::Sphere && tB == ShapeType::Sphere) hit = TestSphereSphere(A, B, m);
-    else if (tA == ShapeType::Sphere && tB == ShapeType::Box) hit = TestSphereBox(A, B, m);
-    else if (tA == ShapeType::Box && tB == ShapeType::Sphere) { hit = TestSphereBox(B, A, m); if (hit) flip(m); }
-    else if (tA == ShapeType::Box && tB == ShapeType::Box) hit = TestBoxBox(A, B, m);
+    if (tA == ShapeType::Sphere && tB == ShapeType::Sphere)
+        hit = TestSphereSphere(static_cast<const SphereShape*>(sA), xA, static_cast<const SphereShape*>(sB), xB, m);
+    else if (tA == ShapeType::Sphere && tB == ShapeType::Box)
+        hit = TestSphereBox(static_cast<const SphereShape*>(sA), xA, static_cast<const BoxShape*>(sB), xB, m);
+    else if (tA == ShapeType::Box && tB == ShapeType::Sphere) {
+        hit = TestSphereBox(static_cast<const SphereShape*>(sB), xB, static_cast<const BoxShape*>(sA), xA, m);
+        if (hit) flip(m);
+    }
+    else if (tA == ShapeType::Box && tB == ShapeType::Box)
+        hit = TestBoxBox(static_cast<const BoxShape*>(sA), xA, static_cast<const BoxShape*>(sB), xB, m);
+    else if (tA == ShapeType::Sphere && tB == ShapeType::Capsule)
+        hit = TestSphereCapsule(static_cast<const SphereShape*>(sA), xA, static_cast<const CapsuleShape*>(sB), xB, m);
+    else if (tA == ShapeType::Capsule && tB == ShapeType::Sphere) {
+        hit = TestSphereCapsule(static_cast<const SphereShape*>(sB), xB, static_cast<const CapsuleShape*>(sA), xA, m);
+        if (hit) flip(m);
+    }
+    else if (tA == ShapeType::Capsule && tB == ShapeType::Capsule)
+        hit = TestCapsuleCapsule(static_cast<const CapsuleShape*>(sA), xA, static_cast<const CapsuleShape*>(sB), xB, m);
+    else if (tA == ShapeType::Capsule && tB == ShapeType::Box)
+        hit = TestCapsuleBox(static_cast<const CapsuleShape*>(sA), xA, static_cast<const BoxShape*>(sB), xB, m);
+    else if (tA == ShapeType::Box && tB == ShapeType::Capsule) {
+        hit = TestCapsuleBox(static_cast<const CapsuleShape*>(sB), xB, static_cast<const BoxShape*>(sA), xA, m);
+        if (hit) flip(m);
+    }
+    else {
+        hit = DispatchConvexCollision(sA, xA, sB, xB, key, flipped, simplices, out, m, speculative);
+        dedicated = false;
+    }
+    if (!hit && dedicated && speculative > 0.0f)
+        hit = DispatchConvexCollision(sA, xA, sB, xB, key, flipped, simplices, out, m, speculative);
+
+    if (!hit || m.Contacts.empty()) return;
+    m.Key = key;
+    out.Manifolds.push_back(std::move(m));
+}
+
+// World pose of a compound's child.
+inline ShapeTransform ChildTransform(const ShapeTransform& x, const CompoundShape::Child& c) {
+    return { x.LocalToWorld(c.Position), x.Orientation * c.Orientation, x.Rotation * c.Rotation };
+}
+
+// Collides the children of A that overlap B with the children of B that
+// overlap them; a body that is not a compound is its own single child 0.
+// Each pair of children gets its own key, built from the child of the
+// lower-ID body first so it does not depend on the order of A and B.
+static void CollideCompound(const Shape* sA, const ShapeTransform& xA, const Shape* sB, const ShapeTransform& xB,
+    uint64_t pairKey, bool flipped, const SimplexCache& simplices, NarrowphaseBuffer& out, float speculative)
+{
+    // Calls cb(index, shape, transform) for the parts of `s` whose bounds
+    // come within `speculative` of `other`'s, both given in their own frames.
+    auto forEachPart = [&](const Shape* s, const ShapeTransform& x, const AABB& other, const ShapeTransform& xOther, auto&& cb) {
+        if (s->Type != ShapeType::Compound) { cb(0u, s, x); return; }
+        const glm::mat3 toLocal = glm::transpose(x.Rotation);
+        const AABB box = other.Expanded(speculative).Transformed(toLocal * xOther.Rotation, toLocal * (xOther.Position - x.Position));
+        static_cast<const CompoundShape*>(s)->Query(box, [&](uint32_t i, const CompoundShape::Child& c) {
+            cb(i, c.ChildShape, ChildTransform(x, c));
+            });
+    };
+    auto boundsOf = [](const Shape* s, const ShapeTransform& x, uint32_t part, const ShapeTransform& xPart) {
+        // A child's bounds in its compound's frame are tighter than its own rotated ones.
+        if (s->Type == ShapeType::Compound) return std::make_pair(static_cast<const CompoundShape*>(s)->GetChildBounds(part), x);
+        return std::make_pair(s->ComputeLocalAABB(), xPart);
+    };
+
+    forEachPart(sA, xA, sB->ComputeLocalAABB(), xB, [&](uint32_t i, const Shape* childA, const ShapeTransform& xChildA) {
+        const auto [boundsA, frameA] = boundsOf(sA, xA, i, xChildA);
+        forEachPart(sB, xB, boundsA, frameA, [&](uint32_t j, const Shape* childB, const ShapeTransform& xChildB) {
+            const uint64_t key = flipped ? MakeSubShapeKey(MakeSubShapeKey(pairKey, j), i) : MakeSubShapeKey(MakeSubShapeKey(pairKey, i), j);
+            CollideShapes(childA, xChildA, childB, xChildB, key, flipped, simplices, out, speculative);
+            });
+        });
+}
+
+// `speculative` is how far apart the shapes may be and still get a contact,
+// for bodies closing in fast enough to meet within the substep.
+static void DispatchCollision(const BodyStore& S, uint32_t a, uint32_t b, const SimplexCache& simplices, NarrowphaseBuffer& out,
+    float speculative = 0.0f)
+{
+    if (!S.Info[a].CollisionShape || !S.Info[b].CollisionShape) return;
+    if (S.Info[a].IsStatic() && S.Info[b].IsStatic()) return;
+    if (!S.Info[a].IsAwake && !S.Info[b].IsAwake) return;
+    // Meshes are always body B, so the normals point into them.
+    if (IsMeshShape(S.Info[a].CollisionShape)) std::swap(a, b);
+    const BodyInfo& A = S.Info[a], & B = S.Info[b];
+    if (IsMeshShape(A.CollisionShape)) return;
+
+    ShapeTransform xA(S.Position[a], S.Orientation[a], S.Rotation[a]), xB(S.Position[b], S.Orientation[b], S.Rotation[b]);
+    const uint64_t pairKey = MakePairKey(A.ID, B.ID);
+    const bool flipped = A.ID > B.ID;
+    const size_t first = out.Manifolds.size();
+    if (A.CollisionShape->Type == ShapeType::Compound || B.CollisionShape->Type == ShapeType::Compound)
+        CollideCompound(A.CollisionShape, xA, B.CollisionShape, xB, pairKey, flipped, simplices, out, speculative);
+    else
+        CollideShapes(A.CollisionShape, xA, B.CollisionShape, xB, pairKey, flipped, simplices, out, speculative);
+
+    for (size_t k = first; k < out.Manifolds.size(); ++k) {
+        Manifold& m = out.Manifolds[k];
+        m.BodyA = a; m.BodyB = b;
+        for (auto& c : m.Contacts) {
+            c.LocalPointA = xA.WorldToLocal(c.WorldPointA);
+            c.LocalPointB = xB.WorldToLocal(c.WorldPointB);
+        }
+    }
+}
+
+// Motion of a body over a substep: a straight path from Start, turning by
+// Angle about Axis on the way, as the integrator moves it. Reach bounds the
+// distance of its surface from its origin, so no point of it moves further
+// than |Delta| + Angle * Reach.
+struct SweepMotion {
+    ShapeTransform Start;
+    glm::vec3      Delta{ 0.0f };
+    glm::vec3      Axis{ 0, 1, 0 };
+    float          Angle = 0.0f, Reach = 0.0f;
+
+    ShapeTransform At(float t) const {
+        return { Start.Position + Delta * t, glm::normalize(glm::angleAxis(Angle * t, Axis) * Start.Orientation) };
+    }
+
+    // The same motion seen from a frame that does not move.
+    SweepMotion InFrame(const ShapeTransform& x) const {
+        const glm::mat3 toLocal = glm::transpose(x.Rotation);
+        return { { x.WorldToLocal(Start.Position), glm::conjugate(x.Orientation) * Start.Orientation, toLocal * Start.Rotation },
+            toLocal * Delta, toLocal * Axis, Angle, Reach };
+    }
+};
 
-    if (hit && !m.Contacts.empty()) out.push_back(std::move(m));
+// Fraction of `motion` the part of A placed by poseAt(t) can make before
+// its surface comes within `target` of B, by conservative advancement: each
+// step advances by the remaining distance over the fastest any point of A
+// can approach B, its speed along the closest direction plus `spin`, so A
+// never passes through it. Without spin the distance along the path is
+// convex, so A misses once it stops shrinking. A that starts closer than
+// `target` may close half of what is left; one that starts touching is
+// left to the contacts. Returns 1 when A makes the whole move.
+template<typename PoseAt, typename SB>
+static float TimeOfImpact(const Shape* sA, PoseAt&& poseAt, const SweepMotion& motion, float spin, const SB& b, float target) {
+    float t = 0.0f;
+    for (int iter = 0; iter < 32; ++iter) {
+        const ShapeTransform x = poseAt(t);
+        const ShapeSupport a(sA, x);
+        GjkSimplex simplex;
+        GjkResult r = GjkDistance(a, b, simplex, motion.Delta, FLT_MAX);
+        float dist = r.Overlap ? 0.0f : r.Distance - a.Radius - b.Radius;
+        if (iter == 0) {
+            if (dist <= 1e-4f) return 1.0f;
+            target = std::min(target, 0.5f * dist);
+        }
+        if (dist <= target) return t;
+        float approach = glm::dot(motion.Delta, (r.PointB - r.PointA) / r.Distance) + spin;
+        if (approach <= 0.0f) return 1.0f;
+        t += (dist - 0.5f * target) / approach;
+        if (t >= 1.0f) return 1.0f;
+    }
+    return t;
 }
 
+// Time of impact of shape A, on `motion`, against shape B, over every child
+// of compounds and every triangle of meshes near the path. Triangles are
+// one-sided as in the narrowphase: only those A moves into from the front
+// count.
+static float SweepShapes(const Shape* sA, const SweepMotion& motion, const Shape* sB, const ShapeTransform& xB) {
+    const float TARGET = 0.01f;
+    // A sphere's surface does not move as it turns.
+    const float spin = sA->Type == ShapeType::Sphere ? 0.0f : motion.Angle * motion.Reach;
+    float t = 1.0f;
+    auto sweepParts = [&](const SweepMotion& m, const auto& b) {
+        if (sA->Type != ShapeType::Compound)
+            return TimeOfImpact(sA, [&](float u) { return m.At(u); }, m, spin, b, TARGET);
+        float tc = 1.0f;
+        for (const CompoundShape::Child& c : static_cast<const CompoundShape*>(sA)->GetChildren())
+            tc = std::min(tc, TimeOfImpact(c.ChildShape, [&](float u) { return ChildTransform(m.At(u), c); }, m, spin, b, TARGET));
+        return tc;
+    };
+    if (!IsMeshShape(sB) && sB->Type != ShapeType::Compound)
+        return sweepParts(motion, ShapeSupport(sB, xB));
+
+    // Bounds of A over its path, in B's frame.
+    const SweepMotion local = motion.InFrame(xB);
+    const AABB start(local.Start.Position - glm::vec3(local.Reach), local.Start.Position + glm::vec3(local.Reach));
+    const AABB path = AABB::Union(start, { start.Min + local.Delta, start.Max + local.Delta }).Expanded(TARGET);
+
+    if (sB->Type == ShapeType::Compound) {
+        static_cast<const CompoundShape*>(sB)->Query(path, [&](uint32_t, const CompoundShape::Child& c) {
+            const ShapeTransform xChild = ChildTransform(xB, c);
+            t = std::min(t, sweepParts(motion, ShapeSupport(c.ChildShape, xChild)));
+            });
+        return t;
+    }
+    auto sweep = [&](const auto* mesh) {
+        mesh->Query(path, [&](uint32_t, const TriangleMeshShape::Triangle& tri) {
+            glm::vec3 triN = glm::cross(tri.V[1] - tri.V[0], tri.V[2] - tri.V[0]);
+            if (glm::dot(triN, local.Start.Position - tri.V[0]) < 0.0f) return;
+            if (spin == 0.0f && glm::dot(triN, local.Delta) >= 0.0f) return;
+            t = std::min(t, sweepParts(local, TriangleSupport{ tri }));
+            });
+    };
+    if (sB->Type == ShapeType::Heightfield) sweep(static_cast<const HeightfieldShape*>(sB));
+    else sweep(static_cast<const TriangleMeshShape*>(sB));
+    return t;
+}
+
+enum class BroadphaseType { SortAndSweep, DynamicTree };
+
+// Both broadphases report every fat-AABB overlap the CollisionFilter lets
+// through; static-static pairs never pass it. Sleeping pairs are kept
+// because the result is cached across steps. Static bodies are not part of
+// either: they sit in a StaticAABBTree, built when the set of statics
+// changes, which the other bodies query.
 class SortAndSweep {
 public:
-    std::vector<std::pair<uint32_t, uint32_t>> Query(const std::vector<RigidBody*>& bodies) {
-        std::vector<std::pair<float, uint32_t>> ev; ev.reserve(bodies.size());
-        for (uint32_t i = 0; i < (uint32_t)bodies.size(); ++i)
-            ev.push_back({ bodies[i]->WorldAABB.Min.x, i });
+    std::vector<BodyPair> Query(const BodyStore& S, const CollisionFilter& filter, const StaticAABBTree& statics) {
+        std::vector<std::pair<float, uint32_t>> ev; ev.reserve(S.Size());
+        for (uint32_t i = 0; i < S.Size(); ++i)
+            if (!S.Info[i].IsStatic()) ev.push_back({ S.FatAABB[i].Min.x, i });
         std::sort(ev.begin(), ev.end());
 
         std::vector<std::pair<uint32_t, uint32_t>> pairs;
@@ -448,305 +1408,1012 @@ public:
 
         for (const auto& [minX, i] : ev) {
             active.erase(std::remove_if(active.begin(), active.end(),
-                [&](uint32_t k) { return bodies[k]->WorldAABB.Max.x < minX; }), active.end());
+                [&](uint32_t k) { return S.FatAABB[k].Max.x < minX; }), active.end());
             for (uint32_t j : active) {
-                if (bodies[i]->IsStatic() && bodies[j]->IsStatic()) continue;
-                if (!bodies[i]->IsAwake && !bodies[j]->IsAwake) continue;
-                if (bodies[i]->WorldAABB.Overlaps(bodies[j]->WorldAABB))
+                if (S.FatAABB[i].Overlaps(S.FatAABB[j]) && filter.ShouldCollide(S.Info[i], S.Info[j]))
                     pairs.emplace_back(std::min(i, j), std::max(i, j));
             }
             active.push_back(i);
+            statics.Query(S.FatAABB[i], [&](uint32_t slot) {
+                uint32_t j = S.IndexOfSlot(slot);
+                if (filter.ShouldCollide(S.Info[i], S.Info[j])) pairs.emplace_back(std::min(i, j), std::max(i, j));
+                return true;
+                });
         }
         std::sort(pairs.begin(), pairs.end());
         pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
-        return pairs;
+
+        std::vector<BodyPair> out; out.reserve(pairs.size());
+        for (const auto& [i, j] : pairs) out.push_back({ S.HandleOf(i), S.HandleOf(j) });
+        return out;
     }
 };
 
-struct Constraint {
-    RigidBody* BodyA = nullptr;
-    RigidBody* BodyB = nullptr;
-    virtual void BeginSubStep() {}
-    virtual void SolveVelocity(float dt, float invDt) = 0;
-    virtual ~Constraint() = default;
-};
+// Broadphase backed by a persistent DynamicAABBTree of the non-static
+// bodies. Proxies are only reinserted when a body's fat AABB changes, and
+// pairs are only re-queried for those bodies; every other cached pair is
+// left untouched. Tree leaves carry the body's slot index, which never
+// changes.
+class DynamicTreeBroadphase {
+public:
+    DynamicAABBTree Tree;
+
+    void Add(BodyStore& S, uint32_t i) {
+        S.Info[i].ProxyID = Tree.CreateProxy(S.FatAABB[i], S.HandleOf(i).Index);
+    }
+    void Remove(BodyStore& S, uint32_t i) {
+        int32_t& proxy = S.Info[i].ProxyID;
+        if (proxy == DynamicAABBTree::Null) return;
+        Tree.DestroyProxy(proxy); proxy = DynamicAABBTree::Null;
+    }
+    void Update(BodyStore& S, uint32_t i) {
+        if (S.Info[i].IsStatic()) return;
+        if (S.Info[i].ProxyID == DynamicAABBTree::Null) Add(S, i);
+        else Tree.MoveProxy(S.Info[i].ProxyID, S.FatAABB[i]);
+    }
 
-struct DistanceJoint : public Constraint {
-    glm::vec3 LocalAnchorA{ 0.0f };
-    glm::vec3 LocalAnchorB{ 0.0f };
-    float TargetLength = 1.0f;
-    float ERP = 0.2f;
-    float MaxImpulse = 1e6f;
-    float AccumLambda = 0.0f;
-
-    void BeginSubStep() override { AccumLambda = 0.0f; }
-
-    void SolveVelocity(float dt, float invDt) override {
-        if (!BodyA || !BodyB) return;
-        glm::vec3 wA = BodyA->LocalToWorld(LocalAnchorA);
-        glm::vec3 wB = BodyB->LocalToWorld(LocalAnchorB);
-        glm::vec3 rA = wA - BodyA->Position, rB = wB - BodyB->Position;
-        glm::vec3 df = wB - wA;
-        float dist = glm::length(df);
-        if (dist < 1e-8f) return;
-        glm::vec3 n = df / dist;
-        float C = dist - TargetLength;
-        float em = EffectiveMass(BodyA, BodyB, rA, rB, n);
-        if (em < 1e-10f) return;
-        float Jv = glm::dot(BodyB->VelocityAt(wB) - BodyA->VelocityAt(wA), n);
-        float bias = ERP * invDt * C;
-        float lam = -(Jv + bias) / em;
-        lam = std::clamp(lam, -MaxImpulse * dt, MaxImpulse * dt);
-        AccumLambda += lam;
-        glm::vec3 J = n * lam;
-        if (BodyA->CanMove()) BodyA->ApplyImpulse(-J, rA);
-        if (BodyB->CanMove()) BodyB->ApplyImpulse(J, rB);
+    // Drops the cached pairs of every moved (or removed) body and re-queries them.
+    void UpdatePairs(const BodyStore& S, const CollisionFilter& filter, const StaticAABBTree& statics,
+        const std::vector<uint32_t>& moved, std::vector<BodyPair>& pairs)
+    {
+        pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [&](const BodyPair& p) {
+            return !S.IsValid(p.A) || !S.IsValid(p.B)
+                || S.Info[S.IndexOf(p.A)].FatAABBMoved || S.Info[S.IndexOf(p.B)].FatAABBMoved;
+            }), pairs.end());
+
+        for (uint32_t a : moved) {
+            const BodyInfo& A = S.Info[a];
+            auto report = [&](uint32_t slot) {
+                uint32_t b = S.IndexOfSlot(slot);
+                const BodyInfo& B = S.Info[b];
+                if (b == a || !filter.ShouldCollide(A, B)) return true;
+                // Both moved: emitted once, from the lower ID.
+                if (B.FatAABBMoved && B.ID < A.ID) return true;
+                if (A.ID < B.ID) pairs.push_back({ S.HandleOf(a), S.HandleOf(b) });
+                else pairs.push_back({ S.HandleOf(b), S.HandleOf(a) });
+                return true;
+            };
+            Tree.Query(S.FatAABB[a], [&](int32_t id) { return report(Tree.GetUserData(id)); });
+            if (!A.IsStatic()) statics.Query(S.FatAABB[a], report);
+        }
     }
 };
 
 struct BodyState { glm::vec3 Position; glm::quat Orientation; glm::vec3 LinearVelocity; glm::vec3 AngularVelocity; };
 using PhysicsSnapshot = std::map<uint32_t, BodyState>;
 
+// Work done by the last Step, for seeing what AdaptiveSubSteps and
+// SolverTolerance save.
+struct StepStats {
+    int SubSteps = 0;
+    // Velocity passes (position passes with XPBD) summed over the substeps.
+    // Solvers that stop each island on its own count the slowest island.
+    int SolverIterations = 0;
+};
+
 class PhysicsWorld {
 public:
     glm::vec3 Gravity{ 0, -9.81f, 0 };
     int   SolverIterations = 25;
     int   SubSteps = 16;
     int   PositionIterations = 1;
+    // With AdaptiveSubSteps, SubSteps is the most a step runs: each step runs
+    // the fewest, down to MinSubSteps, that keep every awake dynamic body
+    // moving less than SubStepTravel times its own size per substep.
+    // Bullets are left out; their sweeps handle their speed. Resting stacks
+    // settle quickly with SoftStep at 4, but the Iterative solver needs about
+    // 8 before they come to rest and fall asleep.
+    bool  AdaptiveSubSteps = false;
+    int   MinSubSteps = 4;
+    float SubStepTravel = 0.25f;
+    // Velocity iterations stop early once a pass changes no contact or joint
+    // velocity by more than this (m/s); 0 always runs SolverIterations.
+    float SolverTolerance = 0.0f;
+    // XPBD runs PositionIterations position passes and ignores
+    // SolverIterations, ContactSolverMode and JointSolverMode; one pass per
+    // substep is its usual setting. SolverTolerance stops its passes once
+    // none moves a body faster than the tolerance.
+    // SoftStep ignores SolverIterations and PositionIterations; it is meant
+    // to run with far fewer substeps (4 keeps box stacks at rest).
+    SolverType SolverMode = SolverType::Iterative;
+    // Rigid velocity passes solve the normal impulses of each manifold's
+    // points together (an exact LCP over up to four points) before its
+    // friction, instead of point by point. Box stacks then come to rest with
+    // a fraction of the SolverIterations. SoftStep's soft pass and XPBD keep
+    // their own normal solve.
+    bool  BlockContactSolver = false;
+    float ContactHertz = 30.0f;            // capped at a quarter of the substep rate
+    float ContactDampingRatio = 10.0f;
+    float ContactPushMaxVelocity = 3.0f;   // fastest speed overlapping bodies are pushed apart at
     bool  EnableSleeping = true;
     float SleepTimeThreshold = 0.5f;
     float SleepLinVelThreshold = 0.04f;
     float SleepAngVelThreshold = 0.04f;
     float DefaultLinearDamping = 0.02f;
     float DefaultAngularDamping = 0.05f;
-
-    std::vector<RigidBody*>  Bodies;
+    float AABBMargin = 0.05f;
+    // Bodies closing in fast get contacts while still up to this far apart,
+    // so they stop at the surface instead of crossing it within a substep;
+    // 0 turns speculative contacts off. Faster bodies need IsBullet.
+    float MaxSpeculativeDistance = 1.0f;
+    uint32_t WorkerThreads = 0;   // threads added to the island solve; 0 solves on the calling thread
+
+    BodyStore                Bodies;
+    std::vector<BodyPair>    Pairs;     // broadphase result, reused until a body leaves its FatAABB
     std::vector<Manifold>    Contacts;
     std::vector<Constraint*> Constraints;
     ManifoldCache Cache;
-    SortAndSweep  Broadphase;
+    SimplexCache  Simplices;
+    BroadphaseType        BroadphaseMode = BroadphaseType::DynamicTree;
+    ContactSolverType     ContactSolverMode = ContactSolverType::GraphColored;
+    JointSolverType       JointSolverMode = JointSolverType::Iterative;
+    SortAndSweep          SweepBroadphase;
+    DynamicTreeBroadphase TreeBroadphase;
     uint32_t      NextID = 1;
 
-    ~PhysicsWorld() { for (auto* b : Bodies) delete b; for (auto* c : Constraints) delete c; }
+    ~PhysicsWorld() { for (auto* c : Constraints) delete c; }
+
+    BodyHandle CreateBody(const BodyDesc& desc) {
+        BodyHandle h = Bodies.Add();
+        uint32_t i = Bodies.IndexOf(h);
+        BodyInfo& info = Bodies.Info[i];
+        info.ID = (desc.ID == BodyDesc::AutoID) ? NextID++ : desc.ID;
+        info.Type = desc.Type; info.Mass = desc.Mass;
+        info.CollisionShape = desc.CollisionShape;
+        // Triangle meshes and heightfields have no volume to integrate; they are level geometry.
+        if (desc.CollisionShape && IsMeshShape(desc.CollisionShape)) info.Type = BodyType::Static;
+        info.Material = desc.Material; info.UserData = desc.UserData;
+        info.IsBullet = desc.IsBullet && info.IsDynamic();
+        info.CollisionCategory = desc.CollisionCategory; info.CollisionMask = desc.CollisionMask;
+        if (info.IsBullet) m_Bullets.push_back(h);
+
+        Bodies.Position[i] = desc.Position; Bodies.Orientation[i] = desc.Orientation;
+        Bodies.LinearVelocity[i] = desc.LinearVelocity; Bodies.AngularVelocity[i] = desc.AngularVelocity;
+        Bodies.LinearDamping[i] = DefaultLinearDamping;
+        Bodies.AngularDamping[i] = DefaultAngularDamping;
+        Bodies.GravityScale[i] = desc.GravityScale;
+        if (desc.CollisionShape) Bodies.LocalAABB[i] = desc.CollisionShape->ComputeLocalAABB();
+
+        Bodies.RecalculateMassProperties(i); Bodies.UpdateAABB(i); Bodies.UpdateWorldInertia(i);
+        if (!info.IsStatic()) Bodies.MoveToAwake(i);
+        m_DirtyBodies.push_back(h);
+        return h;
+    }
 
-    RigidBody* CreateBody(const glm::vec3& pos, Shape* shape,
+    BodyHandle CreateBody(const glm::vec3& pos, Shape* shape,
         BodyType type = BodyType::Dynamic, float mass = 1.0f)
     {
-        RigidBody* b = new RigidBody();
-        b->ID = NextID++; b->Position = pos; b->CollisionShape = shape;
-        b->Type = type;   b->Mass = mass;
-        b->LinearDamping = DefaultLinearDamping;
-        b->AngularDamping = DefaultAngularDamping;
-        b->RecalculateMassProperties(); b->UpdateWorldInertia(); b->UpdateAABB();
-        Bodies.push_back(b); return b;
+        BodyDesc d;
+        d.Position = pos; d.CollisionShape = shape; d.Type = type; d.Mass = mass;
+        return CreateBody(d);
+    }
+
+    // O(1): the last body is swapped into the removed slot. Cached pairs and
+    // joints referencing the body are invalidated through the handle. Removing
+    // a sleeping body wakes its island so whatever rested on it can react.
+    void RemoveBody(BodyHandle body) {
+        if (!Bodies.IsValid(body)) return;
+        WakeIsland(Bodies.IndexOf(body));
+        TreeBroadphase.Remove(Bodies, Bodies.IndexOf(body));
+        if (Bodies.Info[Bodies.IndexOf(body)].IsStatic()) m_StaticsChanged = true;
+        m_Filter.Forget(Bodies.Info[Bodies.IndexOf(body)].ID);
+        Bodies.Remove(body);
     }
 
-    void RemoveBody(RigidBody* body) {
-        auto it = std::find(Bodies.begin(), Bodies.end(), body);
-        if (it != Bodies.end()) { Bodies.erase(it); delete body; }
+    // Filter changes take effect at the next step: the bodies are woken and
+    // their broadphase pairs queried again.
+    void SetCollisionFilter(BodyHandle body, uint32_t category, uint32_t mask) {
+        if (!Bodies.IsValid(body)) return;
+        BodyInfo& info = Bodies.Info[Bodies.IndexOf(body)];
+        info.CollisionCategory = category; info.CollisionMask = mask;
+        WakeUp(body); m_DirtyBodies.push_back(body);
+    }
+    // Stops (or with `ignore` false, restores) collisions between a and b
+    // whatever their categories.
+    void IgnoreCollision(BodyHandle a, BodyHandle b, bool ignore = true) {
+        if (!Bodies.IsValid(a) || !Bodies.IsValid(b)) return;
+        m_Filter.Ignore(Bodies.Info[Bodies.IndexOf(a)].ID, Bodies.Info[Bodies.IndexOf(b)].ID, ignore);
+        WakeUp(a); WakeUp(b);
+        m_DirtyBodies.push_back(a); m_DirtyBodies.push_back(b);
     }
 
-    DistanceJoint* AddDistanceJoint(RigidBody* a, RigidBody* b,
-        const glm::vec3& anA, const glm::vec3& anB, float length = -1.0f)
+    bool IsValid(BodyHandle body) const { return Bodies.IsValid(body); }
+
+    void WakeUp(BodyHandle body) { if (Bodies.IsValid(body)) WakeIsland(Bodies.IndexOf(body)); }
+    uint32_t GetAwakeBodyCount() const { return Bodies.AwakeCount(); }
+    uint32_t GetSleepingIslandCount() const { return (uint32_t)(m_SleepingIslands.size() - m_FreeIslands.size()); }
+    // Heap allocations made by the last Step, on any thread; always 0 unless
+    // built with PHYSIM_COUNT_ALLOCATIONS (see AllocationCounter).
+    uint64_t GetStepAllocationCount() const { return m_StepAllocations; }
+    const StepStats& GetStepStats() const { return m_StepStats; }
+
+    void ApplyForce(BodyHandle h, const glm::vec3& f) {
+        if (!Bodies.IsValid(h)) return;
+        uint32_t i = Bodies.IndexOf(h);
+        if (!Bodies.Info[i].IsDynamic()) return;
+        Bodies.Force[i] += f; WakeIsland(i);
+    }
+    void ApplyTorque(BodyHandle h, const glm::vec3& t) {
+        if (!Bodies.IsValid(h)) return;
+        uint32_t i = Bodies.IndexOf(h);
+        if (!Bodies.Info[i].IsDynamic()) return;
+        Bodies.Torque[i] += t; WakeIsland(i);
+    }
+    void ApplyForceAtPoint(BodyHandle h, const glm::vec3& f, const glm::vec3& wp) {
+        if (!Bodies.IsValid(h)) return;
+        uint32_t i = Bodies.IndexOf(h);
+        if (!Bodies.Info[i].IsDynamic()) return;
+        Bodies.Force[i] += f; Bodies.Torque[i] += glm::cross(wp - Bodies.Position[i], f); WakeIsland(i);
+    }
+    void ApplyImpulse(BodyHandle h, const glm::vec3& j, const glm::vec3& wp) {
+        if (!Bodies.IsValid(h)) return;
+        uint32_t i = Bodies.IndexOf(h);
+        if (!Bodies.Info[i].IsDynamic()) return;
+        Bodies.LinearVelocity[i] += j * Bodies.InverseMass[i];
+        Bodies.AngularVelocity[i] += Bodies.InverseInertiaWorld[i] * glm::cross(wp - Bodies.Position[i], j);
+        WakeIsland(i);
+    }
+
+    // With `collideConnected` false the two bodies stop colliding with each
+    // other (see IgnoreCollision).
+    DistanceJoint* AddDistanceJoint(BodyHandle a, BodyHandle b,
+        const glm::vec3& anA, const glm::vec3& anB, float length = -1.0f, bool collideConnected = true)
     {
+        if (!collideConnected) IgnoreCollision(a, b);
         auto* j = new DistanceJoint();
         j->BodyA = a; j->BodyB = b; j->LocalAnchorA = anA; j->LocalAnchorB = anB;
         j->TargetLength = (length < 0.0f)
-            ? glm::length(a->LocalToWorld(anA) - b->LocalToWorld(anB)) : length;
+            ? glm::length(Bodies.LocalToWorld(Bodies.IndexOf(a), anA) - Bodies.LocalToWorld(Bodies.IndexOf(b), anB)) : length;
+        WakeUp(a); WakeUp(b);
         Constraints.push_back(j); return j;
     }
 
+    // Restored bodies are woken (snapshots do not record sleep state); static
+    // ones are queued so their broadphase bounds follow the new pose.
     void SetState(const PhysicsSnapshot& snap) {
-        for (auto* b : Bodies) {
-            auto it = snap.find(b->ID); if (it == snap.end()) continue;
+        WakeAllIslands();
+        for (uint32_t i = 0; i < Bodies.Size(); ++i) {
+            auto it = snap.find(Bodies.Info[i].ID); if (it == snap.end()) continue;
             const auto& s = it->second;
-            b->Position = s.Position; b->Orientation = s.Orientation;
-            b->LinearVelocity = s.LinearVelocity; b->AngularVelocity = s.AngularVelocity;
-            b->UpdateWorldInertia(); b->UpdateAABB();
+            Bodies.Position[i] = s.Position; Bodies.Orientation[i] = s.Orientation;
+            Bodies.LinearVelocity[i] = s.LinearVelocity; Bodies.AngularVelocity[i] = s.AngularVelocity;
+            Bodies.UpdateAABB(i); Bodies.UpdateWorldInertia(i);
+            if (!Bodies.InAwakeRange(i)) m_DirtyBodies.push_back(Bodies.HandleOf(i));
         }
     }
     PhysicsSnapshot GetState() const {
         PhysicsSnapshot snap;
-        for (const auto* b : Bodies)
-            snap[b->ID] = { b->Position, b->Orientation, b->LinearVelocity, b->AngularVelocity };
+        for (uint32_t i = 0; i < Bodies.Size(); ++i)
+            snap[Bodies.Info[i].ID] = { Bodies.Position[i], Bodies.Orientation[i], Bodies.LinearVelocity[i], Bodies.AngularVelocity[i] };
         return snap;
     }
 
     void Step(float dt) {
         if (dt <= 0.0f) return;
-        float subDt = dt / float(SubSteps);
-
-        for (int s = 0; s < SubSteps; ++s) {
-            SubStep(subDt, s == 0);
+        const int subSteps = ChooseSubSteps(dt);
+        float subDt = dt / float(subSteps);
+        m_StepStats = { subSteps, 0 };
+        const uint64_t allocations = AllocationCounter::Count.load(std::memory_order_relaxed);
+
+        if (!EnableSleeping) WakeAllIslands();
+        if (!m_Pool || m_Pool->WorkerCount() != WorkerThreads) m_Pool = std::make_unique<ThreadPool>(WorkerThreads);
+
+        // Kinematic bodies are moved by the user, so they are refitted once per
+        // step; IsAwake records whether their pose changed since the last step,
+        // which is what lets them wake sleeping islands. The pose is compared
+        // rather than the bounds, which a turn about a symmetry axis leaves
+        // unchanged. Static bodies are refitted when created or restored.
+        for (uint32_t i = 0; i < Bodies.AwakeCount(); ++i) {
+            BodyInfo& b = Bodies.Info[i];
+            if (!b.IsKinematic()) continue;
+            b.IsAwake = Bodies.Position[i] != b.StepPosition || Bodies.Orientation[i] != b.StepOrientation;
+            b.StepPosition = Bodies.Position[i];
+            b.StepOrientation = Bodies.Orientation[i];
+            Bodies.UpdateAABB(i);
         }
+        UpdatePairs(dt, subDt);
 
-        for (const auto& man : Contacts) Cache.Store(man);
+        for (int s = 0; s < subSteps; ++s) SubStep(subDt, dt);
+        Cache.EvictStale();
+        Simplices.EvictStale();
+
+        if (EnableSleeping && subSteps > 0) UpdateIslands(dt);
+        m_StepAllocations = AllocationCounter::Count.load(std::memory_order_relaxed) - allocations;
     }
 
 private:
-    void SubStep(float dt, bool doWarmStart) {
-        const float invDt = 1.0f / dt;
+    std::vector<uint32_t>   m_MovedBodies;
+    std::vector<BodyHandle> m_DirtyBodies;   // bodies to query again: new, moved while not awake, or refiltered
+    BroadphaseType          m_PairsBuiltWith = BroadphaseType::SortAndSweep;
+    CollisionFilter         m_Filter;
+    StaticAABBTree          m_StaticTree;
+    bool                    m_StaticsChanged = false;   // a static body was added, moved or removed
+    std::vector<AABB>       m_StaticBoxes;              // BuildStaticTree scratch
+    std::vector<uint32_t>   m_StaticSlots;
+    uint64_t                m_StepAllocations = 0;
+    StepStats               m_StepStats;
+    float                   m_CachedSubDt = 0.0f;   // substep length the cached impulses were solved at
+    float                   m_WarmStartScale = 1.0f;
+
+    // Where this substep's awake bullets started, and how far along their
+    // path they got before touching something.
+    struct BulletSweep { uint32_t Body; glm::vec3 Start; glm::quat StartOrientation; float T; };
+    std::vector<BodyHandle>  m_Bullets;   // bodies created with IsBullet; removed ones are dropped lazily
+    std::vector<BulletSweep> m_BulletSweeps;
+
+    // Narrowphase output: chunk c of PairsPerTask pairs wrote manifolds
+    // [Begin, End) and simplices [SimplexBegin, SimplexEnd) of
+    // m_NarrowBuffers[Participant].
+    struct NarrowChunk { uint32_t Participant = 0, Begin = 0, End = 0, SimplexBegin = 0, SimplexEnd = 0; };
+    static constexpr uint32_t PairsPerTask = 64;
+    // Chunk of the awake range handed to the pool by the per-body stages.
+    static constexpr uint32_t BodiesPerTask = 256;
+    std::vector<NarrowphaseBuffer> m_NarrowBuffers;   // one per pool participant
+    std::vector<NarrowChunk>       m_NarrowChunks;
+
+    // Solver islands of the current substep, cut into batches of at least
+    // MinBatchRows rows; a batch is the unit of work handed to the pool.
+    static constexpr uint32_t MinBatchRows = 32;
+    std::unique_ptr<ThreadPool>  m_Pool;
+    IslandBuilder                m_Islands;
+    IslandBuckets<uint32_t>      m_IslandContacts;   // indices into Contacts
+    IslandBuckets<Constraint*>   m_IslandJoints;     // joints the iterative solver handles
+    JointTreeSolver              m_JointTrees;       // with JointSolverType::Direct, the rest
+    std::vector<uint32_t>        m_IslandBatches;    // batch b covers islands [m_IslandBatches[b], m_IslandBatches[b + 1])
+    std::vector<ContactRow>      m_ContactRows;      // this substep's prepared contact points, island by island
+    std::vector<uint32_t>        m_FirstRow;         // first row of each manifold
+    std::vector<uint32_t>        m_IslandRows;       // island k owns rows [m_IslandRows[k], m_IslandRows[k + 1])
+    std::vector<int>             m_IslandPasses;     // velocity passes the sequential solver ran on each island
+    std::vector<PositionContact> m_PositionContacts; // XPBD counterpart of m_ContactRows
+    std::vector<BodyPose>        m_PrevPoses;        // XPBD: awake body poses at the start of the substep
+    GraphColorContactSolver      m_ColorSolver;
+    Softness                     m_ContactSoftness;   // SoftStep coefficients for this substep
+
+    std::vector<SleepingIsland> m_SleepingIslands;
+    std::vector<uint32_t>       m_FreeIslands;
+    std::vector<BodyHandle>     m_SleepyBodies;
+
+    // Refreshes the pair cache. Bodies whose tight AABB, swept over the coming
+    // substep, is still inside their FatAABB keep their pairs; only escaped
+    // bodies get new fat bounds (predicting motion over a whole step) and
+    // trigger a broadphase update. Checking the sweep rather than the current
+    // bounds keeps the pairs that speculative contacts and bullet sweeps need
+    // for the motion still ahead. Sleeping and static bodies do not move, so
+    // only the awake range and explicitly dirtied bodies are checked.
+    void UpdatePairs(float stepDt, float subDt) {
+        bool rebuild = BroadphaseMode != m_PairsBuiltWith;
+        m_MovedBodies.clear();
+
+        auto markMoved = [&](uint32_t i, bool refit) {
+            if (Bodies.Info[i].FatAABBMoved) return;
+            Bodies.Info[i].FatAABBMoved = true;
+            if (refit) Bodies.UpdateFatAABB(i, AABBMargin, stepDt);
+            m_MovedBodies.push_back(i);
+            if (Bodies.Info[i].IsStatic()) m_StaticsChanged = true;
+            if (BroadphaseMode == BroadphaseType::DynamicTree) TreeBroadphase.Update(Bodies, i);
+        };
 
-        for (auto* b : Bodies) {
-            if (!b->IsDynamic() || !b->IsAwake) continue;
-            b->LinearVelocity += (b->ForceAccumulator * b->InverseMass + Gravity * b->GravityScale) * dt;
-            b->AngularVelocity += (b->InverseInertiaWorld * b->TorqueAccumulator) * dt;
-            b->ForceAccumulator = glm::vec3(0.0f);
-            b->TorqueAccumulator = glm::vec3(0.0f);
-            b->LinearVelocity *= std::exp(-b->LinearDamping * dt);
-            b->AngularVelocity *= std::exp(-b->AngularDamping * dt);
+        const uint32_t end = rebuild ? Bodies.Size() : Bodies.AwakeCount();
+        for (uint32_t i = 0; i < end; ++i) {
+            bool escaped = !Bodies.FatAABB[i].Contains(Bodies.SweptAABB(i, subDt));
+            if (rebuild || escaped) markMoved(i, escaped);
         }
+        for (BodyHandle h : m_DirtyBodies)
+            if (Bodies.IsValid(h)) markMoved(Bodies.IndexOf(h), true);
+        m_DirtyBodies.clear();
+        if (m_MovedBodies.empty()) return;
 
-        Contacts.clear();
-        for (auto* b : Bodies) b->UpdateAABB();
-        for (const auto& [i, j] : Broadphase.Query(Bodies))
-            DispatchCollision(Bodies[i], Bodies[j], Contacts);
-        for (auto& man : Contacts) { man.BodyA->WakeUp(); man.BodyB->WakeUp(); }
+        // A full query also returns the pairs parked in sleeping islands.
+        bool full = rebuild || BroadphaseMode == BroadphaseType::SortAndSweep;
+        if (full) for (auto& island : m_SleepingIslands) island.Pairs.clear();
 
-        for (auto& man : Contacts) {
-            for (auto& c : man.Contacts) BuildTangentBasis(man.Normal, c.Tangent0, c.Tangent1);
-            if (doWarmStart) {
-                Cache.WarmStart(man);
-                WarmStartManifold(man);
+        if (m_StaticsChanged) BuildStaticTree();
+        if (BroadphaseMode == BroadphaseType::SortAndSweep) Pairs = SweepBroadphase.Query(Bodies, m_Filter, m_StaticTree);
+        else TreeBroadphase.UpdatePairs(Bodies, m_Filter, m_StaticTree, m_MovedBodies, Pairs);
+        m_PairsBuiltWith = BroadphaseMode;
+
+        for (uint32_t i : m_MovedBodies) Bodies.Info[i].FatAABBMoved = false;
+    }
+
+    // Statics are never in the awake range. A level's statics are usually
+    // all created before the first step, so this runs once.
+    void BuildStaticTree() {
+        m_StaticBoxes.clear(); m_StaticSlots.clear();
+        for (uint32_t i = Bodies.AwakeCount(); i < Bodies.Size(); ++i) {
+            if (!Bodies.Info[i].IsStatic()) continue;
+            m_StaticBoxes.push_back(Bodies.FatAABB[i]);
+            m_StaticSlots.push_back(Bodies.HandleOf(i).Index);
+        }
+        m_StaticTree.Build(m_StaticBoxes, m_StaticSlots);
+        m_StaticsChanged = false;
+    }
+
+    // Wakes the island of body i. Bodies move into the awake range, so dense
+    // indices held by the caller (other than through handles) are invalidated.
+    void WakeIsland(uint32_t i) {
+        BodyInfo& info = Bodies.Info[i];
+        if (!info.IsDynamic() || info.IsAwake) return;
+        if (info.IslandID == BodyInfo::NoIsland) {
+            info.IsAwake = true; info.SleepTimer = 0.0f;
+            Bodies.MoveToAwake(i);
+            return;
+        }
+        uint32_t id = info.IslandID;
+        SleepingIsland& island = m_SleepingIslands[id];
+        for (BodyHandle h : island.Bodies) {
+            if (!Bodies.IsValid(h)) continue;
+            uint32_t k = Bodies.IndexOf(h);
+            BodyInfo& b = Bodies.Info[k];
+            b.IsAwake = true; b.SleepTimer = 0.0f; b.IslandID = BodyInfo::NoIsland;
+            Bodies.MoveToAwake(k);
+        }
+        Pairs.insert(Pairs.end(), island.Pairs.begin(), island.Pairs.end());
+        island.Bodies.clear(); island.Pairs.clear();
+        m_FreeIslands.push_back(id);
+    }
+
+    void WakeAllIslands() {
+        for (uint32_t id = 0; id < m_SleepingIslands.size(); ++id) {
+            if (m_SleepingIslands[id].Bodies.empty()) continue;
+            for (BodyHandle h : m_SleepingIslands[id].Bodies)
+                if (Bodies.IsValid(h)) { WakeIsland(Bodies.IndexOf(h)); break; }
+            if (!m_SleepingIslands[id].Bodies.empty()) {   // every body was removed
+                m_SleepingIslands[id].Bodies.clear(); m_SleepingIslands[id].Pairs.clear();
+                m_FreeIslands.push_back(id);
             }
         }
+    }
 
-        for (auto* con : Constraints) con->BeginSubStep();
+    // Wakes sleeping islands whose bodies are overlapped by an awake body (or a
+    // kinematic body that moved this step), out to the same speculative
+    // distance Collide uses, so no contact reaches a sleeping body. Runs
+    // before the narrowphase because waking reorders dense indices; pairs
+    // restored from a woken island are appended and visited by the same
+    // loop, so contact chains wake through.
+    void WakeTouchedIslands(float dt) {
+        BodyStore& S = Bodies;
+        for (size_t k = 0; k < Pairs.size(); ++k) {
+            BodyPair p = Pairs[k];
+            if (!S.IsValid(p.A) || !S.IsValid(p.B)) continue;
+            uint32_t a = S.IndexOf(p.A), b = S.IndexOf(p.B);
+            if (S.Info[a].IsAwake == S.Info[b].IsAwake) continue;
+            uint32_t sleeper = S.Info[a].IsAwake ? b : a;
+            if (!S.Info[sleeper].IsDynamic()) continue;
+            if (!S.WorldAABB[a].Expanded(SpeculativeDistance(a, b, dt)).Overlaps(S.WorldAABB[b])) continue;
+            WakeIsland(sleeper);
+        }
+    }
+
+    // Puts every island of the last substep whose bodies have all been resting
+    // long enough to sleep. Contact and pair data are consumed before any body
+    // is moved out of the awake range.
+    void UpdateIslands(float dt) {
+        BodyStore& S = Bodies;
+        const float ls = SleepLinVelThreshold * SleepLinVelThreshold;
+        const float as_ = SleepAngVelThreshold * SleepAngVelThreshold;
+
+        ForEachAwakeChunk([&](uint32_t begin, uint32_t count) {
+            TickSleepTimers(S, count, [begin](uint32_t k) { return begin + k; }, ls, as_, dt);
+            });
 
-        for (int iter = 0; iter < SolverIterations; ++iter) {
-            SolveContactVelocities();
-            for (auto* con : Constraints) con->SolveVelocity(dt, invDt);
+        // A kinematic body that is moving keeps whatever it touches awake.
+        for (const auto& man : Contacts) {
+            uint32_t a = man.BodyA, b = man.BodyB;
+            if (S.Info[a].IsKinematic() && S.Info[a].IsAwake) S.Info[b].SleepTimer = 0.0f;
+            if (S.Info[b].IsKinematic() && S.Info[b].IsAwake) S.Info[a].SleepTimer = 0.0f;
         }
 
-        for (auto* b : Bodies) {
-            if (!b->IsDynamic() || !b->IsAwake) continue;
-            b->Position += b->LinearVelocity * dt;
-            float wLen = glm::length(b->AngularVelocity);
-            if (wLen > 1e-8f)
-                b->Orientation = glm::normalize(glm::angleAxis(wLen * dt, b->AngularVelocity / wLen) * b->Orientation);
+        m_SleepyBodies.clear();
+        for (uint32_t k = 0; k < m_Islands.IslandCount(); ++k) {
+            bool canSleep = true;
+            for (uint32_t o = m_Islands.Offsets[k]; o < m_Islands.Offsets[k + 1] && canSleep; ++o) {
+                const BodyInfo& b = S.Info[m_Islands.Bodies[o]];
+                canSleep = b.IsDynamic() && b.SleepTimer >= SleepTimeThreshold;
+            }
+            if (!canSleep) continue;
+
+            uint32_t id;
+            if (!m_FreeIslands.empty()) { id = m_FreeIslands.back(); m_FreeIslands.pop_back(); }
+            else { id = (uint32_t)m_SleepingIslands.size(); m_SleepingIslands.emplace_back(); }
+            for (uint32_t o = m_Islands.Offsets[k]; o < m_Islands.Offsets[k + 1]; ++o) {
+                uint32_t i = m_Islands.Bodies[o];
+                BodyInfo& b = S.Info[i];
+                b.IsAwake = false; b.IslandID = id;
+                S.LinearVelocity[i] = {}; S.AngularVelocity[i] = {};
+                m_SleepingIslands[id].Bodies.push_back(S.HandleOf(i));
+                m_SleepyBodies.push_back(S.HandleOf(i));
+            }
+        }
+        if (m_SleepyBodies.empty()) return;
+
+        // Only now reorder: moving bodies out of the awake range invalidates
+        // the dense indices the island lists were built from.
+        for (BodyHandle h : m_SleepyBodies) S.MoveToAsleep(S.IndexOf(h));
+
+        // Park pairs that no longer involve an awake body with the island of
+        // their sleeping side, so the substeps stop visiting them. A pair
+        // spanning two sleeping islands stays live: parking it with one island
+        // would let the broadphase re-add it after the other one wakes.
+        size_t kept = 0;
+        for (const BodyPair& p : Pairs) {
+            if (!S.IsValid(p.A) || !S.IsValid(p.B)) continue;
+            uint32_t a = S.IndexOf(p.A), b = S.IndexOf(p.B);
+            if (S.InAwakeRange(a) || S.InAwakeRange(b)) { Pairs[kept++] = p; continue; }
+            uint32_t idA = S.Info[a].IsDynamic() ? S.Info[a].IslandID : BodyInfo::NoIsland;
+            uint32_t idB = S.Info[b].IsDynamic() ? S.Info[b].IslandID : BodyInfo::NoIsland;
+            uint32_t id = (idA == BodyInfo::NoIsland) ? idB : idA;
+            if (id == BodyInfo::NoIsland || (idB != BodyInfo::NoIsland && idB != id)) { Pairs[kept++] = p; continue; }
+            m_SleepingIslands[id].Pairs.push_back(p);
         }
+        Pairs.resize(kept);
+    }
 
-        for (int pass = 0; pass < PositionIterations; ++pass)
-            SolveContactPositions();
+    // Every substep warm starts from the impulses the previous one stored.
+    void SubStep(float dt, float stepDt) {
+        const float invDt = 1.0f / dt;
+        BodyStore& S = Bodies;
+        m_WarmStartScale = m_CachedSubDt > 0.0f ? dt / m_CachedSubDt : 1.0f;
+
+        ForEachAwakeChunk([&](uint32_t begin, uint32_t count) {
+            IntegrateVelocities(S, count, [begin](uint32_t k) { return begin + k; }, Gravity, dt);
+            });
+
+        UpdatePairs(stepDt, dt);
+        if (EnableSleeping) WakeTouchedIslands(dt);
+        Collide(dt);
+        BeginBulletSweeps();
+
+        BuildSolverIslands();
+        if (SolverMode == SolverType::SoftStep)
+            m_ContactSoftness = Softness::Make(std::min(ContactHertz, 0.25f * invDt), ContactDampingRatio, dt);
+
+        if (SolverMode == SolverType::XPBD) {
+            m_PrevPoses.resize(S.AwakeCount());
+            ForEachIsland([&](uint32_t k) { SolveIslandPositions(k, dt); });
+            int passes = 0;
+            for (int p : m_IslandPasses) passes = std::max(passes, p);
+            m_StepStats.SolverIterations += passes;
+        } else if (ContactSolverMode == ContactSolverType::Sequential) {
+            ForEachIsland([&](uint32_t k) { SolveIsland(k, dt, invDt); });
+            int passes = 0;
+            for (int p : m_IslandPasses) passes = std::max(passes, p);
+            m_StepStats.SolverIterations += passes;
+        } else {
+            // The colored solver covers every island at once, so the island
+            // stages around it run as separate passes.
+            ForEachIsland([&](uint32_t k) { PrepareIsland(k, dt, invDt); });
+            m_ColorSolver.Prepare(S, Contacts, m_ContactRows, m_FirstRow);
+            m_StepStats.SolverIterations += SolveColoredVelocities(dt, invDt, false);
+            // The per-body stages run over the awake range rather than island
+            // by island, so their batches fill across small islands.
+            ForEachAwakeChunk([&](uint32_t begin, uint32_t count) {
+                IntegratePoses(S, count, [begin](uint32_t k) { return begin + k; }, dt);
+                });
+            if (SolverMode == SolverType::Iterative && PositionIterations > 0) ForEachIsland([&](uint32_t k) { ProjectIsland(k); });
+            ForEachAwakeChunk([&](uint32_t begin, uint32_t count) {
+                RefitBodies(S, count, [begin](uint32_t k) { return begin + k; });
+                });
+            if (SolverMode == SolverType::SoftStep) m_StepStats.SolverIterations += SolveColoredVelocities(dt, invDt, true);
+            m_ColorSolver.StoreImpulses(Contacts);
+        }
+        SweepBullets(dt);
+        for (const auto& man : Contacts) Cache.Store(man);
+        m_CachedSubDt = dt;
+    }
 
-        for (auto* b : Bodies) if (b->IsDynamic()) {
-            b->UpdateWorldInertia(); b->UpdateAABB();
+    // SubSteps, or with AdaptiveSubSteps the fewest substeps that keep the
+    // fastest awake body within SubStepTravel of its size per substep. A
+    // body's size is the smallest half extent of its bounds, and its travel
+    // adds the distance its rotation sweeps its farthest corner.
+    int ChooseSubSteps(float dt) const {
+        if (!AdaptiveSubSteps || SubSteps <= 0 || SubStepTravel <= 0.0f) return SubSteps;
+        const BodyStore& S = Bodies;
+        float ratio = 0.0f;
+        for (uint32_t i = 0; i < S.AwakeCount(); ++i) {
+            if (!S.Info[i].IsDynamic() || S.Info[i].IsBullet) continue;
+            const glm::vec3 half = 0.5f * (S.LocalAABB[i].Max - S.LocalAABB[i].Min);
+            const float size = std::max(std::min({ half.x, half.y, half.z }), 1e-3f);
+            const float speed = glm::length(S.LinearVelocity[i]) + glm::length(S.AngularVelocity[i]) * S.Reach(i);
+            ratio = std::max(ratio, speed * dt / size);
         }
+        const int n = (int)std::min(std::ceil(ratio / SubStepTravel), float(SubSteps));
+        return std::clamp(n, std::min(MinSubSteps, SubSteps), SubSteps);
+    }
 
-        if (EnableSleeping) TickSleep(dt);
+    // How far apart bodies a and b may be and still get a contact this
+    // substep: how much they can close in over it, from their relative
+    // velocity and how fast their rotation sweeps their bounds. 0 while that
+    // is within the narrowphase's own tolerance, so resting and slow bodies
+    // collide exactly as without it.
+    float SpeculativeDistance(uint32_t a, uint32_t b, float dt) const {
+        const BodyStore& S = Bodies;
+        if (MaxSpeculativeDistance <= 0.0f) return 0.0f;
+        auto spin = [&](uint32_t i) {
+            float w = glm::length(S.AngularVelocity[i]);
+            return w > 0.0f ? w * S.Reach(i) : 0.0f;
+        };
+        float d = (glm::length(S.LinearVelocity[b] - S.LinearVelocity[a]) + spin(a) + spin(b)) * dt;
+        return d > 0.01f ? std::min(d, MaxSpeculativeDistance) : 0.0f;
     }
 
-    void WarmStartManifold(Manifold& man) {
-        RigidBody* A = man.BodyA, * B = man.BodyB;
-        for (auto& c : man.Contacts) {
-            glm::vec3 rA = c.WorldPointA - A->Position, rB = c.WorldPointB - B->Position;
-            glm::vec3 P = man.Normal * c.NormalImpulse
-                + c.Tangent0 * c.TangentImpulse0
-                + c.Tangent1 * c.TangentImpulse1;
-            if (A->CanMove()) { A->LinearVelocity -= P * A->InverseMass; A->AngularVelocity -= A->InverseInertiaWorld * glm::cross(rA, P); }
-            if (B->CanMove()) { B->LinearVelocity += P * B->InverseMass; B->AngularVelocity += B->InverseInertiaWorld * glm::cross(rB, P); }
-        }
-    }
-
-    void SolveContactVelocities() {
-        const float REST_THRESH = 1.5f;
-
-        for (auto& man : Contacts) {
-            RigidBody* A = man.BodyA, * B = man.BodyB;
-            float e = CombineRestitution(A->Material, B->Material);
-            float mu = CombineFriction(A->Material, B->Material);
-
-            for (auto& c : man.Contacts) {
-                glm::vec3 rA = c.WorldPointA - A->Position, rB = c.WorldPointB - B->Position;
-
-                glm::vec3 vRel = B->VelocityAt(c.WorldPointB) - A->VelocityAt(c.WorldPointA);
-                float velN = glm::dot(vRel, man.Normal);
-                float em = EffectiveMass(A, B, rA, rB, man.Normal);
-                if (em < 1e-10f) continue;
-
-                float coefE = (velN < -REST_THRESH) ? e : 0.0f;
-                float jN = -(1.0f + coefE) * velN / em;
-                float prev = c.NormalImpulse;
-                c.NormalImpulse = std::max(0.0f, prev + jN);
-                float dN = c.NormalImpulse - prev;
-                glm::vec3 PN = man.Normal * dN;
-                if (A->CanMove()) { A->LinearVelocity -= PN * A->InverseMass; A->AngularVelocity -= A->InverseInertiaWorld * glm::cross(rA, PN); }
-                if (B->CanMove()) { B->LinearVelocity += PN * B->InverseMass; B->AngularVelocity += B->InverseInertiaWorld * glm::cross(rB, PN); }
-
-                float maxF = mu * c.NormalImpulse;
-
-                vRel = B->VelocityAt(c.WorldPointB) - A->VelocityAt(c.WorldPointA);
-                {
-                    float emT = EffectiveMass(A, B, rA, rB, c.Tangent0);
-                    if (emT > 1e-10f) {
-                        float jT = -glm::dot(vRel, c.Tangent0) / emT;
-                        float p0 = c.TangentImpulse0;
-                        c.TangentImpulse0 = std::clamp(p0 + jT, -maxF, maxF);
-                        glm::vec3 PT = c.Tangent0 * (c.TangentImpulse0 - p0);
-                        if (A->CanMove()) { A->LinearVelocity -= PT * A->InverseMass; A->AngularVelocity -= A->InverseInertiaWorld * glm::cross(rA, PT); }
-                        if (B->CanMove()) { B->LinearVelocity += PT * B->InverseMass; B->AngularVelocity += B->InverseInertiaWorld * glm::cross(rB, PT); }
-                    }
-                }
-
-                vRel = B->VelocityAt(c.WorldPointB) - A->VelocityAt(c.WorldPointA);
-                {
-                    float emT = EffectiveMass(A, B, rA, rB, c.Tangent1);
-                    if (emT > 1e-10f) {
-                        float jT = -glm::dot(vRel, c.Tangent1) / emT;
-                        float p1 = c.TangentImpulse1;
-                        c.TangentImpulse1 = std::clamp(p1 + jT, -maxF, maxF);
-                        glm::vec3 PT = c.Tangent1 * (c.TangentImpulse1 - p1);
-                        if (A->CanMove()) { A->LinearVelocity -= PT * A->InverseMass; A->AngularVelocity -= A->InverseInertiaWorld * glm::cross(rA, PT); }
-                        if (B->CanMove()) { B->LinearVelocity += PT * B->InverseMass; B->AngularVelocity += B->InverseInertiaWorld * glm::cross(rB, PT); }
-                    }
-                }
+    // Records where this substep's awake bullets start.
+    void BeginBulletSweeps() {
+        m_BulletSweeps.clear();
+        size_t kept = 0;
+        for (BodyHandle h : m_Bullets) {
+            if (!Bodies.IsValid(h)) continue;
+            m_Bullets[kept++] = h;
+            uint32_t i = Bodies.IndexOf(h);
+            if (Bodies.InAwakeRange(i)) m_BulletSweeps.push_back({ i, Bodies.Position[i], Bodies.Orientation[i], 1.0f });
+        }
+        m_Bullets.resize(kept);
+    }
+
+    // Pulls each bullet back to where its motion over the substep first
+    // came within contact distance of a body that is not a bullet, judged
+    // against the other bodies' final poses. The velocity is kept; the next
+    // substep's speculative contact stops the bullet at the surface.
+    void SweepBullets(float dt) {
+        if (m_BulletSweeps.empty()) return;
+        BodyStore& S = Bodies;
+        for (const BodyPair& p : Pairs) {
+            if (!S.IsValid(p.A) || !S.IsValid(p.B)) continue;
+            uint32_t a = S.IndexOf(p.A), b = S.IndexOf(p.B);
+            if (S.Info[a].IsBullet == S.Info[b].IsBullet) continue;
+            if (S.Info[b].IsBullet) std::swap(a, b);
+            if (!S.Info[a].CollisionShape || !S.Info[b].CollisionShape) continue;
+            for (BulletSweep& sweep : m_BulletSweeps) {
+                if (sweep.Body != a) continue;
+                const glm::vec3 d = S.Position[a] - sweep.Start;
+                const AABB path = AABB::Union(S.WorldAABB[a], { S.WorldAABB[a].Min - d, S.WorldAABB[a].Max - d });
+                if (!path.Overlaps(S.WorldAABB[b])) break;
+
+                SweepMotion motion;
+                motion.Start = ShapeTransform(sweep.Start, sweep.StartOrientation);
+                motion.Delta = d;
+                const float w = glm::length(S.AngularVelocity[a]);
+                if (w > 1e-8f) { motion.Axis = S.AngularVelocity[a] / w; motion.Angle = w * dt; }
+                motion.Reach = S.Reach(a);
+                ShapeTransform xB(S.Position[b], S.Orientation[b], S.Rotation[b]);
+                sweep.T = std::min(sweep.T, SweepShapes(S.Info[a].CollisionShape, motion, S.Info[b].CollisionShape, xB));
+                break;
             }
         }
+        for (const BulletSweep& sweep : m_BulletSweeps) {
+            if (sweep.T >= 1.0f) continue;
+            const uint32_t i = sweep.Body;
+            S.Position[i] = sweep.Start + (S.Position[i] - sweep.Start) * sweep.T;
+            const float w = glm::length(S.AngularVelocity[i]);
+            S.Orientation[i] = w > 1e-8f
+                ? glm::normalize(glm::angleAxis(w * dt * sweep.T, S.AngularVelocity[i] / w) * sweep.StartOrientation) : sweep.StartOrientation;
+            S.UpdateAABB(i); S.UpdateWorldInertia(i);
+        }
     }
 
-    void SolveContactPositions() {
-        const float ERP = 0.3f;
-        const float SLOP = 0.005f;
-        const float MAX_COR = 0.2f;
+    // Narrowphase over every pair with an awake dynamic body. Chunks of pairs
+    // run on the pool, each appending to its participant's buffer; the chunks
+    // are then copied into Contacts in pair order, so the result is the same
+    // for any number of threads. Pairs closing in fast are tested out to
+    // their speculative distance.
+    void Collide(float dt) {
+        const BodyStore& S = Bodies;
+        const uint32_t pairs = (uint32_t)Pairs.size();
+        const uint32_t chunks = (pairs + PairsPerTask - 1) / PairsPerTask;
+        m_NarrowBuffers.resize(m_Pool->ParticipantCount());
+        for (auto& buffer : m_NarrowBuffers) buffer.clear();
+        m_NarrowChunks.resize(chunks);
+
+        m_Pool->ParallelFor(chunks, [&](uint32_t c, uint32_t participant) {
+            NarrowphaseBuffer& out = m_NarrowBuffers[participant];
+            NarrowChunk& chunk = m_NarrowChunks[c];
+            chunk.Participant = participant;
+            chunk.Begin = (uint32_t)out.Manifolds.size(); chunk.SimplexBegin = (uint32_t)out.Simplices.size();
+            for (uint32_t k = c * PairsPerTask, end = std::min(pairs, k + PairsPerTask); k < end; ++k) {
+                const BodyPair& p = Pairs[k];
+                if (!S.IsValid(p.A) || !S.IsValid(p.B)) continue;
+                uint32_t a = S.IndexOf(p.A), b = S.IndexOf(p.B);
+                bool awakeA = S.Info[a].IsDynamic() && S.Info[a].IsAwake;
+                bool awakeB = S.Info[b].IsDynamic() && S.Info[b].IsAwake;
+                if (!awakeA && !awakeB) continue;
+                const float speculative = SpeculativeDistance(a, b, dt);
+                if (S.WorldAABB[a].Expanded(speculative).Overlaps(S.WorldAABB[b])) DispatchCollision(S, a, b, Simplices, out, speculative);
+            }
+            chunk.End = (uint32_t)out.Manifolds.size(); chunk.SimplexEnd = (uint32_t)out.Simplices.size();
+            });
+
+        Contacts.clear();
+        for (const NarrowChunk& chunk : m_NarrowChunks) {
+            const auto& buffer = m_NarrowBuffers[chunk.Participant];
+            Contacts.insert(Contacts.end(), buffer.Manifolds.begin() + chunk.Begin, buffer.Manifolds.begin() + chunk.End);
+            for (uint32_t k = chunk.SimplexBegin; k < chunk.SimplexEnd; ++k) Simplices.Store(buffer.Simplices[k]);
+        }
+    }
+
+    // Calls stage(begin, count) for chunks of BodiesPerTask bodies covering
+    // the awake range, spread across the pool.
+    template<typename F>
+    void ForEachAwakeChunk(F&& stage) {
+        const uint32_t n = Bodies.AwakeCount();
+        m_Pool->ParallelFor((n + BodiesPerTask - 1) / BodiesPerTask, [&](uint32_t c, uint32_t) {
+            const uint32_t begin = c * BodiesPerTask;
+            stage(begin, std::min(BodiesPerTask, n - begin));
+            });
+    }
+
+    template<typename F>
+    void ForEachIsland(F&& fn) {
+        m_Pool->ParallelFor((uint32_t)m_IslandBatches.size() - 1, [&](uint32_t batch, uint32_t) {
+            for (uint32_t k = m_IslandBatches[batch]; k < m_IslandBatches[batch + 1]; ++k) fn(k);
+            });
+    }
+
+    // Links the awake bodies through this substep's manifolds and joints, then
+    // buckets both by island. Joints that touch no awake dynamic body have
+    // nothing to solve and are left out. Contact rows are laid out island by
+    // island, so each island prepares and solves a contiguous range.
+    void BuildSolverIslands() {
+        BodyStore& S = Bodies;
+        const uint32_t n = S.AwakeCount();
+        auto solvable = [&](uint32_t i) { return i < n && S.Info[i].IsDynamic(); };
+
+        m_Islands.Reset(n);
+        for (const auto& man : Contacts)
+            if (solvable(man.BodyA) && solvable(man.BodyB)) m_Islands.Link(man.BodyA, man.BodyB);
+        for (auto* con : Constraints) {
+            if (!S.IsValid(con->BodyA) || !S.IsValid(con->BodyB)) continue;
+            uint32_t a = S.IndexOf(con->BodyA), b = S.IndexOf(con->BodyB);
+            if (solvable(a) && solvable(b)) m_Islands.Link(a, b);
+        }
+        m_Islands.Build();
+        const uint32_t islands = m_Islands.IslandCount();
 
-        for (auto& man : Contacts) {
-            RigidBody* A = man.BodyA, * B = man.BodyB;
-            for (auto& c : man.Contacts) {
-                float pen = c.Depth - SLOP;
-                if (pen <= 0.0f) continue;
+        m_IslandContacts.Reset(islands);
+        for (uint32_t m = 0; m < (uint32_t)Contacts.size(); ++m) {
+            uint32_t a = Contacts[m].BodyA, b = Contacts[m].BodyB;
+            m_IslandContacts.Add(m_Islands.IslandOf(solvable(a) ? a : b), m);
+        }
+        m_IslandContacts.Build();
+
+        m_IslandJoints.Reset(islands);
+        for (auto* con : Constraints) {
+            if (!S.IsValid(con->BodyA) || !S.IsValid(con->BodyB)) continue;
+            uint32_t a = S.IndexOf(con->BodyA), b = S.IndexOf(con->BodyB);
+            if (solvable(a)) m_IslandJoints.Add(m_Islands.IslandOf(a), con);
+            else if (solvable(b)) m_IslandJoints.Add(m_Islands.IslandOf(b), con);
+        }
+        m_IslandJoints.Build();
+        if (JointSolverMode == JointSolverType::Direct && SolverMode != SolverType::XPBD) m_JointTrees.Build(S, m_IslandJoints);
+
+        m_IslandPasses.assign(islands, 0);
+        m_FirstRow.resize(Contacts.size());
+        m_IslandRows.assign(1, 0);
+        uint32_t rowCount = 0;
+        for (uint32_t k = 0; k < islands; ++k) {
+            for (uint32_t o = m_IslandContacts.Offsets[k]; o < m_IslandContacts.Offsets[k + 1]; ++o) {
+                uint32_t m = m_IslandContacts.Items[o];
+                m_FirstRow[m] = rowCount; rowCount += (uint32_t)Contacts[m].Contacts.size();
+            }
+            m_IslandRows.push_back(rowCount);
+        }
+        if (SolverMode == SolverType::XPBD) m_PositionContacts.resize(rowCount);
+        else m_ContactRows.resize(rowCount);
+
+        m_IslandBatches.clear(); m_IslandBatches.push_back(0);
+        uint32_t rows = 0;
+        for (uint32_t k = 0; k < islands; ++k) {
+            rows += (m_IslandRows[k + 1] - m_IslandRows[k]) + m_IslandJoints.Count(k) + 1;
+            if (rows >= MinBatchRows) { m_IslandBatches.push_back(k + 1); rows = 0; }
+        }
+        if (m_IslandBatches.back() != islands) m_IslandBatches.push_back(islands);
+    }
 
-                glm::vec3 wA = A->LocalToWorld(c.LocalPointA);
-                glm::vec3 wB = B->LocalToWorld(c.LocalPointB);
-                glm::vec3 rA = wA - A->Position;
-                glm::vec3 rB = wB - B->Position;
+    // Builds the contact rows of island k, prepares its joints and applies
+    // the warm-start impulses.
+    void PrepareIsland(uint32_t k, float dt, float invDt) {
+        BodyStore& S = Bodies;
+        for (uint32_t o = m_IslandContacts.Offsets[k]; o < m_IslandContacts.Offsets[k + 1]; ++o) {
+            uint32_t m = m_IslandContacts.Items[o];
+            Manifold& man = Contacts[m];
+            for (auto& c : man.Contacts) BuildTangentBasis(man.Normal, c.Tangent0, c.Tangent1);
+            Cache.WarmStart(man, m_WarmStartScale);
+            PrepareContactRows(S, man, &m_ContactRows[m_FirstRow[m]], invDt);
+        }
+        if (SolverMode == SolverType::SoftStep)
+            for (uint32_t r = m_IslandRows[k]; r < m_IslandRows[k + 1]; ++r)
+                SoftenContactRow(m_ContactRows[r], m_ContactSoftness, invDt, ContactPushMaxVelocity);
+        for (uint32_t r = m_IslandRows[k]; r < m_IslandRows[k + 1]; ++r) WarmStartContactRow(S, m_ContactRows[r]);
+
+        for (uint32_t o = m_IslandJoints.Offsets[k]; o < m_IslandJoints.Offsets[k + 1]; ++o)
+            m_IslandJoints.Items[o]->BeginSubStep(S, dt, invDt);
+        if (JointSolverMode == JointSolverType::Direct) m_JointTrees.Factor(S, k, dt, invDt);
+    }
 
-                float actualPen = glm::dot(wB - wA, -man.Normal);
-                pen = actualPen - SLOP;
-                if (pen <= 0.0f) continue;
+    // Velocity passes of the graph-colored solver over every island at once;
+    // joints are solved on the calling thread after each sweep over the
+    // colors. `relax` selects the rigid pass that follows a soft step.
+    // Returns the number of passes run.
+    int SolveColoredVelocities(float dt, float invDt, bool relax) {
+        BodyStore& S = Bodies;
+        const bool soft = SolverMode == SolverType::SoftStep;
+        const int iterations = soft ? 1 : SolverIterations;
+        int iter = 0;
+        while (iter < iterations) {
+            bool settled = m_ColorSolver.SolveIteration(S, *m_Pool, soft && !relax, SolverTolerance, BlockContactSolver);
+            float change = 0.0f;
+            for (auto* con : m_IslandJoints.Items) change = std::max(change, con->SolveVelocity(S, dt, invDt, !relax));
+            if (JointSolverMode == JointSolverType::Direct)
+                for (uint32_t k = 0; k < m_JointTrees.IslandCount(); ++k) change = std::max(change, m_JointTrees.Solve(S, k, dt, !relax));
+            ++iter;
+            if (SolverTolerance > 0.0f && settled && change <= SolverTolerance) break;
+        }
+        return iter;
+    }
 
-                float em = EffectiveMass(A, B, rA, rB, man.Normal);
-                if (em < 1e-10f) continue;
+    // One velocity pass over the rows and joints of island k; returns the
+    // largest velocity change it made.
+    float SolveIslandVelocities(uint32_t k, float dt, float invDt, bool soft, bool useBias) {
+        BodyStore& S = Bodies;
+        float change = 0.0f;
+        if (BlockContactSolver && !soft) {
+            for (uint32_t o = m_IslandContacts.Offsets[k]; o < m_IslandContacts.Offsets[k + 1]; ++o) {
+                uint32_t m = m_IslandContacts.Items[o], count = (uint32_t)Contacts[m].Contacts.size();
+                if (count > 0) change = std::max(change, SolveContactBlock(S, &m_ContactRows[m_FirstRow[m]], count));
+            }
+        } else {
+            for (uint32_t r = m_IslandRows[k]; r < m_IslandRows[k + 1]; ++r)
+                change = std::max(change, SolveContactRow(S, m_ContactRows[r], soft));
+        }
+        for (uint32_t o = m_IslandJoints.Offsets[k]; o < m_IslandJoints.Offsets[k + 1]; ++o)
+            change = std::max(change, m_IslandJoints.Items[o]->SolveVelocity(S, dt, invDt, useBias));
+        if (JointSolverMode == JointSolverType::Direct) change = std::max(change, m_JointTrees.Solve(S, k, dt, useBias));
+        return change;
+    }
 
-                float corr = std::min(ERP * pen, MAX_COR) / em;
-                glm::vec3 cv = man.Normal * corr;
-                if (A->CanMove()) A->Position -= cv * A->InverseMass;
-                if (B->CanMove()) B->Position += cv * B->InverseMass;
+    // Runs every stage of the sequential solver for one island. Islands share
+    // no dynamic body, so any number of them can run at once.
+    void SolveIsland(uint32_t k, float dt, float invDt) {
+        PrepareIsland(k, dt, invDt);
+        if (SolverMode == SolverType::SoftStep) {
+            SolveIslandVelocities(k, dt, invDt, true, true);
+            FinishIsland(k, dt);
+            SolveIslandVelocities(k, dt, invDt, false, false);
+            m_IslandPasses[k] = 2;
+        } else {
+            int iter = 0;
+            while (iter < SolverIterations) {
+                float change = SolveIslandVelocities(k, dt, invDt, false, true);
+                ++iter;
+                if (SolverTolerance > 0.0f && change <= SolverTolerance) break;
             }
+            m_IslandPasses[k] = iter;
+            FinishIsland(k, dt);
+        }
+        for (uint32_t o = m_IslandContacts.Offsets[k]; o < m_IslandContacts.Offsets[k + 1]; ++o) {
+            uint32_t m = m_IslandContacts.Items[o];
+            StoreContactRows(&m_ContactRows[m_FirstRow[m]], Contacts[m]);
         }
     }
 
-    void TickSleep(float dt) {
-        const float ls = SleepLinVelThreshold * SleepLinVelThreshold;
-        const float as_ = SleepAngVelThreshold * SleepAngVelThreshold;
-        for (auto* b : Bodies) {
-            if (!b->IsDynamic()) continue;
-            if (glm::length2(b->LinearVelocity) < ls && glm::length2(b->AngularVelocity) < as_) {
-                b->SleepTimer += dt;
-                if (b->SleepTimer >= SleepTimeThreshold) {
-                    b->IsAwake = false; b->LinearVelocity = {}; b->AngularVelocity = {};
-                }
+    // Integrates the positions of island k, runs the position correction of
+    // the iterative solver and refits. The soft-step relax pass reuses the
+    // rows prepared at the start of the substep, so it may run after this.
+    void FinishIsland(uint32_t k, float dt) {
+        IntegrateIsland(k, dt);
+        if (SolverMode == SolverType::Iterative) ProjectIsland(k);
+        RefitIsland(k);
+    }
+
+    // Position correction of the iterative solver over island k's contacts.
+    void ProjectIsland(uint32_t k) {
+        const uint32_t c0 = m_IslandContacts.Offsets[k], c1 = m_IslandContacts.Offsets[k + 1];
+        for (int pass = 0; pass < PositionIterations; ++pass)
+            for (uint32_t o = c0; o < c1; ++o) SolveManifoldPosition(Contacts[m_IslandContacts.Items[o]]);
+    }
+
+    // An XPBD substep of island k: integrates the poses, runs the position
+    // passes over its contacts and joints, takes the velocities from the
+    // motion, corrects them for restitution and friction and refits. The
+    // normal impulses are stored in the manifolds for the cache.
+    void SolveIslandPositions(uint32_t k, float dt) {
+        BodyStore& S = Bodies;
+        const uint32_t c0 = m_IslandContacts.Offsets[k], c1 = m_IslandContacts.Offsets[k + 1];
+        const uint32_t j0 = m_IslandJoints.Offsets[k], j1 = m_IslandJoints.Offsets[k + 1];
+        const uint32_t b0 = m_Islands.Offsets[k], b1 = m_Islands.Offsets[k + 1];
+        const uint32_t r0 = m_IslandRows[k], r1 = m_IslandRows[k + 1];
+
+        for (uint32_t o = c0; o < c1; ++o) {
+            uint32_t m = m_IslandContacts.Items[o];
+            PreparePositionContacts(S, Contacts[m], &m_PositionContacts[m_FirstRow[m]]);
+        }
+        for (uint32_t o = j0; o < j1; ++o) m_IslandJoints.Items[o]->BeginPositionSolve(S, dt);
+        for (uint32_t o = b0; o < b1; ++o) {
+            uint32_t i = m_Islands.Bodies[o];
+            m_PrevPoses[i] = { S.Position[i], S.Orientation[i] };
+        }
+        IntegrateIsland(k, dt);
+
+        int pass = 0;
+        while (pass < PositionIterations) {
+            float moved = 0.0f;
+            for (uint32_t r = r0; r < r1; ++r)
+                moved = std::max(moved, SolvePositionContact(S, m_PositionContacts[r]));
+            for (uint32_t o = c0; o < c1; ++o) {
+                uint32_t m = m_IslandContacts.Items[o];
+                if (Contacts[m].Contacts.empty()) continue;
+                moved = std::max(moved, SolvePositionFriction(S, &m_PositionContacts[m_FirstRow[m]], (uint32_t)Contacts[m].Contacts.size(), m_PrevPoses.data(), dt));
+            }
+            for (uint32_t o = j0; o < j1; ++o) moved = std::max(moved, m_IslandJoints.Items[o]->SolvePosition(S, dt));
+            ++pass;
+            if (SolverTolerance > 0.0f && moved <= SolverTolerance * dt) break;
+        }
+        m_IslandPasses[k] = pass;
+
+        for (uint32_t o = b0; o < b1; ++o) {
+            uint32_t i = m_Islands.Bodies[o];
+            if (!S.Info[i].IsDynamic()) continue;
+            const BodyPose& prev = m_PrevPoses[i];
+            S.LinearVelocity[i] = (S.Position[i] - prev.Position) / dt;
+            glm::quat dq = S.Orientation[i] * glm::conjugate(prev.Orientation);
+            glm::vec3 w = glm::vec3(dq.x, dq.y, dq.z) * (2.0f / dt);
+            S.AngularVelocity[i] = dq.w >= 0.0f ? w : -w;
+        }
+        for (uint32_t r = r0; r < r1; ++r) SolveVelocityContact(S, m_PositionContacts[r]);
+        for (uint32_t o = c0; o < c1; ++o) {
+            uint32_t m = m_IslandContacts.Items[o];
+            if (Contacts[m].Contacts.empty()) continue;
+            SolveVelocityFriction(S, &m_PositionContacts[m_FirstRow[m]], (uint32_t)Contacts[m].Contacts.size(), dt);
+        }
+        RefitIsland(k);
+
+        for (uint32_t o = c0; o < c1; ++o) {
+            uint32_t m = m_IslandContacts.Items[o];
+            Manifold& man = Contacts[m];
+            for (size_t p = 0; p < man.Contacts.size(); ++p) {
+                ContactPoint& c = man.Contacts[p];
+                c.NormalImpulse = m_PositionContacts[m_FirstRow[m] + p].LambdaN / dt;
+                c.TangentImpulse0 = c.TangentImpulse1 = 0.0f;
             }
-            else { b->SleepTimer = 0.0f; b->IsAwake = true; }
         }
     }
-};
\ No newline at end of file
+
+    // Moves the dynamic bodies of island k along their velocities.
+    void IntegrateIsland(uint32_t k, float dt) {
+        const uint32_t* bodies = m_Islands.Bodies.data() + m_Islands.Offsets[k];
+        IntegratePoses(Bodies, m_Islands.Offsets[k + 1] - m_Islands.Offsets[k], [bodies](uint32_t o) { return bodies[o]; }, dt);
+    }
+
+    void RefitIsland(uint32_t k) {
+        const uint32_t* bodies = m_Islands.Bodies.data() + m_Islands.Offsets[k];
+        RefitBodies(Bodies, m_Islands.Offsets[k + 1] - m_Islands.Offsets[k], [bodies](uint32_t o) { return bodies[o]; });
+    }
+
+    void SolveManifoldPosition(Manifold& man) {
+        const float ERP = 0.3f;
+        const float SLOP = 0.005f;
+        const float MAX_COR = 0.2f;
+        BodyStore& S = Bodies;
+
+        uint32_t a = man.BodyA, b = man.BodyB;
+        for (auto& c : man.Contacts) {
+            float pen = c.Depth - SLOP;
+            if (pen <= 0.0f) continue;
+
+            glm::vec3 wA = S.LocalToWorld(a, c.LocalPointA);
+            glm::vec3 wB = S.LocalToWorld(b, c.LocalPointB);
+            glm::vec3 rA = wA - S.Position[a];
+            glm::vec3 rB = wB - S.Position[b];
+
+            float actualPen = glm::dot(wB - wA, -man.Normal);
+            pen = actualPen - SLOP;
+            if (pen <= 0.0f) continue;
+
+            float em = EffectiveMass(S, a, b, rA, rB, man.Normal);
+            if (em < 1e-10f) continue;
+
+            float corr = std::min(ERP * pen, MAX_COR) / em;
+            glm::vec3 cv = man.Normal * corr;
+            if (S.SolverInverseMass(a) > 0.0f) S.Position[a] -= cv * S.InverseMass[a];
+            if (S.SolverInverseMass(b) > 0.0f) S.Position[b] += cv * S.InverseMass[b];
+        }
+    }
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "AABB.h"
+#include "FixedVector.h"
+
+enum class ShapeType { Sphere, Box, TriangleMesh, ConvexHull, Capsule, Cylinder, Heightfield, Compound };
+
+// Polygon a shape presents in some direction, wound counter-clockwise seen
+// from outside. Curved shapes present a single point.
+constexpr uint32_t MaxSupportFaceVertices = 32;
+using SupportFace = FixedVector<glm::vec3, MaxSupportFaceVertices>;
+
+struct Shape {
+    ShapeType Type;
+    virtual ~Shape() = default;
+    virtual AABB      ComputeLocalAABB()               const = 0;
+    virtual glm::mat3 ComputeInertiaTensor(float mass)  const = 0;
+    virtual glm::vec3 GetLocalSupport(const glm::vec3& dir) const = 0;
+    // Used to split a compound's mass between its children; 0 for shapes
+    // that are static only.
+    virtual float     ComputeVolume()                  const { return 0.0f; }
+    // The face whose outward normal is closest to `dir`, in local space.
+    virtual void GetLocalSupportFace(const glm::vec3& dir, SupportFace& out) const {
+        out.clear();
+        out.push_back(GetLocalSupport(dir));
+    }
+};
+
+struct SphereShape : public Shape {
+    float Radius;
+    explicit SphereShape(float r) : Radius(r) { Type = ShapeType::Sphere; }
+    AABB ComputeLocalAABB() const override { return { glm::vec3(-Radius), glm::vec3(Radius) }; }
+    glm::mat3 ComputeInertiaTensor(float mass) const override {
+        float I = (2.0f / 5.0f) * mass * Radius * Radius;
+        return glm::mat3(I);
+    }
+    float ComputeVolume() const override { return (4.0f / 3.0f) * 3.14159265f * Radius * Radius * Radius; }
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        float len = glm::length(dir);
+        return (len > 1e-8f) ? (dir / len) * Radius : glm::vec3(0, Radius, 0);
+    }
+};
+
+struct BoxShape : public Shape {
+    glm::vec3 HalfExtents;
+    explicit BoxShape(const glm::vec3& half) : HalfExtents(half) { Type = ShapeType::Box; }
+    AABB ComputeLocalAABB() const override { return { -HalfExtents, HalfExtents }; }
+    glm::mat3 ComputeInertiaTensor(float mass) const override {
+        float ex = 2.0f * HalfExtents.x, ey = 2.0f * HalfExtents.y, ez = 2.0f * HalfExtents.z;
+        float ix = (1.0f / 12.0f) * mass * (ey * ey + ez * ez);
+        float iy = (1.0f / 12.0f) * mass * (ex * ex + ez * ez);
+        float iz = (1.0f / 12.0f) * mass * (ex * ex + ey * ey);
+        return { glm::vec3(ix, 0, 0), glm::vec3(0, iy, 0), glm::vec3(0, 0, iz) };
+    }
+    float ComputeVolume() const override { return 8.0f * HalfExtents.x * HalfExtents.y * HalfExtents.z; }
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        return {
+            dir.x >= 0 ? HalfExtents.x : -HalfExtents.x,
+            dir.y >= 0 ? HalfExtents.y : -HalfExtents.y,
+            dir.z >= 0 ? HalfExtents.z : -HalfExtents.z
+        };
+    }
+    void GetLocalSupportFace(const glm::vec3& dir, SupportFace& out) const override {
+        glm::vec3 a = glm::abs(dir);
+        int i = 0; if (a.y > a.x) i = 1; if (a.z > a[i]) i = 2;
+        int b = (i + 1) % 3, c = (i + 2) % 3;
+        float s = dir[i] >= 0.0f ? 1.0f : -1.0f;
+        // (U, V) corners in counter-clockwise order about U x V = e_i.
+        const float corners[4][2] = { { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } };
+        out.clear();
+        for (int k = 0; k < 4; ++k) {
+            const float* uv = corners[s > 0.0f ? k : 3 - k];
+            glm::vec3 v;
+            v[i] = s * HalfExtents[i]; v[b] = uv[0] * HalfExtents[b]; v[c] = uv[1] * HalfExtents[c];
+            out.push_back(v);
+        }
+    }
+};
+
+// Capsules and cylinders run along their local Y axis.
+
+// Segment from -HalfHeight to +HalfHeight on Y, swept by a sphere.
+struct CapsuleShape : public Shape {
+    float Radius, HalfHeight;
+    CapsuleShape(float r, float halfHeight) : Radius(r), HalfHeight(halfHeight) { Type = ShapeType::Capsule; }
+    AABB ComputeLocalAABB() const override { return { -glm::vec3(Radius, HalfHeight + Radius, Radius), glm::vec3(Radius, HalfHeight + Radius, Radius) }; }
+    glm::mat3 ComputeInertiaTensor(float mass) const override {
+        // Cylinder plus two hemispheres, with the mass split by volume.
+        const float r2 = Radius * Radius, H = 2.0f * HalfHeight;
+        const float vc = H, vs = (4.0f / 3.0f) * Radius;   // both over pi r^2
+        const float mc = mass * vc / (vc + vs), ms = mass - mc;
+        float iy = mc * r2 * 0.5f + ms * r2 * 0.4f;
+        float ix = mc * (H * H / 12.0f + r2 * 0.25f) + ms * (r2 * 0.4f + H * H * 0.25f + 0.375f * H * Radius);
+        return { glm::vec3(ix, 0, 0), glm::vec3(0, iy, 0), glm::vec3(0, 0, ix) };
+    }
+    float ComputeVolume() const override { return 3.14159265f * Radius * Radius * (2.0f * HalfHeight + (4.0f / 3.0f) * Radius); }
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        float len = glm::length(dir);
+        glm::vec3 n = len > 1e-8f ? dir / len : glm::vec3(0, 1, 0);
+        return glm::vec3(0, n.y >= 0.0f ? HalfHeight : -HalfHeight, 0) + n * Radius;
+    }
+    // Lying across `dir`, the whole side line supports it.
+    void GetLocalSupportFace(const glm::vec3& dir, SupportFace& out) const override {
+        out.clear();
+        float len = glm::length(dir);
+        glm::vec3 n = len > 1e-8f ? dir / len : glm::vec3(0, 1, 0);
+        if (std::abs(n.y) < 0.05f) {
+            out.push_back(glm::vec3(0, HalfHeight, 0) + n * Radius);
+            out.push_back(glm::vec3(0, -HalfHeight, 0) + n * Radius);
+        }
+        else {
+            out.push_back(GetLocalSupport(dir));
+        }
+    }
+};
+
+struct CylinderShape : public Shape {
+    float Radius, HalfHeight;
+    static constexpr uint32_t CapVertices = 16;   // corners of the polygon standing in for a cap
+
+    CylinderShape(float r, float halfHeight) : Radius(r), HalfHeight(halfHeight) { Type = ShapeType::Cylinder; }
+    AABB ComputeLocalAABB() const override { return { -glm::vec3(Radius, HalfHeight, Radius), glm::vec3(Radius, HalfHeight, Radius) }; }
+    glm::mat3 ComputeInertiaTensor(float mass) const override {
+        const float r2 = Radius * Radius, H = 2.0f * HalfHeight;
+        float iy = 0.5f * mass * r2;
+        float ix = (1.0f / 12.0f) * mass * (3.0f * r2 + H * H);
+        return { glm::vec3(ix, 0, 0), glm::vec3(0, iy, 0), glm::vec3(0, 0, ix) };
+    }
+    float ComputeVolume() const override { return 3.14159265f * Radius * Radius * 2.0f * HalfHeight; }
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        float len = std::sqrt(dir.x * dir.x + dir.z * dir.z);
+        glm::vec3 s(0, dir.y >= 0.0f ? HalfHeight : -HalfHeight, 0);
+        if (len > 1e-8f) { s.x = dir.x / len * Radius; s.z = dir.z / len * Radius; }
+        return s;
+    }
+    // A cap polygon, or the side line when `dir` is nearly perpendicular to the axis.
+    void GetLocalSupportFace(const glm::vec3& dir, SupportFace& out) const override {
+        out.clear();
+        float len = glm::length(dir);
+        if (std::abs(dir.y) < 0.05f * len) {
+            glm::vec3 s = GetLocalSupport(dir);
+            out.push_back(glm::vec3(s.x, HalfHeight, s.z));
+            out.push_back(glm::vec3(s.x, -HalfHeight, s.z));
+            return;
+        }
+        const float sign = dir.y >= 0.0f ? 1.0f : -1.0f;
+        for (uint32_t k = 0; k < CapVertices; ++k) {
+            float a = float(k) * (6.2831853f / CapVertices);
+            out.push_back(glm::vec3(Radius * std::cos(a), sign * HalfHeight, -sign * Radius * std::sin(a)));
+        }
+    }
+};
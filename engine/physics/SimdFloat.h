@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// Fixed-width float vector for the batched solver kernels. The width follows
+// the widest instruction set the build enables: 8 lanes with AVX, 4 with SSE2
+// (every x86-64 target), and 4 plain floats anywhere else. Kernels are written
+// against FloatW::Width and never name an instruction set directly.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PHYSIM_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHYSIM_SIMD_SSE 1
+#endif
+
+struct FloatW {
+#if defined(PHYSIM_SIMD_AVX)
+    static constexpr int Width = 8;
+    __m256 V;
+
+    static FloatW Splat(float f) { return { _mm256_set1_ps(f) }; }
+    friend FloatW operator+(FloatW a, FloatW b) { return { _mm256_add_ps(a.V, b.V) }; }
+    friend FloatW operator-(FloatW a, FloatW b) { return { _mm256_sub_ps(a.V, b.V) }; }
+    friend FloatW operator*(FloatW a, FloatW b) { return { _mm256_mul_ps(a.V, b.V) }; }
+    friend FloatW operator/(FloatW a, FloatW b) { return { _mm256_div_ps(a.V, b.V) }; }
+    friend FloatW Sqrt(FloatW a) { return { _mm256_sqrt_ps(a.V) }; }
+    friend FloatW Min(FloatW a, FloatW b) { return { _mm256_min_ps(a.V, b.V) }; }
+    friend FloatW Max(FloatW a, FloatW b) { return { _mm256_max_ps(a.V, b.V) }; }
+#elif defined(PHYSIM_SIMD_SSE)
+    static constexpr int Width = 4;
+    __m128 V;
+
+    static FloatW Splat(float f) { return { _mm_set1_ps(f) }; }
+    friend FloatW operator+(FloatW a, FloatW b) { return { _mm_add_ps(a.V, b.V) }; }
+    friend FloatW operator-(FloatW a, FloatW b) { return { _mm_sub_ps(a.V, b.V) }; }
+    friend FloatW operator*(FloatW a, FloatW b) { return { _mm_mul_ps(a.V, b.V) }; }
+    friend FloatW operator/(FloatW a, FloatW b) { return { _mm_div_ps(a.V, b.V) }; }
+    friend FloatW Sqrt(FloatW a) { return { _mm_sqrt_ps(a.V) }; }
+    friend FloatW Min(FloatW a, FloatW b) { return { _mm_min_ps(a.V, b.V) }; }
+    friend FloatW Max(FloatW a, FloatW b) { return { _mm_max_ps(a.V, b.V) }; }
+#else
+    static constexpr int Width = 4;
+    float V[4];
+
+    template<typename Op>
+    static FloatW Map(FloatW a, FloatW b, Op op) { FloatW r; for (int i = 0; i < 4; ++i) r.V[i] = op(a.V[i], b.V[i]); return r; }
+    static FloatW Splat(float f) { return { { f, f, f, f } }; }
+    friend FloatW operator+(FloatW a, FloatW b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+    friend FloatW operator-(FloatW a, FloatW b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+    friend FloatW operator*(FloatW a, FloatW b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+    friend FloatW operator/(FloatW a, FloatW b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+    friend FloatW Sqrt(FloatW a) { return Map(a, a, [](float x, float) { return std::sqrt(x); }); }
+    friend FloatW Min(FloatW a, FloatW b) { return Map(a, b, [](float x, float y) { return std::min(x, y); }); }
+    friend FloatW Max(FloatW a, FloatW b) { return Map(a, b, [](float x, float y) { return std::max(x, y); }); }
+#endif
+
+    // Lane access, used when packing and unpacking; kernels stay lane-parallel.
+    float& operator[](int i) { return reinterpret_cast<float*>(&V)[i]; }
+    float  operator[](int i) const { return reinterpret_cast<const float*>(&V)[i]; }
+
+    friend FloatW operator-(FloatW a) { return FloatW::Splat(0.0f) - a; }
+    FloatW& operator+=(FloatW b) { return *this = *this + b; }
+    FloatW& operator-=(FloatW b) { return *this = *this - b; }
+};
+
+struct Vec3W {
+    FloatW X, Y, Z;
+
+    void Set(int lane, const glm::vec3& v) { X[lane] = v.x; Y[lane] = v.y; Z[lane] = v.z; }
+    glm::vec3 Get(int lane) const { return { X[lane], Y[lane], Z[lane] }; }
+
+    static Vec3W Splat(const glm::vec3& v) { return { FloatW::Splat(v.x), FloatW::Splat(v.y), FloatW::Splat(v.z) }; }
+
+    friend Vec3W operator+(const Vec3W& a, const Vec3W& b) { return { a.X + b.X, a.Y + b.Y, a.Z + b.Z }; }
+    friend Vec3W operator-(const Vec3W& a, const Vec3W& b) { return { a.X - b.X, a.Y - b.Y, a.Z - b.Z }; }
+    friend Vec3W operator*(const Vec3W& a, FloatW s) { return { a.X * s, a.Y * s, a.Z * s }; }
+    Vec3W& operator+=(const Vec3W& b) { X += b.X; Y += b.Y; Z += b.Z; return *this; }
+    Vec3W& operator-=(const Vec3W& b) { X -= b.X; Y -= b.Y; Z -= b.Z; return *this; }
+};
+
+inline FloatW Dot(const Vec3W& a, const Vec3W& b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
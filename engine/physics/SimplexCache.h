@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "PairTable.h"
+
+// The simplex GJK ended on for a pair in the previous step, as support
+// points in each body's local frame so it stays valid while the pair moves.
+// Rebuilding it in world space gives GJK a start next to the answer.
+struct CachedSimplex {
+    uint64_t  Key = EmptyPairKey;
+    uint32_t  Stamp = 0;
+    uint32_t  Count = 0;
+    glm::vec3 LocalA[4];
+    glm::vec3 LocalB[4];
+};
+
+class SimplexCache {
+public:
+    const CachedSimplex* Find(uint64_t key) const { return m_Table.Find(key); }
+
+    void Store(const CachedSimplex& s) {
+        CachedSimplex& e = m_Table.Insert(s.Key);
+        uint32_t stamp = e.Stamp;
+        e = s;
+        e.Stamp = stamp;
+    }
+
+    // Same schedule as ManifoldCache::EvictStale: pairs that went a whole
+    // step without a GJK query are dropped.
+    void EvictStale() { m_Table.EvictStale(); }
+
+    void Clear() { m_Table.Clear(); }
+    uint32_t Size() const { return m_Table.Size(); }
+
+private:
+    PairTable<CachedSimplex> m_Table;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <numeric>
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+#include "AABB.h"
+
+// Bounding volume hierarchy over boxes that never move, built once with the
+// surface area heuristic and then only queried. Nodes are stored depth
+// first: an interior node's left child follows it and Offset holds the right
+// one; a leaf's Offset and Count give its range of the leaf-ordered boxes.
+class StaticAABBTree {
+public:
+    static constexpr uint32_t MaxLeafItems = 2;
+    static constexpr uint32_t Bins = 12;
+    // Past this depth splits fall back to the median, which bounds the
+    // depth (and the query stack) however the boxes are laid out.
+    static constexpr uint32_t MaxSAHDepth = 32;
+
+    // Replaces the tree with one over `boxes`; userData[k] is reported for boxes[k].
+    void Build(const std::vector<AABB>& boxes, const std::vector<uint32_t>& userData) {
+        m_Nodes.clear(); m_Boxes.clear(); m_UserData.clear();
+        if (boxes.empty()) return;
+        m_Order.resize(boxes.size());
+        std::iota(m_Order.begin(), m_Order.end(), 0u);
+        m_Centers.resize(boxes.size());
+        for (size_t k = 0; k < boxes.size(); ++k) m_Centers[k] = boxes[k].Center();
+        m_Nodes.reserve(2 * boxes.size());
+        Build(boxes, 0, (uint32_t)boxes.size(), 0);
+
+        m_Boxes.reserve(boxes.size()); m_UserData.reserve(boxes.size());
+        for (uint32_t k : m_Order) { m_Boxes.push_back(boxes[k]); m_UserData.push_back(userData[k]); }
+    }
+
+    // Calls cb(userData) for every box overlapping `box`; cb returns false
+    // to stop the traversal early.
+    template<typename F>
+    void Query(const AABB& box, F&& cb) const {
+        if (m_Nodes.empty()) return;
+        std::array<uint32_t, 2 * MaxSAHDepth> stack; int sp = 0;
+        uint32_t id = 0;
+        for (;;) {
+            const Node& n = m_Nodes[id];
+            if (Overlaps(n, box)) {
+                if (n.Count > 0) {
+                    for (uint32_t k = n.Offset; k < n.Offset + n.Count; ++k)
+                        if (m_Boxes[k].Overlaps(box) && !cb(m_UserData[k])) return;
+                }
+                else {
+                    stack[sp++] = n.Offset;
+                    id = id + 1;
+                    continue;
+                }
+            }
+            if (sp == 0) return;
+            id = stack[--sp];
+        }
+    }
+
+    uint32_t Size() const { return (uint32_t)m_Boxes.size(); }
+
+private:
+    struct Node {
+        glm::vec3 Min; uint32_t Offset;
+        glm::vec3 Max; uint32_t Count;   // 0 for interior nodes
+    };
+
+    std::vector<Node>      m_Nodes;
+    std::vector<AABB>      m_Boxes;      // in leaf order
+    std::vector<uint32_t>  m_UserData;   // in leaf order
+    std::vector<uint32_t>  m_Order;      // build scratch: box indices in leaf order
+    std::vector<glm::vec3> m_Centers;    // build scratch
+
+    static bool Overlaps(const Node& n, const AABB& b) {
+        return n.Max.x >= b.Min.x && n.Min.x <= b.Max.x &&
+            n.Max.y >= b.Min.y && n.Min.y <= b.Max.y &&
+            n.Max.z >= b.Min.z && n.Min.z <= b.Max.z;
+    }
+
+    // Splits m_Order[first, last) where the binned surface area heuristic
+    // finds it cheapest, or at the centroid median of the longest axis past
+    // MaxSAHDepth or when every centroid falls in one bin.
+    uint32_t Build(const std::vector<AABB>& boxes, uint32_t first, uint32_t last, uint32_t depth) {
+        AABB bounds, cb;
+        for (uint32_t k = first; k < last; ++k) {
+            bounds = AABB::Union(bounds, boxes[m_Order[k]]);
+            cb.Min = glm::min(cb.Min, m_Centers[m_Order[k]]); cb.Max = glm::max(cb.Max, m_Centers[m_Order[k]]);
+        }
+        const uint32_t id = (uint32_t)m_Nodes.size();
+        m_Nodes.push_back({ bounds.Min, first, bounds.Max, last - first });
+        if (last - first <= MaxLeafItems) return id;
+
+        glm::vec3 ext = cb.Max - cb.Min;
+        int axis = 0; if (ext.y > ext.x) axis = 1; if (ext.z > ext[axis]) axis = 2;
+        uint32_t mid = first + (last - first) / 2;
+        int bestAxis = -1; uint32_t bestBin = 0; float bestCost = FLT_MAX;
+        if (depth < MaxSAHDepth) {
+            for (int a = 0; a < 3; ++a) {
+                if (ext[a] <= 0.0f) continue;
+                std::array<AABB, Bins> binBox; std::array<uint32_t, Bins> binCount{};
+                const float scale = float(Bins) / ext[a];
+                for (uint32_t k = first; k < last; ++k) {
+                    uint32_t b = std::min(Bins - 1, uint32_t((m_Centers[m_Order[k]][a] - cb.Min[a]) * scale));
+                    binBox[b] = AABB::Union(binBox[b], boxes[m_Order[k]]); ++binCount[b];
+                }
+                // Cost of splitting after bin s: area times count on each side.
+                std::array<float, Bins> leftCost{};
+                AABB acc; uint32_t count = 0;
+                for (uint32_t s = 0; s + 1 < Bins; ++s) {
+                    acc = AABB::Union(acc, binBox[s]); count += binCount[s];
+                    leftCost[s] = count ? acc.SurfaceArea() * float(count) : 0.0f;
+                }
+                acc = AABB(); count = 0;
+                for (uint32_t s = Bins - 1; s > 0; --s) {
+                    acc = AABB::Union(acc, binBox[s]); count += binCount[s];
+                    const uint32_t left = (last - first) - count;
+                    if (count == 0 || left == 0) continue;
+                    const float cost = leftCost[s - 1] + acc.SurfaceArea() * float(count);
+                    if (cost < bestCost) { bestCost = cost; bestAxis = a; bestBin = s; }
+                }
+            }
+        }
+        if (bestAxis >= 0) {
+            const float scale = float(Bins) / ext[bestAxis], lo = cb.Min[bestAxis];
+            auto it = std::partition(m_Order.begin() + first, m_Order.begin() + last, [&](uint32_t k) {
+                return std::min(Bins - 1, uint32_t((m_Centers[k][bestAxis] - lo) * scale)) < bestBin;
+                });
+            mid = uint32_t(it - m_Order.begin());
+        }
+        else {
+            std::nth_element(m_Order.begin() + first, m_Order.begin() + mid, m_Order.begin() + last,
+                [&](uint32_t a, uint32_t b) { return m_Centers[a][axis] < m_Centers[b][axis]; });
+        }
+
+        Build(boxes, first, mid, depth + 1);
+        uint32_t right = Build(boxes, mid, last, depth + 1);
+        m_Nodes[id].Offset = right; m_Nodes[id].Count = 0;
+        return id;
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+#include <cstdint>
+
+// Fixed set of worker threads for data-parallel loops. Every participant owns
+// a queue of item indices: it pops from the back of its own queue and, once
+// that is empty, steals from the front of the others, so uneven items (a large
+// island next to a batch of single bodies) still balance. The calling thread
+// takes part in every loop, so a pool with N workers runs N + 1 items at once.
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t workers) : m_Queues(workers + 1) {
+        m_Threads.reserve(workers);
+        for (uint32_t w = 0; w < workers; ++w) m_Threads.emplace_back([this, w] { WorkerLoop(w + 1); });
+    }
+    ~ThreadPool() {
+        { std::lock_guard<std::mutex> lock(m_WakeMutex); m_Stop = true; }
+        m_Wake.notify_all();
+        for (auto& t : m_Threads) t.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t WorkerCount() const { return (uint32_t)m_Threads.size(); }
+    uint32_t ParticipantCount() const { return (uint32_t)m_Queues.size(); }
+
+    // Calls fn(item, participant) for every item in [0, count) and returns once
+    // all of them have finished. `participant` is 0 on the calling thread and
+    // distinct between items running at the same time, so it can index
+    // per-thread scratch buffers. Not reentrant.
+    template<typename F>
+    void ParallelFor(uint32_t count, F&& fn) {
+        using Fn = std::remove_reference_t<F>;
+        if (m_Threads.empty() || count <= 1) { for (uint32_t i = 0; i < count; ++i) fn(i, 0u); return; }
+
+        m_Job = [](void* ctx, uint32_t item, uint32_t p) { (*static_cast<Fn*>(ctx))(item, p); };
+        m_Context = const_cast<void*>(static_cast<const void*>(&fn));
+        m_Remaining.store(count, std::memory_order_relaxed);
+
+        const uint32_t P = ParticipantCount();
+        for (uint32_t q = 0; q < P; ++q) {
+            std::lock_guard<std::mutex> lock(m_Queues[q].Mutex);
+            m_Queues[q].Items.clear(); m_Queues[q].Head = 0;
+            for (uint32_t i = q; i < count; i += P) m_Queues[q].Items.push_back(i);
+        }
+        { std::lock_guard<std::mutex> lock(m_WakeMutex); ++m_Generation; }
+        m_Wake.notify_all();
+
+        RunItems(0);
+        while (m_Remaining.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+    }
+
+private:
+    struct Queue {
+        std::mutex            Mutex;
+        std::vector<uint32_t> Items;
+        size_t                Head = 0;   // items before Head were stolen
+    };
+
+    std::vector<Queue>       m_Queues;    // index 0 belongs to the calling thread
+    std::vector<std::thread> m_Threads;
+
+    void (*m_Job)(void*, uint32_t, uint32_t) = nullptr;
+    void* m_Context = nullptr;
+    std::atomic<uint32_t> m_Remaining{ 0 };
+
+    std::mutex              m_WakeMutex;
+    std::condition_variable m_Wake;
+    uint64_t                m_Generation = 0;
+    bool                    m_Stop = false;
+
+    bool TryPop(uint32_t p, uint32_t& item) {
+        const uint32_t P = ParticipantCount();
+        for (uint32_t k = 0; k < P; ++k) {
+            Queue& q = m_Queues[(p + k) % P];
+            std::lock_guard<std::mutex> lock(q.Mutex);
+            if (q.Head == q.Items.size()) continue;
+            if (k == 0) { item = q.Items.back(); q.Items.pop_back(); }
+            else item = q.Items[q.Head++];
+            return true;
+        }
+        return false;
+    }
+
+    void RunItems(uint32_t p) {
+        uint32_t item;
+        while (TryPop(p, item)) {
+            m_Job(m_Context, item, p);
+            m_Remaining.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void WorkerLoop(uint32_t p) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_WakeMutex);
+                m_Wake.wait(lock, [&] { return m_Stop || m_Generation != seen; });
+                if (m_Stop) return;
+                seen = m_Generation;
+            }
+            RunItems(p);
+        }
+    }
+};
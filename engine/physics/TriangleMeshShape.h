@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Shape.h"
+
+// Static triangle soup with a bounding volume hierarchy, for level geometry
+// imported as meshes. The tree is built once: nodes are 32 bytes and laid
+// out depth first, so the left child of an interior node is the next node
+// and a traversal walks memory mostly forward. Triangles are copied into
+// leaf order with their vertices inline, so a leaf's triangles sit next to
+// each other and no index buffer is chased during queries.
+//
+// The mesh is one-sided: triangles collide only with shapes in front of
+// them, where front follows the counter-clockwise winding.
+struct TriangleMeshShape : public Shape {
+    struct Triangle {
+        glm::vec3 V[3];
+    };
+
+    // Interior nodes have Count == 0 and keep their right child in Offset;
+    // leaves keep their first triangle in Offset.
+    struct Node {
+        glm::vec3 Min;
+        uint32_t  Offset;
+        glm::vec3 Max;
+        uint32_t  Count;
+    };
+
+    static constexpr uint32_t MaxLeafTriangles = 4;
+
+    // `indices` holds three vertex indices per triangle. `scale` is baked
+    // into the vertices, since bodies carry no scale of their own.
+    TriangleMeshShape(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices,
+        const glm::vec3& scale = glm::vec3(1.0f))
+    {
+        Type = ShapeType::TriangleMesh;
+        const uint32_t count = (uint32_t)(indices.size() / 3);
+
+        std::vector<Triangle> tris; tris.reserve(count);
+        for (uint32_t t = 0; t < count; ++t) {
+            Triangle tri{ { vertices[indices[3 * t]] * scale, vertices[indices[3 * t + 1]] * scale, vertices[indices[3 * t + 2]] * scale } };
+            // Slivers have no normal to collide along.
+            glm::vec3 n = glm::cross(tri.V[1] - tri.V[0], tri.V[2] - tri.V[0]);
+            if (glm::dot(n, n) > 1e-12f) tris.push_back(tri);
+        }
+        for (const Triangle& t : tris) for (const glm::vec3& v : t.V) { m_Bounds.Min = glm::min(m_Bounds.Min, v); m_Bounds.Max = glm::max(m_Bounds.Max, v); }
+        if (tris.empty()) { m_Bounds = { glm::vec3(0.0f), glm::vec3(0.0f) }; return; }
+
+        std::vector<uint32_t> order(tris.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::vector<glm::vec3> centroids(tris.size());
+        for (size_t t = 0; t < tris.size(); ++t) centroids[t] = (tris[t].V[0] + tris[t].V[1] + tris[t].V[2]) / 3.0f;
+
+        m_Nodes.reserve(2 * tris.size() / MaxLeafTriangles + 1);
+        Build(tris, centroids, order, 0, (uint32_t)order.size());
+
+        m_Triangles.reserve(order.size());
+        for (uint32_t t : order) m_Triangles.push_back(tris[t]);
+    }
+
+    AABB ComputeLocalAABB() const override { return m_Bounds; }
+
+    // Meshes are static only, so the inertia is never used.
+    glm::mat3 ComputeInertiaTensor(float) const override { return glm::mat3(0.0f); }
+
+    glm::vec3 GetLocalSupport(const glm::vec3& dir) const override {
+        glm::vec3 best(0.0f); float bestD = -FLT_MAX;
+        for (const Triangle& t : m_Triangles)
+            for (const glm::vec3& v : t.V) { float d = glm::dot(v, dir); if (d > bestD) { bestD = d; best = v; } }
+        return best;
+    }
+
+    // Calls cb(index, triangle) for every triangle whose leaf overlaps the
+    // local-space box. Indices follow leaf order and are stable for the
+    // lifetime of the shape. The tree is median split, so its depth stays
+    // far below the fixed stack size.
+    template<typename F>
+    void Query(const AABB& box, F&& cb) const {
+        if (m_Nodes.empty()) return;
+        std::array<uint32_t, 64> stack; int sp = 0;
+        uint32_t id = 0;
+        for (;;) {
+            const Node& n = m_Nodes[id];
+            if (Overlaps(n, box)) {
+                if (n.Count > 0) {
+                    for (uint32_t t = n.Offset; t < n.Offset + n.Count; ++t) cb(t, m_Triangles[t]);
+                }
+                else {
+                    stack[sp++] = n.Offset;
+                    id = id + 1;
+                    continue;
+                }
+            }
+            if (sp == 0) return;
+            id = stack[--sp];
+        }
+    }
+
+    uint32_t GetTriangleCount() const { return (uint32_t)m_Triangles.size(); }
+    uint32_t GetNodeCount() const { return (uint32_t)m_Nodes.size(); }
+    const Triangle& GetTriangle(uint32_t i) const { return m_Triangles[i]; }
+
+private:
+    std::vector<Node>     m_Nodes;
+    std::vector<Triangle> m_Triangles;
+    AABB                  m_Bounds;
+
+    static bool Overlaps(const Node& n, const AABB& b) {
+        return n.Max.x >= b.Min.x && n.Min.x <= b.Max.x &&
+            n.Max.y >= b.Min.y && n.Min.y <= b.Max.y &&
+            n.Max.z >= b.Min.z && n.Min.z <= b.Max.z;
+    }
+
+    // Splits order[first, last) at the centroid median of its longest axis
+    // and returns the index of the node it emitted.
+    uint32_t Build(const std::vector<Triangle>& tris, const std::vector<glm::vec3>& centroids,
+        std::vector<uint32_t>& order, uint32_t first, uint32_t last)
+    {
+        AABB bounds, cb;
+        for (uint32_t k = first; k < last; ++k) {
+            for (const glm::vec3& v : tris[order[k]].V) { bounds.Min = glm::min(bounds.Min, v); bounds.Max = glm::max(bounds.Max, v); }
+            cb.Min = glm::min(cb.Min, centroids[order[k]]); cb.Max = glm::max(cb.Max, centroids[order[k]]);
+        }
+        const uint32_t id = (uint32_t)m_Nodes.size();
+        m_Nodes.push_back({ bounds.Min, first, bounds.Max, last - first });
+        if (last - first <= MaxLeafTriangles) return id;
+
+        glm::vec3 ext = cb.Max - cb.Min;
+        int axis = 0; if (ext.y > ext.x) axis = 1; if (ext.z > ext[axis]) axis = 2;
+        const uint32_t mid = first + (last - first) / 2;
+        std::nth_element(order.begin() + first, order.begin() + mid, order.begin() + last,
+            [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+        Build(tris, centroids, order, first, mid);
+        uint32_t right = Build(tris, centroids, order, mid, last);
+        m_Nodes[id].Offset = right; m_Nodes[id].Count = 0;
+        return id;
+    }
+};
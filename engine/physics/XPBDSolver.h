@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "BodyStore.h"
+#include "Contact.h"
+
+// Extended position based dynamics, after Mueller et al., "Detailed Rigid
+// Body Simulation with Extended Position Based Dynamics" (2020). A substep
+// integrates the poses, moves them until the constraints hold, derives the
+// velocities from the motion and then corrects those for restitution and
+// the friction the positions could not apply. A constraint's multiplier (lambda) is the position impulse,
+// impulse times dt, it has applied during the substep; its compliance, the
+// inverse of its stiffness in m/N, makes it soft, and 0 makes it rigid.
+
+// Pose of a body when the substep began.
+struct BodyPose {
+    glm::vec3 Position{ 0.0f };
+    glm::quat Orientation{ 1.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// Inverse mass body i shows to a correction along unit `n` at arm `r`.
+inline float GeneralizedInverseMass(const BodyStore& S, uint32_t i, const glm::vec3& r, const glm::vec3& n) {
+    glm::vec3 rxn = glm::cross(r, n);
+    return S.SolverInverseMass(i) + glm::dot(rxn, S.SolverInverseInertia(i) * rxn);
+}
+
+// Moves body i as the position impulse p at arm r would. Bodies with zero
+// inverse mass, or outside the awake range, are never written, so islands
+// can share them across threads.
+inline void ApplyPositionImpulse(BodyStore& S, uint32_t i, const glm::vec3& r, const glm::vec3& p) {
+    if (S.SolverInverseMass(i) == 0.0f) return;
+    S.Position[i] += p * S.InverseMass[i];
+    glm::vec3 w = S.InverseInertiaWorld[i] * glm::cross(r, p);
+    glm::quat& q = S.Orientation[i];
+    q = glm::normalize(q + 0.5f * (glm::quat(0.0f, w.x, w.y, w.z) * q));
+}
+
+inline void ApplyVelocityImpulse(BodyStore& S, uint32_t i, const glm::vec3& r, const glm::vec3& p) {
+    if (S.SolverInverseMass(i) == 0.0f) return;
+    S.LinearVelocity[i] += p * S.InverseMass[i];
+    S.AngularVelocity[i] += S.InverseInertiaWorld[i] * glm::cross(r, p);
+}
+
+// Where the point `local` of body i was when the substep began. Only awake
+// dynamic bodies have a saved pose; the others are taken back along their
+// velocity.
+inline glm::vec3 PreviousPoint(const BodyStore& S, const BodyPose* prev, uint32_t i, const glm::vec3& local, float dt) {
+    if (S.SolverInverseMass(i) > 0.0f) return prev[i].Position + prev[i].Orientation * local;
+    glm::vec3 p = S.LocalToWorld(i, local);
+    return p - S.VelocityAt(i, p) * dt;
+}
+
+// A contact point prepared for the position passes. The points are kept in
+// body space, so every pass measures the overlap at the current poses.
+struct PositionContact {
+    uint32_t  BodyA = 0, BodyB = 0;
+    glm::vec3 LocalA{ 0.0f }, LocalB{ 0.0f };
+    glm::vec3 Normal{ 0.0f };
+    float     Friction = 0.0f;
+    float     Restitution = 0.0f;
+    float     NormalVelocity = 0.0f;   // closing speed before the substep, for restitution
+    float     LambdaN = 0.0f;
+    float     LambdaT = 0.0f;   // friction of the whole manifold, kept in its first point
+};
+
+// Fills one position contact per contact point of `man`; velocities must
+// not have been integrated into the poses yet.
+inline void PreparePositionContacts(const BodyStore& S, const Manifold& man, PositionContact* out) {
+    uint32_t a = man.BodyA, b = man.BodyB;
+    float e = CombineRestitution(S.Info[a].Material, S.Info[b].Material);
+    float mu = CombineFriction(S.Info[a].Material, S.Info[b].Material);
+    for (size_t p = 0; p < man.Contacts.size(); ++p) {
+        const ContactPoint& c = man.Contacts[p];
+        PositionContact& r = out[p];
+        r.BodyA = a; r.BodyB = b;
+        r.LocalA = c.LocalPointA; r.LocalB = c.LocalPointB;
+        r.Normal = man.Normal;
+        r.Friction = mu; r.Restitution = e;
+        r.NormalVelocity = glm::dot(S.VelocityAt(b, c.WorldPointB) - S.VelocityAt(a, c.WorldPointA), man.Normal);
+        r.LambdaN = r.LambdaT = 0.0f;
+    }
+}
+
+// Pushes the points apart along the normal until they no longer overlap.
+// Returns the distance corrected.
+inline float SolvePositionContact(BodyStore& S, PositionContact& c) {
+    const uint32_t a = c.BodyA, b = c.BodyB;
+    const glm::vec3& n = c.Normal;
+    glm::vec3 pA = S.LocalToWorld(a, c.LocalA), pB = S.LocalToWorld(b, c.LocalB);
+    float depth = glm::dot(pA - pB, n);
+    if (depth <= 0.0f) return 0.0f;
+
+    glm::vec3 rA = pA - S.Position[a], rB = pB - S.Position[b];
+    float w = GeneralizedInverseMass(S, a, rA, n) + GeneralizedInverseMass(S, b, rB, n);
+    if (w < 1e-10f) return 0.0f;
+    float dl = depth / w;
+    c.LambdaN += dl;
+    ApplyPositionImpulse(S, a, rA, -n * dl);
+    ApplyPositionImpulse(S, b, rB, n * dl);
+    return depth;
+}
+
+// Friction acts on a manifold as a whole, at the centre of its points and
+// against their summed normal multipliers. Applied point by point, each
+// corner would try to hold the whole body alone and a single position pass
+// would leave tall stacks rocking.
+inline float PatchCentre(const PositionContact* rows, uint32_t count, glm::vec3& localA, glm::vec3& localB) {
+    float lambdaN = 0.0f;
+    localA = localB = glm::vec3(0.0f);
+    for (uint32_t p = 0; p < count; ++p) { lambdaN += rows[p].LambdaN; localA += rows[p].LocalA; localB += rows[p].LocalB; }
+    localA /= float(count); localB /= float(count);
+    return lambdaN;
+}
+
+// Undoes the sliding of the manifold's bodies since the substep began as far
+// as friction can: the tangential multiplier is kept within Friction times
+// the normal ones, so a body that cannot be held slides on with Coulomb
+// friction. Returns the distance corrected.
+inline float SolvePositionFriction(BodyStore& S, PositionContact* rows, uint32_t count, const BodyPose* prev, float dt) {
+    PositionContact& c = rows[0];
+    const uint32_t a = c.BodyA, b = c.BodyB;
+    const glm::vec3& n = c.Normal;
+    glm::vec3 localA, localB;
+    float lambdaN = PatchCentre(rows, count, localA, localB);
+    if (lambdaN <= 0.0f) return 0.0f;
+    glm::vec3 pA = S.LocalToWorld(a, localA), pB = S.LocalToWorld(b, localB);
+    glm::vec3 slide = (pA - PreviousPoint(S, prev, a, localA, dt)) - (pB - PreviousPoint(S, prev, b, localB, dt));
+    slide -= n * glm::dot(slide, n);
+    float len = glm::length(slide);
+    if (len < 1e-7f) return 0.0f;
+    glm::vec3 t = slide / len;
+    glm::vec3 rA = pA - S.Position[a], rB = pB - S.Position[b];
+    float wt = GeneralizedInverseMass(S, a, rA, t) + GeneralizedInverseMass(S, b, rB, t);
+    if (wt < 1e-10f) return 0.0f;
+    float dlt = std::min(len / wt, c.Friction * lambdaN - c.LambdaT);
+    if (dlt <= 0.0f) return 0.0f;
+    c.LambdaT += dlt;
+    ApplyPositionImpulse(S, a, rA, -t * dlt);
+    ApplyPositionImpulse(S, b, rB, t * dlt);
+    return len;
+}
+
+// Velocity correction of a point that pushed during the position passes: the
+// normal velocity the correction left is replaced by the restitution
+// response (none below REST_THRESH).
+inline void SolveVelocityContact(BodyStore& S, const PositionContact& c) {
+    const float REST_THRESH = 1.5f;
+    if (c.LambdaN <= 0.0f) return;
+    const uint32_t a = c.BodyA, b = c.BodyB;
+    const glm::vec3& n = c.Normal;
+    glm::vec3 pA = S.LocalToWorld(a, c.LocalA), pB = S.LocalToWorld(b, c.LocalB);
+    glm::vec3 rA = pA - S.Position[a], rB = pB - S.Position[b];
+    float vn = glm::dot(S.VelocityAt(b, pB) - S.VelocityAt(a, pA), n);
+    float e = (c.NormalVelocity < -REST_THRESH) ? c.Restitution : 0.0f;
+    float dv = std::max(-e * c.NormalVelocity, 0.0f) - vn;
+    float w = GeneralizedInverseMass(S, a, rA, n) + GeneralizedInverseMass(S, b, rB, n);
+    if (w < 1e-10f) return;
+    glm::vec3 p = n * (dv / w);
+    ApplyVelocityImpulse(S, a, rA, -p);
+    ApplyVelocityImpulse(S, b, rB, p);
+}
+
+// Stops the sliding the velocities still show with whatever friction the
+// position passes left unused, so a pass that fell short of holding the
+// bodies does not leave them drifting.
+inline void SolveVelocityFriction(BodyStore& S, const PositionContact* rows, uint32_t count, float dt) {
+    const PositionContact& c = rows[0];
+    const uint32_t a = c.BodyA, b = c.BodyB;
+    const glm::vec3& n = c.Normal;
+    glm::vec3 localA, localB;
+    float budget = (c.Friction * PatchCentre(rows, count, localA, localB) - c.LambdaT) / dt;
+    if (budget <= 0.0f) return;
+    glm::vec3 pA = S.LocalToWorld(a, localA), pB = S.LocalToWorld(b, localB);
+    glm::vec3 v = S.VelocityAt(b, pB) - S.VelocityAt(a, pA);
+    glm::vec3 vt = v - n * glm::dot(v, n);
+    float len = glm::length(vt);
+    if (len < 1e-7f) return;
+    glm::vec3 t = vt / len;
+    glm::vec3 rA = pA - S.Position[a], rB = pB - S.Position[b];
+    float wt = GeneralizedInverseMass(S, a, rA, t) + GeneralizedInverseMass(S, b, rB, t);
+    if (wt < 1e-10f) return;
+    glm::vec3 p = t * std::min(len / wt, budget);
+    ApplyVelocityImpulse(S, a, rA, p);
+    ApplyVelocityImpulse(S, b, rB, -p);
+}
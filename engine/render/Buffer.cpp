@@ -54,6 +54,12 @@ void VertexBuffer::SetData(const void* data, uint32_t size)
     glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
 }
 
+void VertexBuffer::GetData(void* data, uint32_t size) const
+{
+    glBindBuffer(GL_COPY_READ_BUFFER, m_RendererID);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, data);
+}
+
 std::shared_ptr<VertexBuffer> VertexBuffer::Create(uint32_t size)
 {
     return std::make_shared<VertexBuffer>(size);
@@ -87,6 +93,14 @@ void IndexBuffer::Unbind() const
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+// Reads through GL_COPY_READ_BUFFER so the bound vertex array keeps its
+// element buffer.
+void IndexBuffer::GetData(uint32_t* indices) const
+{
+    glBindBuffer(GL_COPY_READ_BUFFER, m_RendererID);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, m_Count * sizeof(uint32_t), indices);
+}
+
 std::shared_ptr<IndexBuffer> IndexBuffer::Create(const uint32_t* indices, uint32_t count)
 {
     return std::make_shared<IndexBuffer>(indices, count);
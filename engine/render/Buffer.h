@@ -97,6 +97,8 @@ public:
     void Unbind() const;
 
     void SetData(const void* data, uint32_t size);
+    // Reads the first `size` bytes back from the GPU.
+    void GetData(void* data, uint32_t size) const;
 
     const BufferLayout& GetLayout() const { return m_Layout; }
     void SetLayout(const BufferLayout& layout) { m_Layout = layout; }
@@ -120,6 +122,8 @@ public:
     void Unbind() const;
 
     uint32_t GetCount() const { return m_Count; }
+    // Reads all GetCount() indices back from the GPU.
+    void GetData(uint32_t* indices) const;
 
     static std::shared_ptr<IndexBuffer> Create(const uint32_t* indices, uint32_t count);
 
@@ -5,6 +5,8 @@
 #include "stb_image.h"
 #include <iostream>
 
+#include "physics/ConvexHullShape.h"
+
 Texture::Texture(const std::filesystem::path& path, bool flipVertically)
     : m_Path(path)
 {
@@ -228,6 +230,16 @@ void Texture::Unbind() const
 //     m_Geometry->Unbind();
 // }
 
+const std::vector<glm::vec3>& MeshAsset::GetHullVertices() const
+{
+    if (!m_HullComputed)
+    {
+        m_HullVertices = ConvexHullShape::ComputeHullVertices(MeshData->ReadPositions());
+        m_HullComputed = true;
+    }
+    return m_HullVertices;
+}
+
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
 {
     m_VertexArray = VertexArray::Create();
@@ -253,6 +265,26 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& ind
     }
 
     m_LocalAABB = aabb;
+    m_VertexCount = static_cast<uint32_t>(vertices.size());
+}
+
+std::vector<glm::vec3> Mesh::ReadPositions() const
+{
+    std::vector<Vertex> vertices(m_VertexCount);
+    m_VertexBuffer->GetData(vertices.data(), static_cast<uint32_t>(vertices.size() * sizeof(Vertex)));
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices.size());
+    for (const auto& v : vertices)
+        positions.push_back(v.Position);
+    return positions;
+}
+
+std::vector<uint32_t> Mesh::ReadIndices() const
+{
+    std::vector<uint32_t> indices(m_IndexBuffer->GetCount());
+    m_IndexBuffer->GetData(indices.data());
+    return indices;
 }
 
 void Mesh::Bind() const
@@ -33,6 +33,14 @@ public:
     virtual AssetType GetType() const override { return AssetType::Mesh; }
 
     std::shared_ptr<Mesh> MeshData;
+
+    // Corners of the convex hull, for convex colliders. Computed the first
+    // time a collider asks, so meshes no convex collider uses never pay for it.
+    const std::vector<glm::vec3>& GetHullVertices() const;
+
+private:
+    mutable std::vector<glm::vec3> m_HullVertices;
+    mutable bool m_HullComputed = false;
 };
 
 class MaterialAsset : public Asset
@@ -302,6 +310,10 @@ public:
     void DrawLines() const;
 
     const AABB& GetLocalAABB() const { return m_LocalAABB; }
+    // Geometry read back from the GPU buffers, for building colliders. Only
+    // collider meshes need it, so no CPU copy is kept.
+    std::vector<glm::vec3> ReadPositions() const;
+    std::vector<uint32_t> ReadIndices() const;
     static std::shared_ptr<Mesh> Generate(MeshPrimitive primitive);
 
 private:
@@ -313,4 +325,5 @@ private:
     std::shared_ptr<VertexBuffer> m_VertexBuffer;
     std::shared_ptr<IndexBuffer> m_IndexBuffer;
     AABB m_LocalAABB;
+    uint32_t m_VertexCount = 0;
 };
\ No newline at end of file
@@ -113,6 +113,37 @@ static std::shared_ptr<Mesh> CreateWireSphere(int segments = 32)
     return std::make_shared<Mesh>(vertices, indices);
 }
 
+// Unit radius cylinder along Y from -1 to 1: the two end rings and a few
+// lines joining them.
+static std::shared_ptr<Mesh> CreateWireCylinder(int segments = 32)
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    for (float y : { -1.0f, 1.0f })
+    {
+        uint32_t first = (uint32_t)vertices.size();
+
+        for (int i = 0; i < segments; i++)
+        {
+            float theta = (float)i / segments * glm::two_pi<float>();
+
+            vertices.push_back({ { cos(theta), y, sin(theta) }, {}, {} });
+
+            indices.push_back(first + i);
+            indices.push_back(first + (i + 1) % segments);
+        }
+    }
+
+    for (int i = 0; i < segments; i += segments / 8)
+    {
+        indices.push_back(i);
+        indices.push_back(segments + i);
+    }
+
+    return std::make_shared<Mesh>(vertices, indices);
+}
+
 static std::shared_ptr<Mesh> CreateDebugLine()
 {
     std::vector<Vertex> v =
@@ -172,6 +203,7 @@ void Renderer::Init(const RenderTarget& target)
 
     m_DebugCube = CreateWireCube();
     m_DebugSphere = CreateWireSphere();
+    m_DebugCylinder = CreateWireCylinder();
 
     m_DebugLine = CreateDebugLine();
     m_DebugAnchorSphere = CreateWireSphere(16);
@@ -538,43 +570,55 @@ void Renderer::RenderColliders(Scene& scene)
     m_GizmoShader->SetMat4f("u_View", m_Frame.View);
     m_GizmoShader->SetMat4f("u_Projection", m_Frame.Projection);
 
-    constexpr float offset = 1.005f;
-
     auto& registry = scene.GetRegistry();
 
     {
         auto view = registry.view<TransformComponent, BoxColliderComponent>();
 
         for (auto [entity, transform, box] : view.each())
-        {
-            glm::mat4 model =
-                glm::translate(glm::mat4(1.0f), transform.Translation) *
-                glm::mat4_cast(transform.Rotation) *
-                glm::scale(glm::mat4(1.0f),
-                    box.HalfExtents * offset);
-
-            m_GizmoShader->SetVec3f("u_Color", { 0.0f, 1.0f, 0.0f });
-            m_GizmoShader->SetMat4f("u_Model", model);
-
-            m_DebugCube->DrawLines();
-        }
+            DrawColliderPrimitive(ColliderType::Box, transform.Translation, transform.Rotation, box.HalfExtents);
     }
 
     {
         auto view = registry.view<TransformComponent, SphereColliderComponent>();
 
         for (auto [entity, transform, sphere] : view.each())
+            DrawColliderPrimitive(ColliderType::Sphere, transform.Translation, transform.Rotation, glm::vec3(sphere.Radius));
+    }
+
+    {
+        auto view = registry.view<TransformComponent, CapsuleColliderComponent>();
+
+        for (auto [entity, transform, capsule] : view.each())
+            DrawColliderPrimitive(ColliderType::Capsule, transform.Translation, transform.Rotation,
+                { capsule.Radius, capsule.HalfHeight, capsule.Radius });
+    }
+
+    {
+        auto view = registry.view<TransformComponent, CylinderColliderComponent>();
+
+        for (auto [entity, transform, cylinder] : view.each())
+            DrawColliderPrimitive(ColliderType::Cylinder, transform.Translation, transform.Rotation,
+                { cylinder.Radius, cylinder.HalfHeight, cylinder.Radius });
+    }
+
+    {
+        // Compound children as the primitives above, placed in the entity's frame.
+        auto view = registry.view<TransformComponent, CompoundColliderComponent>();
+
+        for (auto [entity, transform, compound] : view.each())
         {
-            glm::mat4 model =
-                glm::translate(glm::mat4(1.0f), transform.Translation) *
-                glm::mat4_cast(transform.Rotation) *
-                glm::scale(glm::mat4(1.0f),
-                    glm::vec3(sphere.Radius) * offset);
+            for (auto& child : compound.Children)
+            {
+                glm::vec3 center = transform.Translation + transform.Rotation * child.Translation;
+                glm::quat rotation = transform.Rotation * child.Rotation;
 
-            m_GizmoShader->SetVec3f("u_Color", { 0.2f, 0.8f, 1.0f });
-            m_GizmoShader->SetMat4f("u_Model", model);
+                glm::vec3 dims = child.Type == ColliderType::Box
+                    ? child.HalfExtents
+                    : glm::vec3(child.Radius, child.HalfHeight, child.Radius);
 
-            m_DebugSphere->DrawLines();
+                DrawColliderPrimitive(child.Type, center, rotation, dims);
+            }
         }
     }
 
@@ -583,6 +627,46 @@ void Renderer::RenderColliders(Scene& scene)
     glDisable(GL_BLEND);
 }
 
+// `dims` holds a box's half extents, or radius, half height and radius for
+// the round shapes. Capsules are drawn as the spheres at the ends of their
+// core; convex hulls have no primitive to draw.
+void Renderer::DrawColliderPrimitive(ColliderType type, const glm::vec3& center, const glm::quat& rotation, const glm::vec3& dims)
+{
+    constexpr float offset = 1.005f;
+
+    auto draw = [&](const std::shared_ptr<Mesh>& mesh, const glm::vec3& position, const glm::vec3& scale, const glm::vec3& color)
+    {
+        glm::mat4 model =
+            glm::translate(glm::mat4(1.0f), position) *
+            glm::mat4_cast(rotation) *
+            glm::scale(glm::mat4(1.0f), scale * offset);
+
+        m_GizmoShader->SetVec3f("u_Color", color);
+        m_GizmoShader->SetMat4f("u_Model", model);
+
+        mesh->DrawLines();
+    };
+
+    switch (type)
+    {
+    case ColliderType::Box:
+        draw(m_DebugCube, center, dims, { 0.0f, 1.0f, 0.0f });
+        break;
+    case ColliderType::Sphere:
+        draw(m_DebugSphere, center, glm::vec3(dims.x), { 0.2f, 0.8f, 1.0f });
+        break;
+    case ColliderType::Capsule:
+        for (float end : { -dims.y, dims.y })
+            draw(m_DebugSphere, center + rotation * glm::vec3(0.0f, end, 0.0f), glm::vec3(dims.x), { 0.2f, 0.8f, 1.0f });
+        break;
+    case ColliderType::Cylinder:
+        draw(m_DebugCylinder, center, dims, { 0.2f, 0.8f, 1.0f });
+        break;
+    default:
+        break;
+    }
+}
+
 void Renderer::RenderDistanceJoints(Scene& scene)
 {
     auto& registry = scene.GetRegistry();
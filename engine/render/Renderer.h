@@ -42,6 +42,7 @@ private:
     std::shared_ptr<Mesh> CreateAxisMesh(float length);
     void RenderGrid();
     void RenderColliders(Scene& scene);
+    void DrawColliderPrimitive(ColliderType type, const glm::vec3& center, const glm::quat& rotation, const glm::vec3& dims);
     void RenderDistanceJoints(Scene& scene);
 
 private:
@@ -75,6 +76,7 @@ private:
 
     std::shared_ptr<Mesh> m_DebugCube;
     std::shared_ptr<Mesh> m_DebugSphere;
+    std::shared_ptr<Mesh> m_DebugCylinder;
 
     std::shared_ptr<Mesh> m_DebugLine;
     std::shared_ptr<Mesh> m_DebugAnchorSphere;
@@ -0,0 +1,43 @@
+#include "physics/PhysicsWorld.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// Once a scene has warmed up, stepping it must not touch the heap: the
+// pair, manifold and cache storage only grows, and the narrowphase keeps
+// its manifolds inline.
+static bool StepsWithoutAllocating(uint32_t workerThreads) {
+    PhysicsWorld world;
+    world.EnableSleeping = false;   // keep every body in the step
+    world.WorkerThreads = workerThreads;
+
+    BoxShape ground(glm::vec3(20.0f, 0.5f, 20.0f));
+    BoxShape box(glm::vec3(0.5f));
+    SphereShape ball(0.4f);
+    world.CreateBody(glm::vec3(0.0f, -0.5f, 0.0f), &ground, BodyType::Static, 0.0f);
+    for (int x = 0; x < 4; ++x)
+        for (int y = 0; y < 8; ++y)
+            world.CreateBody(glm::vec3(x * 2.0f, 0.5f + y, 0.0f), &box);
+    for (int x = 0; x < 4; ++x)
+        world.CreateBody(glm::vec3(x * 2.0f, 0.4f, 3.0f), &ball);
+
+    const float dt = 1.0f / 60.0f;
+    for (int s = 0; s < 120; ++s) world.Step(dt);
+
+    for (int s = 0; s < 120; ++s) {
+        world.Step(dt);
+        if (world.GetStepAllocationCount() != 0) {
+            std::fprintf(stderr, "StepAllocationTest: %llu allocations in step %d with %u worker threads\n",
+                (unsigned long long)world.GetStepAllocationCount(), 120 + s, workerThreads);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    static_assert(AllocationCounter::Enabled, "build with PHYSIM_COUNT_ALLOCATIONS");
+    bool ok = StepsWithoutAllocating(0);
+    ok = StepsWithoutAllocating(3) && ok;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}